@@ -0,0 +1,77 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestDefinition.h"
+#include "QuestObject.h"
+#include "QuestObjective.h"
+#include "QuestReward.h"
+#include "UObject/ObjectInstancingGraph.h"
+
+TSharedRef<FQuestDefinition> FQuestDefinition::Compile(TSubclassOf<UQuestObject> QuestClass)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FQuestDefinition::Compile)
+
+	TSharedRef<FQuestDefinition> Definition = MakeShared<FQuestDefinition>();
+	Definition->QuestClass = QuestClass;
+	if (!QuestClass) return Definition;
+
+	const UQuestObject* QuestCDO = QuestClass->GetDefaultObject<UQuestObject>();
+	Definition->bSharesRewards = QuestCDO->bShareRewards;
+	if (!Definition->bSharesRewards) return Definition;
+
+	for (UQuestReward* Reward : QuestCDO->QuestRewards)
+	{
+		if (Reward) Definition->Rewards.Add(Reward);
+	}
+
+	//Empty slots keep their entry, objectives are matched by index
+	Definition->Objectives.SetNum(QuestCDO->QuestObjectives.Num());
+	for (int32 i = 0; i < QuestCDO->QuestObjectives.Num(); i++)
+	{
+		const UQuestObjective* Objective = QuestCDO->QuestObjectives[i];
+		if (!Objective) continue;
+		
+		for (UQuestReward* Reward : Objective->ObjectiveRewards)
+		{
+			if (Reward) Definition->Objectives[i].Rewards.Add(Reward);
+		}
+	}
+
+	return Definition;
+}
+
+void FQuestDefinition::AddSharedSubobjects(FObjectInstancingGraph& InstancingGraph) const
+{
+	//Not AddNewObject, the first object added that way becomes the destination root
+	for (UQuestReward* Reward : Rewards)
+	{
+		InstancingGraph.AddNewInstance(Reward, Reward);
+	}
+
+	for (const FQuestObjectiveDefinition& Objective : Objectives)
+	{
+		for (UQuestReward* Reward : Objective.Rewards)
+		{
+			InstancingGraph.AddNewInstance(Reward, Reward);
+		}
+	}
+}
+
+void FQuestDefinition::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Collector.AddReferencedObjects(Rewards);
+	for (FQuestObjectiveDefinition& Objective : Objectives)
+	{
+		Collector.AddReferencedObjects(Objective.Rewards);
+	}
+}
+
+SIZE_T FQuestDefinition::GetAllocatedSize() const
+{
+	SIZE_T Size = Rewards.GetAllocatedSize() + Objectives.GetAllocatedSize();
+	for (const FQuestObjectiveDefinition& Objective : Objectives)
+	{
+		Size += Objective.Rewards.GetAllocatedSize();
+	}
+	return Size;
+}
@@ -0,0 +1,105 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestDelta.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+FArchive& operator<<(FArchive& Ar, FQuestDeltaVersion& Version)
+{
+	Ar.SerializeIntPacked(Version.Epoch);
+	Ar.SerializeIntPacked(Version.Sequence);
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FQuestDelta& Delta)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FQuestDelta::Serialize)
+
+	uint32 Magic = FQuestDelta::Magic;
+	int32 Version = static_cast<int32>(EQuestSaveVersion::Latest);
+	Ar << Magic;
+	Ar << Version;
+	if (Magic != FQuestDelta::Magic || Version < static_cast<int32>(EQuestSaveVersion::Initial)
+		|| Version > static_cast<int32>(EQuestSaveVersion::Latest))
+	{
+		Ar.SetError();
+		return Ar;
+	}
+
+	Ar << Delta.Base;
+	Ar << Delta.Version;
+	Ar << Delta.bFullState;
+	Ar << Delta.QuestClasses;
+	Ar << Delta.Changes;
+	return Ar;
+}
+
+bool FQuestDelta::ToBytes(TArray<uint8>& OutData)
+{
+	FMemoryWriter Writer(OutData, true);
+	Writer << *this;
+	return !Writer.IsError();
+}
+
+bool FQuestDelta::FromBytes(const TArray<uint8>& Data)
+{
+	FMemoryReader Reader(Data, true);
+	Reader << *this;
+	return !Reader.IsError();
+}
+
+EQuestDeltaResult FQuestDeltaMirror::Apply(const FQuestDelta& Delta)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FQuestDeltaMirror::Apply)
+
+	FOwner& Owner = Owners.FindOrAdd(Delta.Changes.Owner);
+	const bool bSameEpoch = Owner.Version.Epoch == Delta.Version.Epoch;
+	if (bSameEpoch && Delta.Version.Sequence <= Owner.Version.Sequence) return EQuestDeltaResult::AlreadyApplied;
+
+	if (Delta.bFullState)
+	{
+		Owner.Quests.Reset();
+	}
+	else if (!bSameEpoch || Delta.Base.Sequence > Owner.Version.Sequence)
+	{
+		return EQuestDeltaResult::MissingBase;
+	}
+
+	for (const FQuestSaveRecord& Record : Delta.Changes.Quests)
+	{
+		if (!Delta.QuestClasses.IsValidIndex(Record.ClassIndex)) continue;
+		
+		const FString& QuestClass = Delta.QuestClasses[Record.ClassIndex];
+		if (Record.Status == EQuestStatus::INVALID)
+		{
+			Owner.Quests.Remove(QuestClass);
+		}
+		else
+		{
+			FQuestSaveRecord& MirroredRecord = Owner.Quests.Add(QuestClass, Record);
+			MirroredRecord.ClassIndex = INDEX_NONE;
+		}
+	}
+
+	Owner.Version = Delta.Version;
+	return EQuestDeltaResult::Applied;
+}
+
+FQuestDeltaVersion FQuestDeltaMirror::GetVersion(const FString& Owner) const
+{
+	const FOwner* MirroredOwner = Owners.Find(Owner);
+	return MirroredOwner ? MirroredOwner->Version : FQuestDeltaVersion();
+}
+
+const FQuestSaveRecord* FQuestDeltaMirror::FindQuest(const FString& Owner, const FString& QuestClassPath) const
+{
+	const FOwner* MirroredOwner = Owners.Find(Owner);
+	return MirroredOwner ? MirroredOwner->Quests.Find(QuestClassPath) : nullptr;
+}
+
+EQuestStatus FQuestDeltaMirror::GetQuestStatus(const FString& Owner, const UClass* QuestClass) const
+{
+	const FQuestSaveRecord* Record = QuestClass ? FindQuest(Owner, QuestClass->GetPathName()) : nullptr;
+	return Record ? Record->Status : EQuestStatus::INVALID;
+}
@@ -0,0 +1,44 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestLog.h"
+#include "QuestSubsystem.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY(LogQuestSystem);
+
+#if QUEST_DIAGNOSTICS
+bool QuestDiagnostics::bOnScreen = false;
+
+static FAutoConsoleVariableRef CVarQuestDiagnosticsOnScreen(
+	TEXT("QuestSystem.Debug.OnScreen"),
+	QuestDiagnostics::bOnScreen,
+	TEXT("Mirrors active LogQuestSystem diagnostics to the screen. Raise the verbosity with \"Log LogQuestSystem Verbose\" to see lookups."));
+
+void QuestDiagnostics::AddOnScreenMessage(ELogVerbosity::Type Verbosity, const FString& Message)
+{
+	if (!GEngine || !IsInGameThread()) return;
+
+	const FColor Color = Verbosity <= ELogVerbosity::Error ? FColor::Red : Verbosity == ELogVerbosity::Warning ? FColor::Yellow : FColor::Cyan;
+	GEngine->AddOnScreenDebugMessage(INDEX_NONE, 5.f, Color, Message);
+}
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice QuestDumpCommand(
+	TEXT("QuestSystem.Debug.DumpQuests"),
+	TEXT("Lists the quests and their status of every owner in the quest subsystem of the world. Pass an owner name to only list that owner."),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		const UQuestSubsystem* QuestSubsystem = GameInstance ? GameInstance->GetSubsystem<UQuestSubsystem>() : nullptr;
+		if (!QuestSubsystem)
+		{
+			Ar.Log(TEXT("No quest subsystem in this world"));
+			return;
+		}
+		
+		QuestSubsystem->DumpQuests(Ar, Args.Num() > 0 ? Args[0] : FString());
+	}));
+#endif
@@ -0,0 +1,265 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestMappedSnapshot.h"
+#include "Algo/BinarySearch.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+static_assert(sizeof(FQuestMappedSnapshot::FQuest) == 24, "FQuest is part of the file layout");
+static_assert(sizeof(FQuestMappedSnapshot::FClassOwner) == 8, "FClassOwner is part of the file layout");
+
+namespace QuestMappedSnapshot
+{
+	template <typename T>
+	void Append(TArray<uint8>& OutData, const T* Elements, int32 Num)
+	{
+		OutData.Append(reinterpret_cast<const uint8*>(Elements), Num * sizeof(T));
+	}
+
+	//Keeps every table 8 byte aligned so the mapped tables can be read in place
+	uint64 AlignTable(TArray<uint8>& OutData)
+	{
+		OutData.SetNumZeroed(::Align(OutData.Num(), 8));
+		return OutData.Num();
+	}
+
+	FQuestMappedSnapshot::FStringRef AddString(TArray<uint8>& Strings, const FString& String)
+	{
+		const FTCHARToUTF8 Converted(*String);
+		FQuestMappedSnapshot::FStringRef Ref;
+		Ref.Offset = Strings.Num();
+		Ref.Length = Converted.Length();
+		Strings.Append(reinterpret_cast<const uint8*>(Converted.Get()), Converted.Length());
+		return Ref;
+	}
+}
+
+FQuestMappedSnapshot::FQuestMappedSnapshot()
+{
+}
+
+FQuestMappedSnapshot::~FQuestMappedSnapshot()
+{
+	//The region has to go before the file it maps
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+void FQuestMappedSnapshot::Write(const FQuestSaveSnapshot& Snapshot, TArray<uint8>& OutData)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FQuestMappedSnapshot::Write)
+
+	TArray<FOwner> OwnerTable;
+	TArray<FClass> ClassTable;
+	TArray<FQuest> QuestTable;
+	TArray<FClassOwner> ClassOwnerTable;
+	TArray<uint8> Strings;
+	TArray<uint8> Records;
+
+	OwnerTable.Reserve(Snapshot.Owners.Num());
+	
+	//Class index -> (owner index, quest index), turned into the class owner table afterwards
+	TArray<TArray<FClassOwner>> OwnersPerClass;
+	OwnersPerClass.SetNum(Snapshot.QuestClasses.Num());
+
+	TArray<const FQuestSaveRecord*> SortedQuests;
+	for (const FQuestOwnerSaveRecord& OwnerRecord : Snapshot.Owners)
+	{
+		SortedQuests.Reset();
+		for (const FQuestSaveRecord& QuestRecord : OwnerRecord.Quests)
+		{
+			if (QuestRecord.Status == EQuestStatus::INVALID || !OwnersPerClass.IsValidIndex(QuestRecord.ClassIndex)) continue;
+			SortedQuests.Add(&QuestRecord);
+		}
+		SortedQuests.Sort([](const FQuestSaveRecord& A, const FQuestSaveRecord& B) { return A.ClassIndex < B.ClassIndex; });
+
+		FOwner& Owner = OwnerTable.AddDefaulted_GetRef();
+		Owner.Name = QuestMappedSnapshot::AddString(Strings, OwnerRecord.Owner);
+		Owner.FirstQuest = QuestTable.Num();
+		Owner.NumQuests = SortedQuests.Num();
+
+		for (const FQuestSaveRecord* QuestRecord : SortedQuests)
+		{
+			FQuest& Quest = QuestTable.AddDefaulted_GetRef();
+			Quest.ClassIndex = QuestRecord->ClassIndex;
+			Quest.Status = static_cast<uint8>(QuestRecord->Status);
+
+			//Only quests with an object have anything beyond the status
+			if (QuestRecord->SaveGameData.Num() > 0 || QuestRecord->Objectives.Num() > 0)
+			{
+				Quest.RecordOffset = Records.Num();
+				FMemoryWriter Writer(Records, true, true);
+				Writer << const_cast<FQuestSaveRecord&>(*QuestRecord);
+				Quest.RecordSize = Records.Num() - Quest.RecordOffset;
+			}
+
+			OwnersPerClass[QuestRecord->ClassIndex].Add({static_cast<uint32>(OwnerTable.Num() - 1), static_cast<uint32>(QuestTable.Num() - 1)});
+		}
+	}
+
+	ClassTable.Reserve(Snapshot.QuestClasses.Num());
+	for (int32 ClassIndex = 0; ClassIndex < Snapshot.QuestClasses.Num(); ClassIndex++)
+	{
+		FClass& Class = ClassTable.AddDefaulted_GetRef();
+		Class.Path = QuestMappedSnapshot::AddString(Strings, Snapshot.QuestClasses[ClassIndex]);
+		Class.FirstOwner = ClassOwnerTable.Num();
+		Class.NumOwners = OwnersPerClass[ClassIndex].Num();
+		ClassOwnerTable.Append(OwnersPerClass[ClassIndex]);
+	}
+
+	FHeader Header;
+	Header.Magic = Magic;
+	Header.Version = static_cast<int32>(EQuestSaveVersion::Latest);
+	Header.NumOwners = OwnerTable.Num();
+	Header.NumClasses = ClassTable.Num();
+	Header.NumQuests = QuestTable.Num();
+	Header.NumClassOwners = ClassOwnerTable.Num();
+
+	OutData.Reset();
+	OutData.SetNumZeroed(sizeof(FHeader));
+	
+	Header.OwnersOffset = QuestMappedSnapshot::AlignTable(OutData);
+	QuestMappedSnapshot::Append(OutData, OwnerTable.GetData(), OwnerTable.Num());
+	Header.ClassesOffset = QuestMappedSnapshot::AlignTable(OutData);
+	QuestMappedSnapshot::Append(OutData, ClassTable.GetData(), ClassTable.Num());
+	Header.QuestsOffset = QuestMappedSnapshot::AlignTable(OutData);
+	QuestMappedSnapshot::Append(OutData, QuestTable.GetData(), QuestTable.Num());
+	Header.ClassOwnersOffset = QuestMappedSnapshot::AlignTable(OutData);
+	QuestMappedSnapshot::Append(OutData, ClassOwnerTable.GetData(), ClassOwnerTable.Num());
+	Header.StringsOffset = QuestMappedSnapshot::AlignTable(OutData);
+	Header.StringsSize = Strings.Num();
+	OutData.Append(Strings);
+	Header.RecordsOffset = QuestMappedSnapshot::AlignTable(OutData);
+	Header.RecordsSize = Records.Num();
+	OutData.Append(Records);
+
+	FMemory::Memcpy(OutData.GetData(), &Header, sizeof(FHeader));
+}
+
+TUniquePtr<FQuestMappedSnapshot> FQuestMappedSnapshot::Open(const FString& FilePath)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FQuestMappedSnapshot::Open)
+	
+	TUniquePtr<FQuestMappedSnapshot> Snapshot(new FQuestMappedSnapshot());
+	
+	Snapshot->MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FilePath));
+	if (Snapshot->MappedFile)
+	{
+		Snapshot->MappedRegion.Reset(Snapshot->MappedFile->MapRegion());
+	}
+
+	if (Snapshot->MappedRegion)
+	{
+		Snapshot->Data = Snapshot->MappedRegion->GetMappedPtr();
+		Snapshot->Size = Snapshot->MappedRegion->GetMappedSize();
+	}
+	else
+	{
+		Snapshot->MappedFile.Reset();
+		if (!FFileHelper::LoadFileToArray(Snapshot->LoadedData, *FilePath, FILEREAD_Silent)) return nullptr;
+		
+		Snapshot->Data = Snapshot->LoadedData.GetData();
+		Snapshot->Size = Snapshot->LoadedData.Num();
+	}
+
+	if (!Snapshot->InitializeTables()) return nullptr;
+
+	return Snapshot;
+}
+
+bool FQuestMappedSnapshot::InitializeTables()
+{
+	if (!Data || Size < static_cast<int64>(sizeof(FHeader))) return false;
+
+	const FHeader* FileHeader = reinterpret_cast<const FHeader*>(Data);
+	if (FileHeader->Magic != Magic || FileHeader->Version < static_cast<int32>(EQuestSaveVersion::Initial)
+		|| FileHeader->Version > static_cast<int32>(EQuestSaveVersion::Latest))
+	{
+		return false;
+	}
+
+	auto FitsTable = [this](uint64 Offset, uint64 Num, uint64 ElementSize)
+	{
+		return Offset % 8 == 0 && Offset <= static_cast<uint64>(Size) && Num <= (Size - Offset) / ElementSize;
+	};
+
+	const bool bValid = FitsTable(FileHeader->OwnersOffset, FileHeader->NumOwners, sizeof(FOwner))
+		&& FitsTable(FileHeader->ClassesOffset, FileHeader->NumClasses, sizeof(FClass))
+		&& FitsTable(FileHeader->QuestsOffset, FileHeader->NumQuests, sizeof(FQuest))
+		&& FitsTable(FileHeader->ClassOwnersOffset, FileHeader->NumClassOwners, sizeof(FClassOwner))
+		&& FitsTable(FileHeader->StringsOffset, FileHeader->StringsSize, 1)
+		&& FitsTable(FileHeader->RecordsOffset, FileHeader->RecordsSize, 1);
+	if (!bValid) return false;
+
+	Header = FileHeader;
+	Owners = reinterpret_cast<const FOwner*>(Data + Header->OwnersOffset);
+	Classes = reinterpret_cast<const FClass*>(Data + Header->ClassesOffset);
+	Quests = reinterpret_cast<const FQuest*>(Data + Header->QuestsOffset);
+	ClassOwners = reinterpret_cast<const FClassOwner*>(Data + Header->ClassOwnersOffset);
+	return true;
+}
+
+FString FQuestMappedSnapshot::GetOwnerName(int32 OwnerIndex) const
+{
+	return ReadString(Owners[OwnerIndex].Name);
+}
+
+FString FQuestMappedSnapshot::GetClassPath(int32 ClassIndex) const
+{
+	return ReadString(Classes[ClassIndex].Path);
+}
+
+TConstArrayView<FQuestMappedSnapshot::FQuest> FQuestMappedSnapshot::GetOwnerQuests(int32 OwnerIndex) const
+{
+	const FOwner& Owner = Owners[OwnerIndex];
+	if (static_cast<uint64>(Owner.FirstQuest) + Owner.NumQuests > Header->NumQuests) return {};
+	
+	return MakeArrayView(Quests + Owner.FirstQuest, Owner.NumQuests);
+}
+
+const FQuestMappedSnapshot::FQuest* FQuestMappedSnapshot::FindQuest(int32 OwnerIndex, int32 ClassIndex) const
+{
+	const TConstArrayView<FQuest> OwnerQuests = GetOwnerQuests(OwnerIndex);
+	const int32 Index = Algo::LowerBoundBy(OwnerQuests, static_cast<uint32>(ClassIndex), &FQuest::ClassIndex);
+	
+	return OwnerQuests.IsValidIndex(Index) && OwnerQuests[Index].ClassIndex == static_cast<uint32>(ClassIndex) ? &OwnerQuests[Index] : nullptr;
+}
+
+TConstArrayView<FQuestMappedSnapshot::FClassOwner> FQuestMappedSnapshot::GetClassOwners(int32 ClassIndex) const
+{
+	const FClass& Class = Classes[ClassIndex];
+	if (static_cast<uint64>(Class.FirstOwner) + Class.NumOwners > Header->NumClassOwners) return {};
+	
+	return MakeArrayView(ClassOwners + Class.FirstOwner, Class.NumOwners);
+}
+
+bool FQuestMappedSnapshot::ReadQuest(const FQuest& Quest, FQuestSaveRecord& OutRecord) const
+{
+	OutRecord = FQuestSaveRecord();
+	
+	if (Quest.RecordSize > 0)
+	{
+		if (Quest.RecordOffset + Quest.RecordSize > Header->RecordsSize) return false;
+
+		//Reads straight from the mapped memory
+		FMemoryReaderView Reader(MakeArrayView(Data + Header->RecordsOffset + Quest.RecordOffset, Quest.RecordSize), true);
+		Reader << OutRecord;
+		if (Reader.IsError()) return false;
+	}
+	
+	OutRecord.ClassIndex = Quest.ClassIndex;
+	OutRecord.Status = Quest.GetStatus();
+	return true;
+}
+
+FString FQuestMappedSnapshot::ReadString(const FStringRef& String) const
+{
+	if (static_cast<uint64>(String.Offset) + String.Length > Header->StringsSize) return FString();
+	
+	const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Data + Header->StringsOffset + String.Offset), String.Length);
+	return FString(Converted.Length(), Converted.Get());
+}
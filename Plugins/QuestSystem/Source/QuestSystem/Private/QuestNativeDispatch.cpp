@@ -0,0 +1,75 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestNativeDispatch.h"
+#include "QuestObject.h"
+#include "QuestObjective.h"
+#include "QuestReward.h"
+#include "UObject/ObjectKey.h"
+
+namespace QuestNativeDispatch
+{
+	// Class -> bit per EQuestNativeEvent without blueprint override
+	TMap<TObjectKey<UClass>, uint32> NativeEvents;
+
+	TConstArrayView<FName> GetEventNames()
+	{
+		//Same order as EQuestNativeEvent
+		static const FName EventNames[] = {
+			GET_FUNCTION_NAME_CHECKED(UQuestObject, ProgressQuest),
+			GET_FUNCTION_NAME_CHECKED(UQuestObject, ProgressQuestEvent),
+			GET_FUNCTION_NAME_CHECKED(UQuestObject, QuestTick),
+			GET_FUNCTION_NAME_CHECKED(UQuestObjective, AddProgress),
+			GET_FUNCTION_NAME_CHECKED(UQuestObjective, AddProgressEvent),
+			GET_FUNCTION_NAME_CHECKED(UQuestObjective, UpdateStatus),
+			GET_FUNCTION_NAME_CHECKED(UQuestObjective, ForceStatus),
+			GET_FUNCTION_NAME_CHECKED(UQuestObjective, TickObjective),
+			GET_FUNCTION_NAME_CHECKED(UQuestObjective, TryStartObjective),
+			GET_FUNCTION_NAME_CHECKED(UQuestObjective, StartObjective),
+			GET_FUNCTION_NAME_CHECKED(UQuestReward, ClaimReward),
+		};
+		static_assert(static_cast<int32>(UE_ARRAY_COUNT(EventNames)) == static_cast<int32>(EQuestNativeEvent::Count), "Every event needs its function name");
+		
+		return EventNames;
+	}
+
+	uint32 ResolveNativeEvents(const UClass* Class)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuestNativeDispatch::ResolveNativeEvents)
+		
+		uint32 Mask = 0;
+		const TConstArrayView<FName> EventNames = GetEventNames();
+		for (int32 Event = 0; Event < EventNames.Num(); Event++)
+		{
+			//Blueprint overrides are script functions, without one the lookup ends at the native declaration
+			const UFunction* Function = Class->FindFunctionByName(EventNames[Event]);
+			if (Function && Function->HasAnyFunctionFlags(FUNC_Native))
+			{
+				Mask |= 1u << Event;
+			}
+		}
+		return Mask;
+	}
+}
+
+bool QuestNativeDispatch::IsNative(const UObject* Object, EQuestNativeEvent Event)
+{
+	const UClass* Class = Object->GetClass();
+	
+	uint32 Mask = 0;
+	if (const uint32* Found = NativeEvents.Find(Class))
+	{
+		Mask = *Found;
+	}
+	else
+	{
+		Mask = NativeEvents.Add(Class, ResolveNativeEvents(Class));
+	}
+	
+	return (Mask & (1u << static_cast<uint32>(Event))) != 0;
+}
+
+void QuestNativeDispatch::Reset()
+{
+	NativeEvents.Reset();
+}
@@ -3,8 +3,12 @@
 
 #include "QuestObject.h"
 #include "Kismet/GameplayStatics.h"
+#include "QuestNativeDispatch.h"
 #include "QuestProgressionObject.h"
 #include "QuestReward.h"
+#include "QuestStats.h"
+#include "QuestSubsystem.h"
+#include "QuestTransitions.h"
 
 UQuestObject::UQuestObject()
 {
@@ -14,19 +18,25 @@ bool UQuestObject::Initialize_Implementation()
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObject::Initialize);
 
-	if (QuestStatus != EQuestStatus::ACCEPTED) return false;
+	if (!QuestTransitions::CanApply(QuestStatus, EQuestEnterCommand::INITIALIZE)) return false;
 	
 	for (UQuestObjective* Objective : QuestObjectives)
 	{
 		Objective->Initialize(this);
 	}
 
-	for (auto Reward : QuestRewards)
+	RecountObjectives();
+
+	//Shared rewards get their OwningQuest when claimed
+	if (!SharesRewards())
 	{
-		Reward->OwningQuest = this;
+		for (auto Reward : QuestRewards)
+		{
+			Reward->OwningQuest = this;
+		}
 	}
 	
-	QuestStatus = EQuestStatus::STARTING;
+	QuestStatus = QuestTransitions::GetTarget(QuestStatus, EQuestEnterCommand::INITIALIZE);
 
 	return true;
 }
@@ -42,15 +52,73 @@ void UQuestObject::ProgressQuest_Implementation(UQuestProgressionObject* Progres
 	{
 		if (Objective->GetClass() == Progress->ObjectiveToProgress)
 		{
-			Objective->AddProgress(Progress, Consumed);
-			OnQuestProgressUpdatedDelegate.Broadcast(this, QuestObjectives, Progress);
+			QUEST_NATIVE_EVENT(Objective, AddProgress, Progress, Consumed);
+			BroadcastProgressUpdated(Progress);
 			if (Consumed) break;
 		}
 	}
 
 	Progress->ConditionalBeginDestroy(); //now we don't need it anymore
 	
-	TryFinishQuest();
+	TryFinishQuestIfChanged();
+}
+
+bool UQuestObject::ProgressQuestEvent_Implementation(const FQuestProgressEvent& Event)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObject::ProgressQuestEvent);
+	if (QuestStatus != EQuestStatus::IN_PROGRESS) return false;
+	
+	bool Consumed = false;
+	for (UQuestObjective* Objective : QuestObjectives)
+	{
+		if (Objective->GetClass() == Event.ObjectiveToProgress)
+		{
+			QUEST_NATIVE_EVENT(Objective, AddProgressEvent, Event, Consumed);
+			BroadcastProgressUpdated(Event.ProgressionObject);
+			if (Consumed) break;
+		}
+	}
+	
+	TryFinishQuestIfChanged();
+
+	return Consumed;
+}
+
+bool UQuestObject::ApplyProgressEvent(const FQuestProgressEvent& Event)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObject::ApplyProgressEvent);
+	if (QuestStatus != EQuestStatus::IN_PROGRESS) return false;
+	
+	bool Consumed = false;
+	for (UQuestObjective* Objective : QuestObjectives)
+	{
+		if (Objective->GetClass() == Event.ObjectiveToProgress)
+		{
+			QUEST_NATIVE_EVENT(Objective, AddProgressEvent, Event, Consumed);
+			if (Consumed) break;
+		}
+	}
+
+	return Consumed;
+}
+
+void UQuestObject::EndProgressBatch(UQuestProgressionObject* Progress)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObject::EndProgressBatch);
+	if (QuestStatus != EQuestStatus::IN_PROGRESS) return;
+	
+	BroadcastProgressUpdated(Progress);
+	TryFinishQuestIfChanged();
+}
+
+void UQuestObject::BroadcastProgressUpdated(UQuestProgressionObject* Progress)
+{
+	QUEST_SCOPE_CYCLE_COUNTER(Broadcast);
+	OnQuestProgressUpdatedNative.Broadcast(this, QuestObjectives, Progress);
+	if (OnQuestProgressUpdatedDelegate.IsBound())
+	{
+		OnQuestProgressUpdatedDelegate.Broadcast(this, QuestObjectives, Progress);
+	}
 }
 
 void UQuestObject::ClaimRewards()
@@ -62,21 +130,35 @@ void UQuestObject::ClaimRewards()
 		Objective->ClaimRewards();
 	}
 
+	if (SharesRewards())
+	{
+		for (UQuestReward* Reward : Definition->Rewards)
+		{
+			Reward->OwningQuest = this;
+			QUEST_NATIVE_EVENT(Reward, ClaimReward);
+			
+			//Shared rewards live on the class default object and must not keep the quest alive
+			Reward->OwningQuest = nullptr;
+		}
+		return;
+	}
+	
 	for (auto Reward : QuestRewards)
 	{
-		Reward->ClaimReward();
+		Reward->OwningQuest = this;
+		QUEST_NATIVE_EVENT(Reward, ClaimReward);
 	}
 }
 
 bool UQuestObject::AcceptQuest_Implementation()
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObject::AcceptQuest_Implementation);
-	if (QuestStatus != EQuestStatus::UNLOCKED) return false;
+	if (!QuestTransitions::CanApply(QuestStatus, EQuestEnterCommand::ACCEPT)) return false;
 	
-	QuestStatus = EQuestStatus::ACCEPTED;
+	QuestStatus = QuestTransitions::GetTarget(QuestStatus, EQuestEnterCommand::ACCEPT);
 	for (UQuestObjective* Objective : QuestObjectives)
 	{
-		Objective->UpdateStatus(EQuestStatus::ACCEPTED);
+		QUEST_NATIVE_EVENT(Objective, UpdateStatus, EQuestStatus::ACCEPTED);
 	}
 
 	return true;
@@ -86,21 +168,17 @@ EQuestStatus UQuestObject::TryFinishQuest()
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObject::TryFinishQuest);
 	
+	bObjectiveStatusChanged = false;
+
+	//A fatal failure ends the quest right away, QuestFinished fails the objectives that are still running
 	EQuestStatus FinishStatus = EQuestStatus::COMPLETED;
-	for (UQuestObjective* Objective : QuestObjectives)
+	if (FailedObjectives > 0 && HasQuestFailingObjective())
 	{
-		switch (Objective->Status)
-		{
-		case EQuestStatus::COMPLETED:
-			break;
-		case EQuestStatus::FAILED:
-			if (!Objective->FailingObjectiveFailsQuest) continue;
-			FinishStatus = EQuestStatus::FAILED;
-			break;
-		default:
-			FinishStatus = EQuestStatus::INVALID;
-			break;
-		}
+		FinishStatus = EQuestStatus::FAILED;
+	}
+	else if (GetPendingObjectiveCount() > 0)
+	{
+		FinishStatus = EQuestStatus::INVALID;
 	}
 
 	switch (FinishStatus)
@@ -115,6 +193,148 @@ EQuestStatus UQuestObject::TryFinishQuest()
 	return FinishStatus;
 }
 
+bool UQuestObject::ResetForRepeat_Implementation()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObject::ResetForRepeat_Implementation);
+	
+	switch (QuestStatus)
+	{
+	case EQuestStatus::ACCEPTED:
+	case EQuestStatus::STARTING:
+	case EQuestStatus::IN_PROGRESS:
+		return false;
+	default:
+		break;
+	}
+
+	for (UQuestObjective* Objective : QuestObjectives)
+	{
+		if (Objective) Objective->ResetForRepeat();
+	}
+
+	//Quests that were never unlocked stay locked, resetting must not unlock them
+	const EQuestStatus OldStatus = QuestStatus;
+	if (QuestStatus != EQuestStatus::LOCKED && QuestStatus != EQuestStatus::INVALID)
+	{
+		QuestStatus = EQuestStatus::UNLOCKED;
+	}
+	RecountObjectives();
+
+	if (UQuestSubsystem* QuestSubsystem = GetTypedOuter<UQuestSubsystem>())
+	{
+		QuestSubsystem->OnQuestStatusChanged(this, OldStatus);
+	}
+	
+	return true;
+}
+
+void UQuestObject::TryFinishQuestIfChanged()
+{
+	if (!bObjectiveStatusChanged) return;
+	TryFinishQuest();
+}
+
+void UQuestObject::RecountObjectives()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObject::RecountObjectives);
+	
+	CompletedObjectives = 0;
+	FailedObjectives = 0;
+	EmptyObjectiveSlots = 0;
+	
+	for (const UQuestObjective* Objective : QuestObjectives)
+	{
+		if (!Objective)
+		{
+			EmptyObjectiveSlots++;
+			continue;
+		}
+		AdjustObjectiveCounter(Objective->Status, 1);
+	}
+
+	bObjectiveStatusChanged = true;
+}
+
+void UQuestObject::RestoreSavedStatus(EQuestStatus Status)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObject::RestoreSavedStatus);
+	
+	QuestStatus = Status;
+
+	//Every quest past ACCEPTED went through Initialize, which wires the rewards
+	if (Status > EQuestStatus::ACCEPTED && !SharesRewards())
+	{
+		for (UQuestObjective* Objective : QuestObjectives)
+		{
+			if (!Objective) continue;
+			for (UQuestReward* Reward : Objective->ObjectiveRewards)
+			{
+				if (Reward) Reward->OwningQuest = this;
+			}
+		}
+
+		for (UQuestReward* Reward : QuestRewards)
+		{
+			if (Reward) Reward->OwningQuest = this;
+		}
+	}
+
+	RecountObjectives();
+	if (Status == EQuestStatus::IN_PROGRESS) TickWithTickingObjectives();
+}
+
+void UQuestObject::TickWithTickingObjectives()
+{
+	if (ShouldTick) return;
+
+	//Nothing would happen in QuestTick of the others, their objectives tick on their own
+	const bool bUsesQuestTick = !QuestNativeDispatch::IsNative(this, EQuestNativeEvent::QuestTick)
+		|| OnQuestTickDelegate.IsBound() || OnQuestTickNative.IsBound();
+	if (!bUsesQuestTick) return;
+
+	for (const UQuestObjective* Objective : QuestObjectives)
+	{
+		if (Objective && Objective->NeedsTick())
+		{
+			ShouldTick = true;
+			return;
+		}
+	}
+}
+
+void UQuestObject::OnObjectiveStatusChanged(const UQuestObjective* Objective, EQuestStatus OldStatus)
+{
+	if (!Objective || Objective->Status == OldStatus) return;
+	
+	AdjustObjectiveCounter(OldStatus, -1);
+	AdjustObjectiveCounter(Objective->Status, 1);
+	bObjectiveStatusChanged = true;
+}
+
+void UQuestObject::AdjustObjectiveCounter(EQuestStatus Status, int32 Delta)
+{
+	switch (Status)
+	{
+	case EQuestStatus::COMPLETED:
+		CompletedObjectives += Delta;
+		break;
+	case EQuestStatus::FAILED:
+		FailedObjectives += Delta;
+		break;
+	default:
+		break;
+	}
+}
+
+bool UQuestObject::HasQuestFailingObjective() const
+{
+	for (const UQuestObjective* Objective : QuestObjectives)
+	{
+		if (Objective && Objective->Status == EQuestStatus::FAILED && Objective->FailingObjectiveFailsQuest) return true;
+	}
+	return false;
+}
+
 AController* UQuestObject::GetOwningController_Implementation()
 {
 	return UGameplayStatics::GetPlayerController(this, 0);
@@ -134,10 +354,31 @@ TArray<FString> UQuestObject::GetQuestObjectiveDescriptions() const
 	return QuestDescriptions;
 }
 
+TArray<UQuestReward*> UQuestObject::GetQuestRewards() const
+{
+	if (!SharesRewards()) return QuestRewards;
+	
+	TArray<UQuestReward*> Rewards;
+	Rewards.Reserve(Definition->Rewards.Num());
+	for (UQuestReward* Reward : Definition->Rewards)
+	{
+		Rewards.Add(Reward);
+	}
+	return Rewards;
+}
+
+const FQuestObjectiveDefinition* UQuestObject::FindSharedObjective(const UQuestObjective* Objective) const
+{
+	if (!SharesRewards()) return nullptr;
+	
+	const int32 Index = QuestObjectives.IndexOfByKey(Objective);
+	return Definition->Objectives.IsValidIndex(Index) ? &Definition->Objectives[Index] : nullptr;
+}
+
 bool UQuestObject::Unlock_Implementation()
 {
-	if (QuestStatus != EQuestStatus::LOCKED) return false;
-	QuestStatus = EQuestStatus::UNLOCKED;
+	if (!QuestTransitions::CanApply(QuestStatus, EQuestEnterCommand::UNLOCK)) return false;
+	QuestStatus = QuestTransitions::GetTarget(QuestStatus, EQuestEnterCommand::UNLOCK);
 	return true;
 }
 
@@ -157,41 +398,80 @@ void UQuestObject::QuestFinished_Implementation(EQuestStatus Status)
 		{
 			case EQuestStatus::IN_PROGRESS:
 			case EQuestStatus::STARTING:
-				Objective->ForceStatus(Status);
+				QUEST_NATIVE_EVENT(Objective, ForceStatus, Status);
 			default:
 				break;
 		}
 	}
 
+	const EQuestStatus OldStatus = QuestStatus;
 	QuestStatus = Status;
+
+	if (UQuestSubsystem* QuestSubsystem = GetTypedOuter<UQuestSubsystem>())
+	{
+		QuestSubsystem->OnQuestStatusChanged(this, OldStatus);
+	}
 	
-	OnQuestFinishedDelegate.Broadcast(this, Status);
+	QUEST_SCOPE_CYCLE_COUNTER(Broadcast);
+	OnQuestFinishedNative.Broadcast(this, Status);
+	if (OnQuestFinishedDelegate.IsBound())
+	{
+		OnQuestFinishedDelegate.Broadcast(this, Status);
+	}
 }
 
 void UQuestObject::QuestTick_Implementation(float DeltaTime)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObject::QuestTick_Implementation)
-	OnQuestTickDelegate.Broadcast(this, DeltaTime);
+	QUEST_SCOPE_CYCLE_COUNTER(Broadcast);
+	OnQuestTickNative.Broadcast(this, DeltaTime);
+	if (OnQuestTickDelegate.IsBound())
+	{
+		OnQuestTickDelegate.Broadcast(this, DeltaTime);
+	}
+}
+
+void UQuestObject::SetShouldTick(bool bShouldTick)
+{
+	ShouldTick = bShouldTick;
+	
+	UQuestSubsystem* QuestSubsystem = GetTypedOuter<UQuestSubsystem>();
+	if (!QuestSubsystem) return;
+
+	if (ShouldTick && QuestStatus == EQuestStatus::IN_PROGRESS)
+	{
+		QuestSubsystem->QuestTickManager.RegisterQuest(this);
+	}
+	else
+	{
+		QuestSubsystem->QuestTickManager.UnregisterQuest(this);
+	}
+}
+
+void UQuestObject::QuestStarted_Implementation()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObject::QuestStarted_Implementation)
+	QUEST_SCOPE_CYCLE_COUNTER(Broadcast);
+	OnQuestStartedNative.Broadcast(this);
+	if (OnQuestStartedDelegate.IsBound())
+	{
+		OnQuestStartedDelegate.Broadcast(this);
+	}
 }
 
 bool UQuestObject::StartQuest_Implementation()
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObject::StartQuest_Implementation)
 
-	if (QuestStatus != EQuestStatus::STARTING) return false; 
+	if (!QuestTransitions::CanApply(QuestStatus, EQuestEnterCommand::START)) return false; 
 	
 	for (auto Objective : QuestObjectives)
 	{
-		Objective->TryStartObjective(this);
-		
-		if (Objective->NeedsTick())
-		{
-			ShouldTick = true;
-		}
-
+		QUEST_NATIVE_EVENT(Objective, TryStartObjective, this);
 	}
+	TickWithTickingObjectives();
 
-	QuestStatus = EQuestStatus::IN_PROGRESS;
+	QuestStatus = QuestTransitions::GetTarget(QuestStatus, EQuestEnterCommand::START);
 	
 	QuestStarted();
 	
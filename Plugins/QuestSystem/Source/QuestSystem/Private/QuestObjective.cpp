@@ -2,8 +2,11 @@
 
 
 #include "QuestObjective.h"
+#include "QuestNativeDispatch.h"
 #include "QuestObject.h"
 #include "QuestReward.h"
+#include "QuestStats.h"
+#include "QuestSubsystem.h"
 
 
 UQuestObjective::UQuestObjective()
@@ -13,13 +16,18 @@ UQuestObjective::UQuestObjective()
 void UQuestObjective::BroadcastProgress(UQuestProgressionObject* AddedProgress)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObjective::BroadcastProgress)
-	OnProgressUpdatedDelegate.Broadcast(AddedProgress);
+	QUEST_SCOPE_CYCLE_COUNTER(Broadcast);
+	OnProgressUpdatedNative.Broadcast(AddedProgress);
+	if (OnProgressUpdatedDelegate.IsBound())
+	{
+		OnProgressUpdatedDelegate.Broadcast(AddedProgress);
+	}
 }
 
 bool UQuestObjective::TryStartObjective_Implementation(UQuestObject* Quest)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObjective::TryStartObjective_Implementation)
-	StartObjective(Quest);
+	QUEST_NATIVE_EVENT(this, StartObjective, Quest);
 	return Status == EQuestStatus::IN_PROGRESS;
 }
 
@@ -34,15 +42,44 @@ void UQuestObjective::ClaimRewards()
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObjective::ClaimRewards)
 	if (Status != EQuestStatus::COMPLETED) return;
 	
+	//Rewards can be shared by all owners of the quest, see UQuestObject::bShareRewards
+	UQuestObject* OwningQuest = GetOwningQuestObject();
+	if (const FQuestObjectiveDefinition* SharedObjective = OwningQuest ? OwningQuest->FindSharedObjective(this) : nullptr)
+	{
+		for (UQuestReward* Reward : SharedObjective->Rewards)
+		{
+			Reward->OwningQuest = OwningQuest;
+			QUEST_NATIVE_EVENT(Reward, ClaimReward);
+			Reward->OwningQuest = nullptr;
+		}
+		return;
+	}
+	
 	for (UQuestReward* Reward : ObjectiveRewards)
 	{
-		Reward->ClaimReward();
+		Reward->OwningQuest = OwningQuest;
+		QUEST_NATIVE_EVENT(Reward, ClaimReward);
 	}
 }
 
+TArray<UQuestReward*> UQuestObjective::GetObjectiveRewards() const
+{
+	const UQuestObject* OwningQuest = GetOwningQuestObject();
+	const FQuestObjectiveDefinition* SharedObjective = OwningQuest ? OwningQuest->FindSharedObjective(this) : nullptr;
+	if (!SharedObjective) return ObjectiveRewards;
+
+	TArray<UQuestReward*> Rewards;
+	Rewards.Reserve(SharedObjective->Rewards.Num());
+	for (UQuestReward* Reward : SharedObjective->Rewards)
+	{
+		Rewards.Add(Reward);
+	}
+	return Rewards;
+}
+
 FString UQuestObjective::GetQuestOwner() const
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObjective::GetController)
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObjective::GetQuestOwner)
 	return GetOwningQuestObject()->QuestOwner;
 }
 
@@ -54,17 +91,16 @@ void UQuestObjective::TickObjective_Implementation(UQuestObject* Quest, float De
 void UQuestObjective::StartObjective_Implementation(UQuestObject* Quest)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObjective::StartObjective_Implementation)
-	if (ShouldTick)
-	{
-		GetOwningQuestObject()->OnQuestTickDelegate.AddDynamic(this, &UQuestObjective::TickObjective);
-	}
+	const EQuestStatus OldStatus = Status;
 	Status = EQuestStatus::IN_PROGRESS;
+	
+	NotifyStatusChanged(OldStatus);
 }
 
 void UQuestObjective::ForceStatus_Implementation(EQuestStatus NewStatus)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObjective::ForceStatus_Implementation)
-	UpdateStatus(NewStatus);
+	QUEST_NATIVE_EVENT(this, UpdateStatus, NewStatus);
 }
 
 void UQuestObjective::UpdateStatus_Implementation(EQuestStatus NewStatus)
@@ -72,12 +108,47 @@ void UQuestObjective::UpdateStatus_Implementation(EQuestStatus NewStatus)
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObjective::UpdateStatus_Implementation)
 	EQuestStatus OldStatus = Status;
 	Status = NewStatus;
-	OnObjectiveStatusUpdatedDelegate.Broadcast(this, Status, OldStatus);
+	
+	NotifyStatusChanged(OldStatus);
+	
+	QUEST_SCOPE_CYCLE_COUNTER(Broadcast);
+	OnObjectiveStatusUpdatedNative.Broadcast(this, Status, OldStatus);
+	if (OnObjectiveStatusUpdatedDelegate.IsBound())
+	{
+		OnObjectiveStatusUpdatedDelegate.Broadcast(this, Status, OldStatus);
+	}
+}
+
+void UQuestObjective::ResetForRepeat_Implementation()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObjective::ResetForRepeat_Implementation)
+	const EQuestStatus OldStatus = Status;
+	Status = EQuestStatus::INVALID;
+	
+	NotifyStatusChanged(OldStatus);
+}
+
+void UQuestObjective::NotifyStatusChanged(EQuestStatus OldStatus)
+{
+	if (Status == OldStatus) return;
+	
+	if (UQuestObject* Quest = GetOwningQuestObject())
+	{
+		Quest->OnObjectiveStatusChanged(this, OldStatus);
+	}
+	
+	if (UQuestSubsystem* QuestSubsystem = GetTypedOuter<UQuestSubsystem>())
+	{
+		QuestSubsystem->OnObjectiveStatusChanged(this, OldStatus);
+	}
 }
 
 void UQuestObjective::Initialize_Implementation(UQuestObject* OwningQuest)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObjective::Initialize_Implementation)
+	//Shared rewards get their OwningQuest when claimed
+	if (OwningQuest && OwningQuest->SharesRewards()) return;
+	
 	for (auto Reward : ObjectiveRewards)
 	{
 		Reward->OwningQuest = GetOwningQuestObject();
@@ -89,6 +160,15 @@ void UQuestObjective::AddProgress_Implementation(UQuestProgressionObject* Progre
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObjective::AddProgress_Implementation)
 }
 
+void UQuestObjective::AddProgressEvent_Implementation(const FQuestProgressEvent& Event, bool& Consume)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObjective::AddProgressEvent_Implementation)
+	if (Event.ProgressionObject)
+	{
+		AddProgress(Event.ProgressionObject, Consume);
+	}
+}
+
 FString UQuestObjective::GetObjectiveDescription_Implementation() const
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestObjective::GetObjectiveDescription_Implementation)
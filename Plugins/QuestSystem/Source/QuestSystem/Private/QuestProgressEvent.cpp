@@ -0,0 +1,16 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestProgressEvent.h"
+#include "QuestObjective.h"
+#include "QuestProgressionObject.h"
+
+FQuestProgressEvent FQuestProgressEvent::MakeFromObject(UQuestProgressionObject* InProgressionObject)
+{
+	FQuestProgressEvent Event;
+	if (!InProgressionObject) return Event;
+	
+	Event.ObjectiveToProgress = InProgressionObject->ObjectiveToProgress;
+	Event.ProgressionObject = InProgressionObject;
+	return Event;
+}
@@ -14,6 +14,7 @@ void UQuestReward::ClaimReward_Implementation()
 UQuestSubsystem* UQuestReward::GetQuestSubsystem() const
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestReward::GetQuestSubsystem)
-	UGameInstance* GameInstance = UGameplayStatics::GetGameInstance(GetOuter());
-	return Cast<UQuestSubsystem>(GameInstance->GetSubsystem<UQuestSubsystem>());
+	//Shared rewards are outered to the quests class default object, which has no world
+	UGameInstance* GameInstance = UGameplayStatics::GetGameInstance(OwningQuest ? static_cast<UObject*>(OwningQuest) : GetOuter());
+	return GameInstance ? GameInstance->GetSubsystem<UQuestSubsystem>() : nullptr;
 }
@@ -0,0 +1,249 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestSaveData.h"
+#include "Serialization/MemoryReader.h"
+
+namespace QuestSaveData
+{
+	void SerializeStatus(FArchive& Ar, EQuestStatus& Status)
+	{
+		uint8 StatusValue = static_cast<uint8>(Status);
+		Ar << StatusValue;
+		Status = static_cast<EQuestStatus>(StatusValue);
+	}
+
+	//Counts and indices are small, packed they mostly take a single byte
+	void SerializePacked(FArchive& Ar, int32& Value)
+	{
+		uint32 PackedValue = static_cast<uint32>(Value + 1);
+		Ar.SerializeIntPacked(PackedValue);
+		Value = static_cast<int32>(PackedValue) - 1;
+	}
+
+	template <typename T>
+	void SerializeArray(FArchive& Ar, TArray<T>& Array)
+	{
+		int32 Num = Array.Num();
+		SerializePacked(Ar, Num);
+		if (Ar.IsLoading())
+		{
+			//Every element takes at least one byte, anything larger is corrupt data
+			if (Num < 0 || Num > Ar.TotalSize() - Ar.Tell())
+			{
+				Ar.SetError();
+				return;
+			}
+			Array.SetNum(Num);
+		}
+
+		for (T& Element : Array)
+		{
+			Ar << Element;
+			if (Ar.IsError()) return;
+		}
+	}
+
+	void SerializeBytes(FArchive& Ar, TArray<uint8>& Bytes)
+	{
+		int32 Num = Bytes.Num();
+		SerializePacked(Ar, Num);
+		if (Ar.IsLoading())
+		{
+			if (Num < 0 || Num > Ar.TotalSize() - Ar.Tell())
+			{
+				Ar.SetError();
+				return;
+			}
+			Bytes.SetNumUninitialized(Num);
+		}
+		
+		Ar.Serialize(Bytes.GetData(), Num);
+	}
+}
+
+FArchive& operator<<(FArchive& Ar, FQuestObjectiveSaveRecord& Record)
+{
+	QuestSaveData::SerializeStatus(Ar, Record.Status);
+	QuestSaveData::SerializeBytes(Ar, Record.SaveGameData);
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FQuestSaveRecord& Record)
+{
+	QuestSaveData::SerializePacked(Ar, Record.ClassIndex);
+	QuestSaveData::SerializeStatus(Ar, Record.Status);
+	QuestSaveData::SerializeBytes(Ar, Record.SaveGameData);
+	QuestSaveData::SerializeArray(Ar, Record.Objectives);
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FQuestOwnerSaveRecord& Record)
+{
+	Ar << Record.Owner;
+	QuestSaveData::SerializeArray(Ar, Record.Quests);
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FQuestSaveSnapshot& Snapshot)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FQuestSaveSnapshot::Serialize)
+	
+	uint32 Magic = FQuestSaveSnapshot::Magic;
+	Ar << Magic;
+	Ar << Snapshot.Version;
+	if (Magic != FQuestSaveSnapshot::Magic || Snapshot.Version < static_cast<int32>(EQuestSaveVersion::Initial)
+		|| Snapshot.Version > static_cast<int32>(EQuestSaveVersion::Latest))
+	{
+		Ar.SetError();
+		return Ar;
+	}
+
+	QuestSaveData::SerializeArray(Ar, Snapshot.QuestClasses);
+	QuestSaveData::SerializeArray(Ar, Snapshot.Owners);
+	return Ar;
+}
+
+void FQuestJournal::WriteHeader(FArchive& Ar)
+{
+	uint32 JournalMagic = Magic;
+	int32 Version = static_cast<int32>(EQuestSaveVersion::Latest);
+	Ar << JournalMagic;
+	Ar << Version;
+}
+
+void FQuestJournal::WriteOwner(FArchive& Ar, int32 OwnerId, FString Owner)
+{
+	uint8 Entry = static_cast<uint8>(EEntry::Owner);
+	Ar << Entry;
+	QuestSaveData::SerializePacked(Ar, OwnerId);
+	Ar << Owner;
+}
+
+void FQuestJournal::WriteQuestClass(FArchive& Ar, int32 ClassId, FString ClassPath)
+{
+	uint8 Entry = static_cast<uint8>(EEntry::QuestClass);
+	Ar << Entry;
+	QuestSaveData::SerializePacked(Ar, ClassId);
+	Ar << ClassPath;
+}
+
+void FQuestJournal::WriteQuest(FArchive& Ar, int32 OwnerId, FQuestSaveRecord& Record)
+{
+	uint8 Entry = static_cast<uint8>(EEntry::Quest);
+	Ar << Entry;
+	QuestSaveData::SerializePacked(Ar, OwnerId);
+	Ar << Record;
+}
+
+bool FQuestJournal::Replay(const TArray<uint8>& Data, FQuestSaveSnapshot& Snapshot)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FQuestJournal::Replay)
+	
+	FMemoryReader Reader(Data, true);
+	uint32 JournalMagic = 0;
+	int32 Version = 0;
+	Reader << JournalMagic;
+	Reader << Version;
+	if (Reader.IsError() || JournalMagic != Magic || Version < static_cast<int32>(EQuestSaveVersion::Initial)
+		|| Version > static_cast<int32>(EQuestSaveVersion::Latest))
+	{
+		return false;
+	}
+
+	TMap<FString, int32> SnapshotOwners;
+	for (int32 i = 0; i < Snapshot.Owners.Num(); i++)
+	{
+		SnapshotOwners.Add(Snapshot.Owners[i].Owner, i);
+	}
+
+	TMap<FString, int32> SnapshotClasses;
+	for (int32 i = 0; i < Snapshot.QuestClasses.Num(); i++)
+	{
+		SnapshotClasses.Add(Snapshot.QuestClasses[i], i);
+	}
+
+	//Snapshot owner and class index -> index into the owners quest records
+	TMap<TPair<int32, int32>, int32> SnapshotQuests;
+	for (int32 OwnerIndex = 0; OwnerIndex < Snapshot.Owners.Num(); OwnerIndex++)
+	{
+		const TArray<FQuestSaveRecord>& OwnerQuests = Snapshot.Owners[OwnerIndex].Quests;
+		for (int32 i = 0; i < OwnerQuests.Num(); i++)
+		{
+			SnapshotQuests.Add({OwnerIndex, OwnerQuests[i].ClassIndex}, i);
+		}
+	}
+
+	//Journal id -> snapshot index
+	TMap<int32, int32> JournalOwners;
+	TMap<int32, int32> JournalClasses;
+	
+	while (!Reader.AtEnd())
+	{
+		uint8 Entry = 0;
+		int32 Id = INDEX_NONE;
+		Reader << Entry;
+		QuestSaveData::SerializePacked(Reader, Id);
+		
+		switch (static_cast<EEntry>(Entry))
+		{
+		case EEntry::Owner:
+			{
+				FString Owner;
+				Reader << Owner;
+				if (Reader.IsError()) return true;
+
+				const int32* OwnerIndex = SnapshotOwners.Find(Owner);
+				if (!OwnerIndex)
+				{
+					OwnerIndex = &SnapshotOwners.Add(Owner, Snapshot.Owners.Num());
+					Snapshot.Owners.AddDefaulted_GetRef().Owner = Owner;
+				}
+				JournalOwners.Add(Id, *OwnerIndex);
+				break;
+			}
+		case EEntry::QuestClass:
+			{
+				FString ClassPath;
+				Reader << ClassPath;
+				if (Reader.IsError()) return true;
+
+				const int32* ClassIndex = SnapshotClasses.Find(ClassPath);
+				if (!ClassIndex)
+				{
+					ClassIndex = &SnapshotClasses.Add(ClassPath, Snapshot.QuestClasses.Add(ClassPath));
+				}
+				JournalClasses.Add(Id, *ClassIndex);
+				break;
+			}
+		case EEntry::Quest:
+			{
+				FQuestSaveRecord Record;
+				Reader << Record;
+				if (Reader.IsError()) return true;
+
+				const int32* OwnerIndex = JournalOwners.Find(Id);
+				const int32* ClassIndex = JournalClasses.Find(Record.ClassIndex);
+				if (!OwnerIndex || !ClassIndex) return true;
+
+				Record.ClassIndex = *ClassIndex;
+				TArray<FQuestSaveRecord>& OwnerQuests = Snapshot.Owners[*OwnerIndex].Quests;
+				if (const int32* QuestIndex = SnapshotQuests.Find({*OwnerIndex, *ClassIndex}))
+				{
+					OwnerQuests[*QuestIndex] = MoveTemp(Record);
+				}
+				else
+				{
+					SnapshotQuests.Add({*OwnerIndex, *ClassIndex}, OwnerQuests.Add(MoveTemp(Record)));
+				}
+				break;
+			}
+		default:
+			return true;
+		}
+
+		if (Reader.IsError()) return true;
+	}
+
+	return true;
+}
@@ -0,0 +1,49 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestStats.h"
+
+DEFINE_STAT(STAT_QuestSystem_Tick);
+DEFINE_STAT(STAT_QuestSystem_TickObjectives);
+DEFINE_STAT(STAT_QuestSystem_TickQuests);
+DEFINE_STAT(STAT_QuestSystem_DrainDeferredProgress);
+DEFINE_STAT(STAT_QuestSystem_Broadcast);
+DEFINE_STAT(STAT_QuestSystem_JournalFlush);
+
+DEFINE_STAT(STAT_QuestSystem_ProgressEvents);
+DEFINE_STAT(STAT_QuestSystem_DiscardedEvents);
+DEFINE_STAT(STAT_QuestSystem_Lookups);
+
+DEFINE_STAT(STAT_QuestSystem_QuestsLocked);
+DEFINE_STAT(STAT_QuestSystem_QuestsUnlocked);
+DEFINE_STAT(STAT_QuestSystem_QuestsAccepted);
+DEFINE_STAT(STAT_QuestSystem_QuestsStarting);
+DEFINE_STAT(STAT_QuestSystem_QuestsInProgress);
+DEFINE_STAT(STAT_QuestSystem_QuestsCompleted);
+DEFINE_STAT(STAT_QuestSystem_QuestsFailed);
+DEFINE_STAT(STAT_QuestSystem_ObjectivesTicking);
+
+CSV_DEFINE_CATEGORY_MODULE(QUESTSYSTEM_API, QuestSystem, true);
+
+#define QUEST_SET_STATUS_STAT(Stat, Status) \
+	SET_DWORD_STAT(STAT_QuestSystem_##Stat, QuestsPerStatus[static_cast<int32>(EQuestStatus::Status)]); \
+	CSV_CUSTOM_STAT(QuestSystem, Stat, QuestsPerStatus[static_cast<int32>(EQuestStatus::Status)], ECsvCustomStatOp::Set)
+
+void QuestStats::SetQuestsPerStatus(const int32 (&QuestsPerStatus)[QuestStatusCount])
+{
+	QUEST_SET_STATUS_STAT(QuestsLocked, LOCKED);
+	QUEST_SET_STATUS_STAT(QuestsUnlocked, UNLOCKED);
+	QUEST_SET_STATUS_STAT(QuestsAccepted, ACCEPTED);
+	QUEST_SET_STATUS_STAT(QuestsStarting, STARTING);
+	QUEST_SET_STATUS_STAT(QuestsInProgress, IN_PROGRESS);
+	QUEST_SET_STATUS_STAT(QuestsCompleted, COMPLETED);
+	QUEST_SET_STATUS_STAT(QuestsFailed, FAILED);
+}
+
+#undef QUEST_SET_STATUS_STAT
+
+void QuestStats::SetObjectivesTicking(int32 NumObjectives)
+{
+	SET_DWORD_STAT(STAT_QuestSystem_ObjectivesTicking, NumObjectives);
+	CSV_CUSTOM_STAT(QuestSystem, ObjectivesTicking, NumObjectives, ECsvCustomStatOp::Set);
+}
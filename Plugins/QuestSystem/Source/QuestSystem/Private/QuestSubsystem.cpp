@@ -2,9 +2,134 @@
 
 
 #include "QuestSubsystem.h"
+#include "QuestLog.h"
+#include "QuestNativeDispatch.h"
 #include "QuestObject.h"
+#include "QuestObjective.h"
 #include "QuestProgressionObject.h"
+#include "QuestTransitions.h"
+#include "Async/Async.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
 #include "Kismet/GameplayStatics.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+#include "Tasks/Pipe.h"
+#include "UObject/ObjectInstancingGraph.h"
+#include "UObject/SoftObjectPath.h"
+
+namespace QuestSave
+{
+	//Snapshots and journal batches get written one after another in the order they were issued
+	UE::Tasks::FPipe WritePipe{TEXT("QuestSaveWritePipe")};
+
+	bool WriteSnapshot(FQuestSaveSnapshot& Snapshot, const FString& FilePath)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuestSave::WriteSnapshot)
+		
+		TArray<uint8> Data;
+		FMemoryWriter Writer(Data, true);
+		Writer << Snapshot;
+		if (Writer.IsError()) return false;
+
+		//A crash while writing keeps the previous save intact
+		const FString TempFilePath = FilePath + TEXT(".tmp");
+		if (!FFileHelper::SaveArrayToFile(Data, *TempFilePath)) return false;
+		return IFileManager::Get().Move(*FilePath, *TempFilePath, true);
+	}
+
+	/**
+	 * @param bStartJournal The batch is the first after a compaction. The journal only starts over when the compacted
+	 * snapshot got written, otherwise the batch is appended and its owner and class ids replace the previous ones
+	 * @param bSnapshotWritten Result of the compaction, set by the compaction task running before on the same pipe
+	 */
+	bool AppendJournal(TArray<uint8>& Data, const FString& FilePath, bool bStartJournal, const bool& bSnapshotWritten)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuestSave::AppendJournal)
+
+		const bool bTruncate = bStartJournal && bSnapshotWritten;
+		const bool bWriteHeader = bTruncate || IFileManager::Get().FileSize(*FilePath) <= 0;
+		
+		const TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*FilePath, bTruncate ? 0 : FILEWRITE_Append));
+		if (!Writer) return false;
+
+		if (bWriteHeader)
+		{
+			FQuestJournal::WriteHeader(*Writer);
+		}
+		Writer->Serialize(Data.GetData(), Data.Num());
+		return Writer->Close();
+	}
+
+	bool HasSaveGameProperties(const UClass* Class, TMap<const UClass*, bool>& Cache)
+	{
+		if (const bool* HasSaveGame = Cache.Find(Class)) return *HasSaveGame;
+
+		bool HasSaveGame = false;
+		for (TFieldIterator<FProperty> It(Class); It; ++It)
+		{
+			if (It->HasAnyPropertyFlags(CPF_SaveGame))
+			{
+				HasSaveGame = true;
+				break;
+			}
+		}
+		
+		Cache.Add(Class, HasSaveGame);
+		return HasSaveGame;
+	}
+
+	void WriteSaveGameProperties(UObject* Object, TArray<uint8>& OutData)
+	{
+		FMemoryWriter Writer(OutData, true);
+		FObjectAndNameAsStringProxyArchive Archive(Writer, false);
+		Archive.ArIsSaveGame = true;
+		Object->Serialize(Archive);
+	}
+
+	void ReadSaveGameProperties(UObject* Object, const TArray<uint8>& Data)
+	{
+		if (Data.Num() == 0) return;
+		
+		FMemoryReader Reader(Data, true);
+		FObjectAndNameAsStringProxyArchive Archive(Reader, true);
+		Archive.ArIsSaveGame = true;
+		Object->Serialize(Archive);
+	}
+}
+
+namespace QuestPool
+{
+	/**
+	 * Copies the properties subclasses of BaseClass added from the archetype of the object, so a pooled object
+	 * doesn't carry state of its last owner. The state of BaseClass itself is reset by ResetForRepeat,
+	 * instanced subobjects get reset on their own.
+	 */
+	void ResetToArchetype(UObject* Object, const UClass* BaseClass)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuestPool::ResetToArchetype)
+		
+		const UObject* Archetype = Object->GetArchetype();
+		if (!Archetype || !Archetype->IsA(Object->GetClass())) return;
+
+		//The persistent frame of the event graph belongs to this object, it must not be shared with the archetype
+		const UBlueprintGeneratedClass* BlueprintClass = Cast<UBlueprintGeneratedClass>(Object->GetClass());
+		const FProperty* UberGraphFrame = BlueprintClass ? BlueprintClass->UberGraphFramePointerProperty : nullptr;
+		
+		for (TFieldIterator<FProperty> It(Object->GetClass()); It; ++It)
+		{
+			const UClass* OwnerClass = It->GetOwnerClass();
+			if (!OwnerClass || OwnerClass == BaseClass || !OwnerClass->IsChildOf(BaseClass) || *It == UberGraphFrame) continue;
+			if (It->HasAnyPropertyFlags(CPF_InstancedReference | CPF_ContainsInstancedReference)) continue;
+
+			It->CopyCompleteValue_InContainer(Object, Archetype);
+		}
+	}
+}
 
 UQuestSubsystem::UQuestSubsystem()
 	: Super()
@@ -17,80 +142,222 @@ void UQuestSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 	Super::Initialize(Collection);
 
 	Quests.Empty();
-	Quests = TMap<FString, FTArrayQuestComparator>();
+	OwnerHandles.Empty();
+	OwnerNames.Empty();
+	QuestClassOwners.Empty();
+	ProgressRoutes.Empty();
+	QuestTickManager.Reset();
+
+	//Producers may enqueue as soon as the subsystem exists, the ring is only allocated once
+	if (DeferredProgress.GetCapacity() == 0)
+	{
+		DeferredProgress.Init(DeferredProgressCapacity);
+	}
+
+	bInitialized = true;
+}
+
+void UQuestSubsystem::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	Super::AddReferencedObjects(InThis, Collector);
+
+	for (TPair<const UClass*, TSharedRef<FQuestDefinition>>& Definition : CastChecked<UQuestSubsystem>(InThis)->QuestDefinitions)
+	{
+		Definition.Value->AddReferencedObjects(Collector);
+	}
 }
 
 void UQuestSubsystem::Deinitialize()
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::Deinitialize)
+	bInitialized = false;
+	DisableQuestJournal();
+	DisableQuestDeltaTracking();
+	UnmountQuestSnapshot();
+	
 	Quests.Empty();
+	OwnerHandles.Empty();
+	OwnerNames.Empty();
+	QuestClassOwners.Empty();
+	ProgressRoutes.Empty();
+	QuestTickManager.Reset();
+	QuestPools.Empty();
+	QuestDefinitions.Empty();
 	
 	Super::Deinitialize();
 }
 
-UQuestObject* UQuestSubsystem::GetQuestObject(TSubclassOf<UQuestObject> QuestClass, FString QuestOwner) const
+void UQuestSubsystem::Tick(float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::Tick)
+	CSV_SCOPED_TIMING_STAT(QuestSystem, Tick);
+	DrainDeferredProgress();
+
+	if (IsQuestJournalEnabled())
+	{
+		JournalFlushTimer += DeltaTime;
+		if (JournalFlushTimer >= QuestJournalFlushInterval) FlushQuestJournal();
+	}
+	
+	UpdateQuestStats();
+
+	const UWorld* World = GetWorld();
+	if (!bTickQuestsWhenPaused && World && World->IsPaused()) return;
+	
+	QuestTickManager.Tick(DeltaTime, QuestTickBudgetMs);
+}
+
+void UQuestSubsystem::UpdateQuestStats() const
+{
+#if STATS || CSV_PROFILER
+	int32 QuestsPerStatus[QuestStatusCount] = {};
+	for (const TPair<const UClass*, FQuestClassOwners>& ClassOwners : QuestClassOwners)
+	{
+		for (int32 Status = 0; Status < QuestStatusCount; Status++)
+		{
+			QuestsPerStatus[Status] += ClassOwners.Value.OwnersByStatus[Status].Num();
+		}
+	}
+	
+	QuestStats::SetQuestsPerStatus(QuestsPerStatus);
+	QuestStats::SetObjectivesTicking(QuestTickManager.NumTickingObjectives());
+#endif
+}
+
+FQuestOwnerHandle UQuestSubsystem::FindOrAddOwnerHandle(const FString& QuestOwner)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::FindOrAddOwnerHandle)
+	if (QuestOwner.IsEmpty()) return FQuestOwnerHandle();
+
+	const uint32 OwnerHash = GetTypeHash(QuestOwner);
+	if (const FQuestOwnerHandle* Handle = OwnerHandles.FindByHash(OwnerHash, QuestOwner))
+	{
+		return *Handle;
+	}
+
+	const FQuestOwnerHandle NewHandle(OwnerNames.Add(QuestOwner));
+	OwnerHandles.AddByHash(OwnerHash, QuestOwner, NewHandle);
+	Quests.SetNum(OwnerNames.Num());
+	
+	return NewHandle;
+}
+
+FQuestOwnerHandle UQuestSubsystem::FindOwnerHandle(const FString& QuestOwner) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::FindOwnerHandle)
+	const FQuestOwnerHandle* Handle = OwnerHandles.Find(QuestOwner);
+	return Handle ? *Handle : FQuestOwnerHandle();
+}
+
+FString UQuestSubsystem::GetOwnerName(FQuestOwnerHandle QuestOwner) const
+{
+	return OwnerNames.IsValidIndex(QuestOwner.GetIndex()) ? OwnerNames[QuestOwner.GetIndex()] : FString();
+}
+
+UQuestObject* UQuestSubsystem::GetQuestObject(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner)
+{
+	return GetQuestObject(QuestClass, FindOwnerHandle(QuestOwner));
+}
+
+UQuestObject* UQuestSubsystem::GetQuestObject(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::GetQuestObject)
-	auto* QuestComparatorArray = Quests.Find(QuestOwner);
+	QUEST_COUNTER_ADD(Lookups, 1);
+	FaultInMappedQuest(QuestClass, QuestOwner);
+	
+	const FTArrayQuestComparator* QuestComparatorArray = FindOwnerQuests(QuestOwner);
 	if (!QuestComparatorArray)
 	{
-		GEngine->AddOnScreenDebugMessage(-1, 5.0, FColor::Red, "UQuestSubsystem::GetQuestObject - FTArrayQuestComparator is missing");
+		QUEST_DIAG(Verbose, TEXT("GetQuestObject - Owner %d is not registered"), QuestOwner.GetIndex());
 		return nullptr;
 	}
 
-	
-	
-	TArray<FQuestComparator> QuestObjects = QuestComparatorArray->Get();
-	for (FQuestComparator Object : QuestObjects)
+	if (const FQuestComparator* Comparator = QuestComparatorArray->Find(QuestClass))
 	{
-		if (Object.QuestClass == QuestClass)
+		QUEST_DIAG(VeryVerbose, TEXT("GetQuestObject - Found %s of %s"), *GetNameSafe(QuestClass), *GetOwnerName(QuestOwner));
+		//Records get their object on first access, callers always get a quest object
+		if (Comparator->IsRecord())
 		{
-		GEngine->AddOnScreenDebugMessage(-1, 5.0, FColor::Red, "UQuestSubsystem::GetQuestObject - Found given quest");
-			return Object.QuestObject;
+			return MaterializeQuest(QuestClass, QuestOwner);
 		}
+		return Comparator->QuestObject;
 	}
 
-	GEngine->AddOnScreenDebugMessage(-1, 5.0, FColor::Red, "UQuestSubsystem::GetQuestObject - Quest is missing");
+	QUEST_DIAG(Verbose, TEXT("GetQuestObject - %s of %s is missing"), *GetNameSafe(QuestClass), *GetOwnerName(QuestOwner));
 	return nullptr;
 }
 
-UQuestObject* UQuestSubsystem::UnlockQuest(TSubclassOf<UQuestObject> QuestToUnlock, FString QuestOwner)
+EQuestStatus UQuestSubsystem::GetQuestStatus(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner) const
+{
+	return GetQuestStatus(QuestClass, FindOwnerHandle(QuestOwner));
+}
+
+EQuestStatus UQuestSubsystem::GetQuestStatus(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::GetQuestStatus)
+	QUEST_COUNTER_ADD(Lookups, 1);
+	const FTArrayQuestComparator* OwnerQuests = FindOwnerQuests(QuestOwner);
+	if (const FQuestComparator* Comparator = OwnerQuests ? OwnerQuests->Find(QuestClass) : nullptr)
+	{
+		return Comparator->GetStatus();
+	}
+
+	const FQuestMappedSnapshot::FQuest* MappedQuest = FindMappedQuest(QuestOwner, QuestClass);
+	return MappedQuest ? MappedQuest->GetStatus() : EQuestStatus::INVALID;
+}
+
+UQuestObject* UQuestSubsystem::UnlockQuest(TSubclassOf<UQuestObject> QuestToUnlock, const FString& QuestOwner)
+{
+	return UnlockQuest(QuestToUnlock, FindOrAddOwnerHandle(QuestOwner));
+}
+
+UQuestObject* UQuestSubsystem::UnlockQuest(TSubclassOf<UQuestObject> QuestToUnlock, FQuestOwnerHandle QuestOwner)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::UnlockQuest)
 	
 	return ApplyCommandToQuest(QuestToUnlock, QuestOwner, EQuestEnterCommand::UNLOCK);
 }
 
+bool UQuestSubsystem::UnlockQuestRecord(TSubclassOf<UQuestObject> QuestToUnlock, const FString& QuestOwner)
+{
+	return UnlockQuestRecord(QuestToUnlock, FindOrAddOwnerHandle(QuestOwner));
+}
+
+bool UQuestSubsystem::UnlockQuestRecord(TSubclassOf<UQuestObject> QuestToUnlock, FQuestOwnerHandle QuestOwner)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::UnlockQuestRecord)
+	
+	return ApplyCommand(QuestToUnlock, QuestOwner, EQuestEnterCommand::UNLOCK);
+}
+
 UQuestObject* UQuestSubsystem::UnlockQuestObject(UQuestObject* QuestObject)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::UnlockQuestObject)
 
 	if (!IsValid(QuestObject)) return nullptr;
 
-	return ApplyCommandToQuest(QuestObject->GetClass(), QuestObject->QuestOwner, EQuestEnterCommand::UNLOCK);
+	return ApplyCommandToQuest(QuestObject->GetClass(), QuestObject->QuestOwnerHandle, EQuestEnterCommand::UNLOCK);
 }
 
-bool UQuestSubsystem::IsQuestUnlocked(TSubclassOf<UQuestObject> QuestToCheck, FString QuestOwner) const
+bool UQuestSubsystem::IsQuestUnlocked(TSubclassOf<UQuestObject> QuestToCheck, const FString& QuestOwner) const
+{
+	return IsQuestUnlocked(QuestToCheck, FindOwnerHandle(QuestOwner));
+}
+
+bool UQuestSubsystem::IsQuestUnlocked(TSubclassOf<UQuestObject> QuestToCheck, FQuestOwnerHandle QuestOwner) const
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::IsQuestUnlocked)
-	auto* QuestComparatorArray = Quests.Find(QuestOwner);
-	if (!QuestComparatorArray)
-	{
-		return false;
-	}
+	const EQuestStatus Status = GetQuestStatus(QuestToCheck, QuestOwner);
 
-	for (FQuestComparator QuestComparator : QuestComparatorArray->Get())
-	{
-		if (QuestComparator.QuestClass == QuestToCheck)
-		{
-			return (QuestComparator.QuestObject->GetStatus() != EQuestStatus::INVALID) && (QuestComparator.QuestObject->GetStatus() != EQuestStatus::LOCKED);
-		}
-	}
+	return (Status != EQuestStatus::INVALID) && (Status != EQuestStatus::LOCKED);
+}
 
-	return false;
+UQuestObject* UQuestSubsystem::AcceptQuest(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner)
+{
+	return AcceptQuest(QuestClass, FindOrAddOwnerHandle(QuestOwner));
 }
 
-UQuestObject* UQuestSubsystem::AcceptQuest(TSubclassOf<UQuestObject> QuestClass, FString QuestOwner)
+UQuestObject* UQuestSubsystem::AcceptQuest(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::AcceptQuest)
 
@@ -103,10 +370,15 @@ UQuestObject* UQuestSubsystem::AcceptQuestObject(UQuestObject* QuestObject)
 	
 	if (!IsValid(QuestObject)) return nullptr;
 	
-	return ApplyCommandToQuest(QuestObject->GetClass(), QuestObject->QuestOwner, EQuestEnterCommand::ACCEPT);
+	return ApplyCommandToQuest(QuestObject->GetClass(), QuestObject->QuestOwnerHandle, EQuestEnterCommand::ACCEPT);
+}
+
+UQuestObject* UQuestSubsystem::InitializeQuest(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner)
+{
+	return InitializeQuest(QuestClass, FindOrAddOwnerHandle(QuestOwner));
 }
 
-UQuestObject* UQuestSubsystem::InitializeQuest(TSubclassOf<UQuestObject> QuestClass, FString QuestOwner)
+UQuestObject* UQuestSubsystem::InitializeQuest(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::InitializeQuest)
 	
@@ -119,10 +391,15 @@ UQuestObject* UQuestSubsystem::InitializeQuestObject(UQuestObject* QuestObject)
 	
 	if (!IsValid(QuestObject)) return nullptr;
 	
-	return ApplyCommandToQuest(QuestObject->GetClass(), QuestObject->QuestOwner, EQuestEnterCommand::INITIALIZE);
+	return ApplyCommandToQuest(QuestObject->GetClass(), QuestObject->QuestOwnerHandle, EQuestEnterCommand::INITIALIZE);
 }
 
-UQuestObject* UQuestSubsystem::StartQuest(TSubclassOf<UQuestObject> QuestClass, FString QuestOwner)
+UQuestObject* UQuestSubsystem::StartQuest(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner)
+{
+	return StartQuest(QuestClass, FindOrAddOwnerHandle(QuestOwner));
+}
+
+UQuestObject* UQuestSubsystem::StartQuest(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::StartQuest)
 	
@@ -134,214 +411,1774 @@ UQuestObject* UQuestSubsystem::StartQuestObject(UQuestObject* QuestObject)
 	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::StartQuestObject)
 	
 	if (!IsValid(QuestObject)) return nullptr;
-	return ApplyCommandToQuest(QuestObject->GetClass(), QuestObject->QuestOwner, EQuestEnterCommand::START);
+	return ApplyCommandToQuest(QuestObject->GetClass(), QuestObject->QuestOwnerHandle, EQuestEnterCommand::START);
 }
 
-UQuestObject* UQuestSubsystem::ApplyCommandToQuest(TSubclassOf<UQuestObject> QuestClass, FString QuestOwner,
-	EQuestEnterCommand QuestCommand)
+UQuestObject* UQuestSubsystem::RepeatQuest(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner)
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::TryEnterQuestState)
+	return RepeatQuest(QuestClass, FindOrAddOwnerHandle(QuestOwner));
+}
+
+UQuestObject* UQuestSubsystem::RepeatQuest(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::RepeatQuest)
 	
-	if (!EnsurePlayerEntryExists(QuestOwner)) return nullptr;
-	if (!IsValid(QuestClass)) return nullptr;
+	return ApplyCommandToQuest(QuestClass, QuestOwner, EQuestEnterCommand::REPEAT);
+}
+
+bool UQuestSubsystem::ReleaseQuest(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner)
+{
+	return ReleaseQuest(QuestClass, FindOwnerHandle(QuestOwner));
+}
+
+bool UQuestSubsystem::ReleaseQuest(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::ReleaseQuest)
+
+	FaultInMappedQuest(QuestClass, QuestOwner);
+	FTArrayQuestComparator* OwnerQuests = FindOwnerQuests(QuestOwner);
+	FQuestComparator* Comparator = OwnerQuests ? OwnerQuests->Find(QuestClass) : nullptr;
+	if (!Comparator || !IsValid(Comparator->QuestObject)) return false;
+
+	UQuestObject* QuestObject = Comparator->QuestObject;
+	if (!QuestObject->ResetForRepeat()) return false;
+
+	//The slot stays, the next command for this class fills it again
+	Comparator->QuestObject = nullptr;
+	RemoveFromQuestOwnerIndex(QuestClass, QuestOwner);
+	QuestTickManager.UnregisterQuest(QuestObject);
 	
-	FQuestComparator QuestComparator = GetQuestComparatorForPlayer(QuestClass, QuestOwner);
-	//FQuestComparator NewComparator = FQuestComparator();
-	if (QuestComparator == InvalidQuestComparator || !IsValid(QuestComparator.QuestObject))
+	//Journal and deltas record the quest as removed
+	MarkQuestChanged(QuestOwner, QuestClass);
+
+	QuestObject->OnQuestStartedDelegate.Clear();
+	QuestObject->OnQuestTickDelegate.Clear();
+	QuestObject->OnQuestFinishedDelegate.Clear();
+	QuestObject->OnQuestProgressUpdatedDelegate.Clear();
+	QuestObject->OnQuestStartedNative.Clear();
+	QuestObject->OnQuestTickNative.Clear();
+	QuestObject->OnQuestFinishedNative.Clear();
+	QuestObject->OnQuestProgressUpdatedNative.Clear();
+	QuestObject->QuestOwner.Empty();
+	QuestObject->QuestOwnerHandle = FQuestOwnerHandle();
+	QuestPool::ResetToArchetype(QuestObject, UQuestObject::StaticClass());
+
+	for (UQuestObjective* Objective : QuestObject->QuestObjectives)
 	{
-		QuestComparator = CreateNewComparator(QuestClass, QuestOwner);
-		AddQuestComparator(QuestComparator, QuestOwner);
+		if (!Objective) continue;
+		
+		Objective->OnObjectiveStatusUpdatedDelegate.Clear();
+		Objective->OnProgressUpdatedDelegate.Clear();
+		Objective->OnObjectiveStatusUpdatedNative.Clear();
+		Objective->OnProgressUpdatedNative.Clear();
+		QuestPool::ResetToArchetype(Objective, UQuestObjective::StaticClass());
 	}
 
-	bool Success = false; 
-		
-	switch (QuestCommand)
+	FQuestObjectPool& Pool = QuestPools.FindOrAdd(QuestClass);
+	if (Pool.Objects.Num() < MaxPooledQuestsPerClass)
 	{
-	case EQuestEnterCommand::UNLOCK:
-		Success = QuestComparator.QuestObject->Unlock();
-		break;
-	case EQuestEnterCommand::ACCEPT:
-		Success = QuestComparator.QuestObject->AcceptQuest();
-		break;
-	case EQuestEnterCommand::INITIALIZE:
-		Success = QuestComparator.QuestObject->Initialize();
-		break;
-	case EQuestEnterCommand::START:
-		Success = QuestComparator.QuestObject->StartQuest();
-		break;
-	default:
-		break;
+		Pool.Objects.Add(QuestObject);
 	}
-		
-	return Success ? QuestComparator.QuestObject : nullptr; 
+	
+	return true;
 }
 
-FString UQuestSubsystem::GetQuestOwner(TSubclassOf<UQuestObject> QuestClass) const
+UQuestObject* UQuestSubsystem::ApplyCommandToQuest(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner,
+	EQuestEnterCommand QuestCommand)
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::GetQuestOwner)
-	
-	for (auto Iterator : Quests)
-	{
-		for (FQuestComparator& Comparator : Iterator.Value.GetRef())
-		{
-			if (Comparator.QuestClass !=  QuestClass) continue;
-
-			if (!IsValid(Comparator.QuestObject)) continue;
+	return ApplyCommandToQuest(QuestClass, FindOrAddOwnerHandle(QuestOwner), QuestCommand);
+}
 
-			if (Comparator.QuestObject->GetStatus() == EQuestStatus::LOCKED ||
-				Comparator.QuestObject->GetStatus() == EQuestStatus::INVALID) continue;
+UQuestObject* UQuestSubsystem::ApplyCommandToQuest(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner,
+	EQuestEnterCommand QuestCommand)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::ApplyCommandToQuest)
+	
+	if (!ApplyCommand(QuestClass, QuestOwner, QuestCommand)) return nullptr;
 
-			return Iterator.Key;
-		}
-	}
+	//Callers expect the object, an unlocked record gets its object here
+	return GetQuestObject(QuestClass, QuestOwner);
+}
 
-	return "";
+bool UQuestSubsystem::ApplyCommand(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner,
+	EQuestEnterCommand QuestCommand)
+{
+	return ApplyCommand(QuestClass, FindOrAddOwnerHandle(QuestOwner), QuestCommand);
 }
 
-void UQuestSubsystem::AddProgress(FString QuestOwner, UQuestProgressionObject* Progressor, TSubclassOf<UQuestObject> QuestClass)
+bool UQuestSubsystem::ApplyCommand(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner,
+	EQuestEnterCommand QuestCommand)
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::AddProgress)
-	if (!EnsurePlayerEntryExists(QuestOwner) || !Progressor) return;
-	if (QuestClass && !IsValid(GetQuestObject(QuestClass, QuestOwner))) return;
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::ApplyCommand)
+	
+	if (!FindOwnerQuests(QuestOwner)) return false;
+	if (!IsValid(QuestClass)) return false;
 
-	if (!QuestClass)
+	FaultInMappedQuest(QuestClass, QuestOwner);
+	FTArrayQuestComparator* OwnerQuests = FindOwnerQuests(QuestOwner);
+
+	//Locking and unlocking only moves the record, no object needed
+	FQuestComparator* Comparator = OwnerQuests->Find(QuestClass);
+	if ((!Comparator || !IsValid(Comparator->QuestObject)) && SupportsQuestRecords(QuestClass))
 	{
-		auto QuestObjects = GetQuestObjects(QuestOwner);
-		for (auto QuestObject : QuestObjects)
+		if (!Comparator)
 		{
-			if (!IsValid(QuestObject)) continue;
-			QuestObject->ProgressQuest(Progressor);
-			//a quest might consume the progressor and we don't want to add more progress when it gets destroyed
-			if (!IsValid(Progressor)) break;
+			FQuestComparator NewRecord;
+			NewRecord.QuestClass = QuestClass;
+			Comparator = &OwnerQuests->Add(NewRecord);
+		}
+		
+		if (Comparator->RecordStatus == EQuestStatus::INVALID)
+		{
+			//A slot whose object got lost or released starts over as locked quest
+			RemoveFromQuestOwnerIndex(QuestClass, QuestOwner);
+			Comparator->QuestObject = nullptr;
+			Comparator->RecordStatus = EQuestStatus::LOCKED;
+			UpdateQuestOwnerIndex(QuestClass, QuestOwner, EQuestStatus::INVALID, EQuestStatus::LOCKED);
+		}
+
+		if (QuestCommand == EQuestEnterCommand::UNLOCK)
+		{
+			const EQuestStatus OldStatus = Comparator->RecordStatus;
+			if (!QuestTransitions::CanApply(OldStatus, QuestCommand)) return false;
+			
+			Comparator->RecordStatus = QuestTransitions::GetTarget(OldStatus, QuestCommand);
+			UpdateQuestOwnerIndex(QuestClass, QuestOwner, OldStatus, Comparator->RecordStatus);
+			return true;
 		}
-		return;
 	}
 	
-	GetQuestObject(QuestClass, QuestOwner)->ProgressQuest(Progressor);
+	UQuestObject* QuestObject = MaterializeQuest(QuestClass, QuestOwner);
+	if (!QuestObject) return false;
+
+	const EQuestStatus OldStatus = QuestObject->GetStatus();
+	const bool Success = ExecuteQuestCommand(QuestObject, QuestCommand);
+
+	OnQuestStatusChanged(QuestObject, OldStatus);
+		
+	return Success; 
 }
 
-void UQuestSubsystem::ClearQuests()
+bool UQuestSubsystem::ExecuteQuestCommand(UQuestObject* QuestObject, EQuestEnterCommand QuestCommand)
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::ClearQuests)
-	Quests.Empty();
+	switch (QuestCommand)
+	{
+	case EQuestEnterCommand::UNLOCK:
+		return QuestObject->Unlock();
+	case EQuestEnterCommand::ACCEPT:
+		return QuestObject->AcceptQuest();
+	case EQuestEnterCommand::INITIALIZE:
+		return QuestObject->Initialize();
+	case EQuestEnterCommand::START:
+		return QuestObject->StartQuest();
+	case EQuestEnterCommand::REPEAT:
+		//ResetForRepeat also takes quests that never ran, the command only repeats finished ones
+		return QuestTransitions::CanApply(QuestObject->GetStatus(), QuestCommand) && QuestObject->ResetForRepeat();
+	default:
+		return false;
+	}
 }
 
-FQuestComparator& UQuestSubsystem::GetQuestComparatorForPlayer(TSubclassOf<UQuestObject> QuestClass,
-                                                                   const FString Controller)
+UQuestObject* UQuestSubsystem::AdvanceQuestTo(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner, EQuestStatus TargetStatus)
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::GetQuestComparatorForController)
-	TArray<FQuestComparator>& QuestComparators = Quests.Find(Controller)->GetRef();
+	return AdvanceQuestTo(QuestClass, FindOrAddOwnerHandle(QuestOwner), TargetStatus);
+}
+
+UQuestObject* UQuestSubsystem::AdvanceQuestTo(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner, EQuestStatus TargetStatus)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::AdvanceQuestTo)
+
+	if (!FindOwnerQuests(QuestOwner) || !IsValid(QuestClass)) return nullptr;
 
-	for (int i = 0; i < QuestComparators.Num(); i++)
+	//A quest the owner does not have yet starts out locked
+	const EQuestStatus CurrentStatus = GetQuestStatus(QuestClass, QuestOwner);
+	if (!QuestTransitions::IsReachable(CurrentStatus == EQuestStatus::INVALID ? EQuestStatus::LOCKED : CurrentStatus, TargetStatus)) return nullptr;
+
+	FaultInMappedQuest(QuestClass, QuestOwner);
+	UQuestObject* QuestObject = MaterializeQuest(QuestClass, QuestOwner);
+	if (!QuestObject) return nullptr;
+
+	//The owner index, tick registration and change tracking only need the status the chain ends in
+	const EQuestStatus OldStatus = QuestObject->GetStatus();
+	EQuestEnterCommand QuestCommand = EQuestEnterCommand::UNLOCK;
+	while (QuestTransitions::GetNextCommand(QuestObject->GetStatus(), TargetStatus, QuestCommand))
 	{
-		if (QuestComparators[i].QuestClass == QuestClass)
-		{
-			return QuestComparators[i];
-		}
+		//An override may report success without moving the quest on
+		const EQuestStatus StepStatus = QuestObject->GetStatus();
+		if (!ExecuteQuestCommand(QuestObject, QuestCommand) || QuestObject->GetStatus() == StepStatus) break;
 	}
 
-	InvalidQuestComparator = FQuestComparator();
-	return InvalidQuestComparator;
+	OnQuestStatusChanged(QuestObject, OldStatus);
+
+	return QuestObject->GetStatus() == TargetStatus ? QuestObject : nullptr;
 }
 
-FQuestComparator UQuestSubsystem::CreateNewComparator(TSubclassOf<UQuestObject> QuestClass, FString Owner, bool AutoUnlocked)
+TArray<FQuestCommandResult> UQuestSubsystem::ApplyCommandToQuests(const TArray<TSubclassOf<UQuestObject>>& QuestClasses,
+	const TArray<FString>& QuestOwners, EQuestEnterCommand QuestCommand)
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::CreateNewComparator)
+	OwnerNames.Reserve(OwnerNames.Num() + QuestOwners.Num());
+	OwnerHandles.Reserve(OwnerHandles.Num() + QuestOwners.Num());
+	Quests.Reserve(Quests.Num() + QuestOwners.Num());
 
-	if (!QuestClass || Owner.IsEmpty())
-	{
-		InvalidQuestComparator = FQuestComparator();
-		return InvalidQuestComparator;
-	}
-	
-	if (!EnsurePlayerEntryExists(Owner)) 
+	TArray<FQuestOwnerHandle> OwnerHandleList;
+	OwnerHandleList.Reserve(QuestOwners.Num());
+	for (const FString& QuestOwner : QuestOwners)
 	{
-		InvalidQuestComparator = FQuestComparator();
-		return InvalidQuestComparator;
+		OwnerHandleList.Add(FindOrAddOwnerHandle(QuestOwner));
 	}
-	
-	FQuestComparator NewComparator;
-	NewComparator.QuestObject = NewObject<UQuestObject>(this, QuestClass);
-	NewComparator.QuestClass = QuestClass;
-	NewComparator.QuestObject->QuestOwner = Owner;
-	NewComparator.QuestObject->QuestStatus = AutoUnlocked ? EQuestStatus::UNLOCKED : EQuestStatus::LOCKED;
-	
-	return NewComparator;
-	
+
+	TArray<FQuestCommandResult> Results;
+	ApplyCommandToQuests(QuestClasses, OwnerHandleList, QuestCommand, Results);
+	return Results;
 }
 
-bool UQuestSubsystem::AddQuestComparator(FQuestComparator& Comparator, FString Owner)
+void UQuestSubsystem::ApplyCommandToQuests(TConstArrayView<TSubclassOf<UQuestObject>> QuestClasses,
+	TConstArrayView<FQuestOwnerHandle> QuestOwners, EQuestEnterCommand QuestCommand, TArray<FQuestCommandResult>& OutResults)
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::AddQuestComparator)
-	
-	if (Owner.IsEmpty()) return false;
-	if (Comparator == InvalidQuestComparator) return false;
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::ApplyCommandToQuests)
 
-	if (!EnsurePlayerEntryExists(Owner)) return false;
+	const int32 NumClasses = QuestClasses.Num();
+	OutResults.Reset();
+	OutResults.SetNum(QuestOwners.Num() * NumClasses);
 
-	TArray<FQuestComparator>& QuestComparators = Quests.Find(Owner)->GetRef();
+	for (const FQuestOwnerHandle Owner : QuestOwners)
+	{
+		if (FTArrayQuestComparator* OwnerQuests = FindOwnerQuests(Owner))
+		{
+			OwnerQuests->Reserve(OwnerQuests->Num() + NumClasses);
+		}
+	}
 
-	for (FQuestComparator& AvailableComparator : QuestComparators)
+	//Class major, everything looked up per class is shared by all owners
+	for (int32 ClassIndex = 0; ClassIndex < NumClasses; ClassIndex++)
 	{
-		if (AvailableComparator.QuestClass == Comparator.QuestClass && !AvailableComparator.QuestObject)
+		const TSubclassOf<UQuestObject> QuestClass = QuestClasses[ClassIndex];
+		if (!IsValid(QuestClass)) continue;
+
+		//Mapped quests have to be faulted in one by one, ApplyCommand takes care of that
+		const bool bUnlockRecords = QuestCommand == EQuestEnterCommand::UNLOCK && !MappedSnapshot && SupportsQuestRecords(QuestClass);
+		if (bUnlockRecords)
 		{
-			FQuestComparator NewComparator = CreateNewComparator(Comparator.QuestClass, Owner);
-			if (NewComparator == InvalidQuestComparator) return false;
-			AvailableComparator = NewComparator;
-			return true;
+			TSet<FQuestOwnerHandle>& UnlockedOwners = QuestClassOwners.FindOrAdd(QuestClass).OwnersByStatus[static_cast<int32>(EQuestStatus::UNLOCKED)];
+			UnlockedOwners.Reserve(UnlockedOwners.Num() + QuestOwners.Num());
 		}
-		else if (AvailableComparator.QuestClass == Comparator.QuestClass)
+		
+		for (int32 OwnerIndex = 0; OwnerIndex < QuestOwners.Num(); OwnerIndex++)
 		{
-			return false;
+			const FQuestOwnerHandle Owner = QuestOwners[OwnerIndex];
+			FQuestCommandResult& Result = OutResults[OwnerIndex * NumClasses + ClassIndex];
+			
+			FTArrayQuestComparator* OwnerQuests = FindOwnerQuests(Owner);
+			if (!OwnerQuests) continue;
+
+			//A quest the owner does not have yet goes straight to an unlocked record
+			if (bUnlockRecords && !OwnerQuests->Find(QuestClass))
+			{
+				FQuestComparator NewRecord;
+				NewRecord.QuestClass = QuestClass;
+				NewRecord.RecordStatus = EQuestStatus::UNLOCKED;
+				OwnerQuests->Add(NewRecord);
+				
+				//Looked up again every time, commands on existing quest objects can run blueprint code adding quest classes
+				QuestClassOwners.FindChecked(QuestClass).OwnersByStatus[static_cast<int32>(EQuestStatus::UNLOCKED)].Add(Owner);
+				MarkQuestChanged(Owner, QuestClass);
+				
+				Result.bSuccess = true;
+				Result.Status = EQuestStatus::UNLOCKED;
+				continue;
+			}
+
+			Result.bSuccess = ApplyCommand(QuestClass, Owner, QuestCommand);
+			Result.Status = GetQuestStatus(QuestClass, Owner);
 		}
 	}
-
-	QuestComparators.Add(Comparator);
-	return true;
 }
 
-TArray<UQuestObject*> UQuestSubsystem::GetQuestObjects(FString QuestsOwner) const
+FString UQuestSubsystem::GetQuestOwner(TSubclassOf<UQuestObject> QuestClass) const
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::GetQuestObject)
-	if (!Quests.Find(QuestsOwner)) return {};
-
-	TArray<UQuestObject*> QuestObjects = TArray<UQuestObject*>();
-	QuestObjects.Reserve(Quests.Find(QuestsOwner)->Get().Num());
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::GetQuestOwner)
+	QUEST_COUNTER_ADD(Lookups, 1);
 	
-	for (auto QuestComparator : Quests.Find(QuestsOwner)->Get())
+	if (const FQuestClassOwners* ClassOwners = QuestClassOwners.Find(QuestClass))
 	{
-		QuestObjects.Add(QuestComparator.QuestObject);
+		for (int32 Status = static_cast<int32>(EQuestStatus::UNLOCKED); Status < QuestStatusCount; Status++)
+		{
+			const TSet<FQuestOwnerHandle>& Owners = ClassOwners->OwnersByStatus[Status];
+			if (Owners.Num() > 0)
+			{
+				return GetOwnerName(*Owners.CreateConstIterator());
+			}
+		}
 	}
 
-	return QuestObjects;
-}
+	FQuestOwnerHandle MappedOwner;
+	ForEachMappedClassOwner(QuestClass, [&MappedOwner](FQuestOwnerHandle Owner, EQuestStatus Status)
+	{
+		if (Status == EQuestStatus::LOCKED) return true;
+		MappedOwner = Owner;
+		return false;
+	});
 
+	return MappedOwner.IsValid() ? GetOwnerName(MappedOwner) : "";
+}
 
-bool UQuestSubsystem::EnsurePlayerEntryExists(FString Owner)
+TArray<FString> UQuestSubsystem::GetQuestOwners(TSubclassOf<UQuestObject> QuestClass, EQuestStatus StatusFilter) const
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::EnsureControllerEntryExists)
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::GetQuestOwners)
 
-	if (Owner.IsEmpty()) return false;
-	
-	//Is Controller known, if not, add it to the array
-	if (!Quests.Find(Owner))
-	{
-		Quests.Add(Owner);
-	}
+	TArray<FQuestOwnerHandle> OwnerHandleList;
+	GetQuestOwnerHandles(QuestClass, StatusFilter, OwnerHandleList);
 
-	//Does the controller have quests, controller index == quest objects index
-	//If it has quests check for the given class
-	//otherwise create the index for quest objects
-	auto* QuestComparatorArray = Quests.Find(Owner);
-	if (QuestComparatorArray->GetRef().Num() <= 0)
+	TArray<FString> Owners;
+	Owners.Reserve(OwnerHandleList.Num());
+	for (const FQuestOwnerHandle& Owner : OwnerHandleList)
 	{
-		*QuestComparatorArray = FTArrayQuestComparator();
+		Owners.Add(GetOwnerName(Owner));
 	}
 
-	return Quests.Find(Owner) && QuestComparatorArray->GetRef().Num() >= 0;
-		
-	
-	// return OwnerIndex < Quests.QuestObjects.Num() &&
-	// 		OwnerIndex >= 0 &&
-	// 		Quests.QuestObjects.Num() >= 0;
-}
\ No newline at end of file
+	return Owners;
+}
+
+void UQuestSubsystem::GetQuestOwnerHandles(TSubclassOf<UQuestObject> QuestClass, EQuestStatus StatusFilter,
+	TArray<FQuestOwnerHandle>& OutOwners) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::GetQuestOwnerHandles)
+	QUEST_COUNTER_ADD(Lookups, 1);
+	
+	if (const FQuestClassOwners* ClassOwners = QuestClassOwners.Find(QuestClass))
+	{
+		if (StatusFilter != EQuestStatus::INVALID)
+		{
+			OutOwners.Append(ClassOwners->OwnersByStatus[static_cast<int32>(StatusFilter)].Array());
+		}
+		else
+		{
+			for (int32 Status = static_cast<int32>(EQuestStatus::UNLOCKED); Status < QuestStatusCount; Status++)
+			{
+				for (const FQuestOwnerHandle& Owner : ClassOwners->OwnersByStatus[Status])
+				{
+					OutOwners.Add(Owner);
+				}
+			}
+		}
+	}
+
+	ForEachMappedClassOwner(QuestClass, [StatusFilter, &OutOwners](FQuestOwnerHandle Owner, EQuestStatus Status)
+	{
+		if (StatusFilter == EQuestStatus::INVALID ? Status != EQuestStatus::LOCKED : Status == StatusFilter)
+		{
+			OutOwners.Add(Owner);
+		}
+		return true;
+	});
+}
+
+void UQuestSubsystem::AddProgress(const FString& QuestOwner, UQuestProgressionObject* Progressor, TSubclassOf<UQuestObject> QuestClass)
+{
+	AddProgress(FindOwnerHandle(QuestOwner), Progressor, QuestClass);
+}
+
+void UQuestSubsystem::AddProgress(FQuestOwnerHandle QuestOwner, UQuestProgressionObject* Progressor, TSubclassOf<UQuestObject> QuestClass)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::AddProgress)
+	QUEST_COUNTER_ADD(ProgressEvents, 1);
+	if (!FindOwnerQuests(QuestOwner) || !Progressor)
+	{
+		QUEST_COUNTER_ADD(DiscardedEvents, 1);
+		return;
+	}
+
+	if (!QuestClass)
+	{
+		//Only quests with an objective in progress that can take this progress get visited
+		FRoutedQuestArray RoutedQuests;
+		GetRoutedQuests(QuestOwner, Progressor->ObjectiveToProgress, RoutedQuests);
+		
+		for (UQuestObject* QuestObject : RoutedQuests)
+		{
+			if (!IsValid(QuestObject)) continue;
+			MarkQuestChanged(QuestObject);
+			QUEST_NATIVE_EVENT(QuestObject, ProgressQuest, Progressor);
+			//a quest might consume the progressor and we don't want to add more progress when it gets destroyed
+			if (!IsValid(Progressor)) break;
+		}
+		return;
+	}
+	
+	//Only quests in progress take progress, GetQuestObject would create the object of a record just to ignore it
+	UQuestObject* QuestObject = GetQuestStatus(QuestClass, QuestOwner) == EQuestStatus::IN_PROGRESS ? GetQuestObject(QuestClass, QuestOwner) : nullptr;
+	if (!IsValid(QuestObject))
+	{
+		QUEST_COUNTER_ADD(DiscardedEvents, 1);
+		return;
+	}
+	
+	MarkQuestChanged(QuestObject);
+	QUEST_NATIVE_EVENT(QuestObject, ProgressQuest, Progressor);
+}
+
+void UQuestSubsystem::AddProgressEvent(const FString& QuestOwner, const FQuestProgressEvent& Event, TSubclassOf<UQuestObject> QuestClass)
+{
+	AddProgressEvent(FindOwnerHandle(QuestOwner), Event, QuestClass);
+}
+
+void UQuestSubsystem::AddProgressEvent(FQuestOwnerHandle QuestOwner, const FQuestProgressEvent& Event, TSubclassOf<UQuestObject> QuestClass)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::AddProgressEvent)
+	QUEST_COUNTER_ADD(ProgressEvents, 1);
+	if (!FindOwnerQuests(QuestOwner) || !Event.ObjectiveToProgress)
+	{
+		QUEST_COUNTER_ADD(DiscardedEvents, 1);
+		return;
+	}
+
+	if (QuestClass)
+	{
+		//Same as AddProgress, records and quests that are not in progress don't take the event
+		if (GetQuestStatus(QuestClass, QuestOwner) != EQuestStatus::IN_PROGRESS)
+		{
+			QUEST_COUNTER_ADD(DiscardedEvents, 1);
+			return;
+		}
+		
+		if (UQuestObject* QuestObject = GetQuestObject(QuestClass, QuestOwner); IsValid(QuestObject))
+		{
+			MarkQuestChanged(QuestObject);
+			QUEST_NATIVE_EVENT(QuestObject, ProgressQuestEvent, Event);
+		}
+		return;
+	}
+
+	FRoutedQuestArray RoutedQuests;
+	GetRoutedQuests(QuestOwner, Event.ObjectiveToProgress, RoutedQuests);
+	
+	for (UQuestObject* QuestObject : RoutedQuests)
+	{
+		if (!IsValid(QuestObject)) continue;
+		MarkQuestChanged(QuestObject);
+		if (QUEST_NATIVE_EVENT(QuestObject, ProgressQuestEvent, Event)) break;
+	}
+}
+
+void UQuestSubsystem::AddProgressBatch(const FString& QuestOwner, const TArray<FQuestProgressEvent>& Events)
+{
+	AddProgressBatch(FindOwnerHandle(QuestOwner), Events);
+}
+
+void UQuestSubsystem::AddProgressBatch(FQuestOwnerHandle QuestOwner, TConstArrayView<FQuestProgressEvent> Events)
+{
+	AddProgressBatchInternal(QuestOwner, Events, true);
+}
+
+void UQuestSubsystem::AddProgressBatchInternal(FQuestOwnerHandle QuestOwner, TConstArrayView<FQuestProgressEvent> Events, bool bGroupByClass)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::AddProgressBatch)
+	QUEST_COUNTER_ADD(ProgressEvents, Events.Num());
+	if (!FindOwnerQuests(QuestOwner))
+	{
+		QUEST_COUNTER_ADD(DiscardedEvents, Events.Num());
+		return;
+	}
+	if (Events.Num() == 0) return;
+
+	//Grouped by objective class so every group looks up its route once. Groups follow the order the classes first
+	//appear in, not their addresses, so every run applies the events in the same order. The order within a class is kept
+	TArray<const UClass*, TInlineAllocator<8>> ObjectiveClasses;
+	TArray<int32, TInlineAllocator<64>> EventGroups;
+	TArray<int32, TInlineAllocator<64>> EventOrder;
+	if (bGroupByClass) EventGroups.SetNumUninitialized(Events.Num());
+	EventOrder.Reserve(Events.Num());
+	for (int32 EventIndex = 0; EventIndex < Events.Num(); EventIndex++)
+	{
+		if (!Events[EventIndex].ObjectiveToProgress) continue;
+		
+		if (bGroupByClass) EventGroups[EventIndex] = ObjectiveClasses.AddUnique(Events[EventIndex].ObjectiveToProgress.Get());
+		EventOrder.Add(EventIndex);
+	}
+	
+	//Without grouping every run of events with the same class looks its route up once
+	if (bGroupByClass)
+	{
+		EventOrder.StableSort([&EventGroups](int32 A, int32 B)
+		{
+			return EventGroups[A] < EventGroups[B];
+		});
+	}
+
+	//Last progression object applied to each affected quest, for its single broadcast
+	TArray<UQuestObject*, TInlineAllocator<16>> AffectedQuests;
+	TArray<UQuestProgressionObject*, TInlineAllocator<16>> AffectedProgress;
+	FRoutedQuestArray RoutedQuests;
+	
+	int32 GroupStart = 0;
+	while (GroupStart < EventOrder.Num())
+	{
+		const UClass* ObjectiveClass = Events[EventOrder[GroupStart]].ObjectiveToProgress;
+		uint32 RoutesVersion = ProgressRoutesVersion;
+		RoutedQuests.Reset();
+		GetRoutedQuests(QuestOwner, ObjectiveClass, RoutedQuests);
+
+		//Quests below NumVisited are already marked as changed and affected for this route
+		int32 NumVisited = 0;
+		int32 GroupEnd = GroupStart;
+		for (; GroupEnd < EventOrder.Num(); GroupEnd++)
+		{
+			const FQuestProgressEvent& Event = Events[EventOrder[GroupEnd]];
+			if (Event.ObjectiveToProgress.Get() != ObjectiveClass) break;
+
+			//An earlier event may have finished objectives and changed the route
+			if (RoutesVersion != ProgressRoutesVersion)
+			{
+				RoutesVersion = ProgressRoutesVersion;
+				RoutedQuests.Reset();
+				GetRoutedQuests(QuestOwner, ObjectiveClass, RoutedQuests);
+				NumVisited = 0;
+			}
+
+			for (int32 QuestIndex = 0; QuestIndex < RoutedQuests.Num(); QuestIndex++)
+			{
+				UQuestObject* QuestObject = RoutedQuests[QuestIndex];
+				if (!IsValid(QuestObject)) continue;
+
+				//Blueprint overrides get every event on their own, the way AddProgressEvent passes it
+				const bool bNative = QuestNativeDispatch::IsNative(QuestObject, EQuestNativeEvent::ProgressQuestEvent);
+				if (QuestIndex >= NumVisited)
+				{
+					if (bNative && !AffectedQuests.Contains(QuestObject))
+					{
+						AffectedQuests.Add(QuestObject);
+						AffectedProgress.Add(nullptr);
+					}
+					MarkQuestChanged(QuestObject);
+					NumVisited = QuestIndex + 1;
+				}
+				
+				if (!bNative)
+				{
+					if (QuestObject->ProgressQuestEvent(Event)) break;
+					continue;
+				}
+
+				if (Event.ProgressionObject) AffectedProgress[AffectedQuests.Find(QuestObject)] = Event.ProgressionObject;
+				if (QuestObject->ApplyProgressEvent(Event)) break;
+			}
+		}
+		
+		GroupStart = GroupEnd;
+	}
+
+	for (int32 AffectedIndex = 0; AffectedIndex < AffectedQuests.Num(); AffectedIndex++)
+	{
+		if (!IsValid(AffectedQuests[AffectedIndex])) continue;
+		AffectedQuests[AffectedIndex]->EndProgressBatch(AffectedProgress[AffectedIndex]);
+	}
+}
+
+bool UQuestSubsystem::EnqueueProgress(const FString& QuestOwner, const FQuestProgressEvent& Event)
+{
+	return EnqueueProgressInternal(FQuestDeferredProgress{FQuestOwnerHandle(), QuestOwner, Event});
+}
+
+bool UQuestSubsystem::EnqueueProgress(FQuestOwnerHandle QuestOwner, const FQuestProgressEvent& Event)
+{
+	return EnqueueProgressInternal(FQuestDeferredProgress{QuestOwner, FString(), Event});
+}
+
+bool UQuestSubsystem::EnqueueProgressInternal(FQuestDeferredProgress&& Progress)
+{
+	//The pending count is claimed before enqueueing, concurrent producers can't overshoot the limit
+	int64 Pending = DeferredPending.load(std::memory_order_relaxed);
+	do
+	{
+		if (MaxDeferredProgressPending > 0 && Pending >= MaxDeferredProgressPending)
+		{
+			DeferredRejected.fetch_add(1, std::memory_order_relaxed);
+			QUEST_COUNTER_ADD(DiscardedEvents, 1);
+			return false;
+		}
+	}
+	while (!DeferredPending.compare_exchange_weak(Pending, Pending + 1, std::memory_order_relaxed));
+
+	if (!DeferredProgress.Enqueue(MoveTemp(Progress)))
+	{
+		DeferredPending.fetch_sub(1, std::memory_order_relaxed);
+		DeferredRejected.fetch_add(1, std::memory_order_relaxed);
+		QUEST_COUNTER_ADD(DiscardedEvents, 1);
+		return false;
+	}
+	
+	DeferredEnqueued.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+void UQuestSubsystem::DrainDeferredProgress()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::DrainDeferredProgress)
+	QUEST_SCOPE_CYCLE_COUNTER(DrainDeferredProgress);
+	check(IsInGameThread());
+	
+	DeferredPeakPending = FMath::Max(DeferredPeakPending, DeferredPending.load(std::memory_order_relaxed));
+	
+	const int32 Budget = MaxDeferredProgressPerFrame > 0 ? MaxDeferredProgressPerFrame : MAX_int32;
+	DrainedProgress.Reset();
+
+	FQuestDeferredProgress Progress;
+	while (DrainedProgress.Num() < Budget && DeferredProgress.Dequeue(Progress))
+	{
+		if (!Progress.Owner.IsValid())
+		{
+			Progress.Owner = FindOwnerHandle(Progress.OwnerName);
+		}
+		DrainedProgress.Add(MoveTemp(Progress));
+	}
+
+	if (DrainedProgress.Num() == 0) return;
+	
+	DeferredPending.fetch_sub(DrainedProgress.Num(), std::memory_order_relaxed);
+	DeferredProcessed += DrainedProgress.Num();
+	if (DrainedProgress.Num() >= Budget && !DeferredProgress.IsEmpty())
+	{
+		DeferredSaturatedFrames++;
+	}
+
+	//One batch per owner, stable so the order of the queue is kept within an owner
+	DrainedProgress.StableSort([](const FQuestDeferredProgress& A, const FQuestDeferredProgress& B)
+	{
+		return A.Owner.GetIndex() < B.Owner.GetIndex();
+	});
+
+	int32 RunStart = 0;
+	while (RunStart < DrainedProgress.Num())
+	{
+		const FQuestOwnerHandle Owner = DrainedProgress[RunStart].Owner;
+		
+		DrainedBatch.Reset();
+		int32 RunEnd = RunStart;
+		while (RunEnd < DrainedProgress.Num() && DrainedProgress[RunEnd].Owner == Owner)
+		{
+			DrainedBatch.Add(MoveTemp(DrainedProgress[RunEnd].Event));
+			RunEnd++;
+		}
+
+		//Not regrouped by class, the events of each producer stay in the order they were queued
+		AddProgressBatchInternal(Owner, DrainedBatch, false);
+		RunStart = RunEnd;
+	}
+	
+	DrainedBatch.Reset();
+	DrainedProgress.Reset();
+}
+
+FQuestDeferredProgressStats UQuestSubsystem::GetDeferredProgressStats() const
+{
+	FQuestDeferredProgressStats Stats;
+	Stats.Enqueued = DeferredEnqueued.load(std::memory_order_relaxed);
+	Stats.Processed = DeferredProcessed;
+	Stats.Rejected = DeferredRejected.load(std::memory_order_relaxed);
+	Stats.Pending = DeferredPending.load(std::memory_order_relaxed);
+	Stats.PeakPending = DeferredPeakPending;
+	Stats.SaturatedFrames = DeferredSaturatedFrames;
+	return Stats;
+}
+
+void UQuestSubsystem::ClearQuests()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::ClearQuests)
+	//Owner handles stay valid, only their quests get dropped
+	for (int32 OwnerIndex = 0; OwnerIndex < Quests.Num(); OwnerIndex++)
+	{
+		if (IsQuestJournalEnabled() || IsQuestDeltaTrackingEnabled())
+		{
+			ForEachMappedOwnerQuest(FQuestOwnerHandle(OwnerIndex), [this, OwnerIndex](TSubclassOf<UQuestObject> QuestClass, const FQuestMappedSnapshot::FQuest&)
+			{
+				MarkQuestChanged(FQuestOwnerHandle(OwnerIndex), QuestClass);
+			});
+		}
+		
+		for (const FQuestComparator& Comparator : Quests[OwnerIndex].GetView())
+		{
+			MarkQuestChanged(FQuestOwnerHandle(OwnerIndex), Comparator.QuestClass);
+		}
+		Quests[OwnerIndex] = FTArrayQuestComparator();
+	}
+	UnmountQuestSnapshot();
+	QuestClassOwners.Empty();
+	ProgressRoutes.Empty();
+	ProgressRoutesVersion++;
+	QuestTickManager.Reset();
+}
+
+void UQuestSubsystem::SaveQuests(const FString& SlotName)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::SaveQuests)
+	
+	TWeakObjectPtr<UQuestSubsystem> WeakThis(this);
+	SaveQuestsToFileAsync(GetQuestSaveFilePath(SlotName), [WeakThis, SlotName](bool bSuccess)
+	{
+		UQuestSubsystem* QuestSubsystem = WeakThis.Get();
+		if (QuestSubsystem && QuestSubsystem->OnQuestsSavedDelegate.IsBound())
+		{
+			QuestSubsystem->OnQuestsSavedDelegate.Broadcast(SlotName, bSuccess);
+		}
+	});
+}
+
+bool UQuestSubsystem::LoadQuests(const FString& SlotName)
+{
+	return LoadQuestsFromFile(GetQuestSaveFilePath(SlotName));
+}
+
+bool UQuestSubsystem::DoesQuestSaveExist(const FString& SlotName) const
+{
+	return IFileManager::Get().FileExists(*GetQuestSaveFilePath(SlotName));
+}
+
+bool UQuestSubsystem::SaveQuestsToMemory(TArray<uint8>& OutData) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::SaveQuestsToMemory)
+	
+	FQuestSaveSnapshot Snapshot;
+	CreateSaveSnapshot(Snapshot);
+
+	FMemoryWriter Writer(OutData, true);
+	Writer << Snapshot;
+	return !Writer.IsError();
+}
+
+bool UQuestSubsystem::LoadQuestsFromMemory(const TArray<uint8>& Data)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::LoadQuestsFromMemory)
+	
+	FQuestSaveSnapshot Snapshot;
+	FMemoryReader Reader(Data, true);
+	Reader << Snapshot;
+	if (Reader.IsError()) return false;
+
+	return ApplySaveSnapshot(Snapshot);
+}
+
+TFuture<bool> UQuestSubsystem::SaveQuestsToFileAsync(const FString& FilePath, TUniqueFunction<void(bool)>&& OnSaved)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::SaveQuestsToFileAsync)
+	
+	FQuestSaveSnapshot Snapshot;
+	CreateSaveSnapshot(Snapshot);
+
+	TPromise<bool> Promise;
+	TFuture<bool> Future = Promise.GetFuture();
+	QuestSave::WritePipe.Launch(TEXT("QuestSaveSnapshot"),
+		[Snapshot = MoveTemp(Snapshot), FilePath, OnSaved = MoveTemp(OnSaved), Promise = MoveTemp(Promise)]() mutable
+		{
+			const bool bSuccess = QuestSave::WriteSnapshot(Snapshot, FilePath);
+			if (OnSaved)
+			{
+				AsyncTask(ENamedThreads::GameThread, [OnSaved = MoveTemp(OnSaved), bSuccess]()
+				{
+					OnSaved(bSuccess);
+				});
+			}
+			Promise.SetValue(bSuccess);
+		});
+
+	return Future;
+}
+
+bool UQuestSubsystem::LoadQuestsFromFile(const FString& FilePath)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::LoadQuestsFromFile)
+	
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *FilePath, FILEREAD_Silent)) return false;
+
+	return LoadQuestsFromMemory(Data);
+}
+
+void UQuestSubsystem::CreateSaveSnapshot(FQuestSaveSnapshot& OutSnapshot) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::CreateSaveSnapshot)
+	check(IsInGameThread());
+
+	TMap<const UClass*, int32> ClassIndices;
+	TMap<const UClass*, bool> SaveGameClasses;
+
+	auto GetClassIndex = [&ClassIndices, &OutSnapshot](const UClass* QuestClass)
+	{
+		int32& ClassIndex = ClassIndices.FindOrAdd(QuestClass, INDEX_NONE);
+		if (ClassIndex == INDEX_NONE)
+		{
+			ClassIndex = OutSnapshot.QuestClasses.Add(QuestClass->GetPathName());
+		}
+		return ClassIndex;
+	};
+	
+	OutSnapshot.Owners.Reset(Quests.Num());
+	for (int32 OwnerIndex = 0; OwnerIndex < Quests.Num(); OwnerIndex++)
+	{
+		FQuestOwnerSaveRecord OwnerRecord;
+		FillOwnerSaveRecord(FQuestOwnerHandle(OwnerIndex), OwnerRecord, GetClassIndex, SaveGameClasses);
+
+		if (OwnerRecord.Quests.Num() > 0)
+		{
+			OutSnapshot.Owners.Add(MoveTemp(OwnerRecord));
+		}
+	}
+}
+
+void UQuestSubsystem::FillOwnerSaveRecord(FQuestOwnerHandle Owner, FQuestOwnerSaveRecord& OutRecord,
+	TFunctionRef<int32(const UClass*)> GetClassIndex, TMap<const UClass*, bool>& SaveGameClasses) const
+{
+	const FTArrayQuestComparator* OwnerQuests = FindOwnerQuests(Owner);
+	if (!OwnerQuests) return;
+	
+	const TConstArrayView<FQuestComparator> Comparators = OwnerQuests->GetView();
+	OutRecord.Owner = OwnerNames[Owner.GetIndex()];
+	OutRecord.Quests.Reserve(Comparators.Num());
+
+	for (const FQuestComparator& Comparator : Comparators)
+	{
+		//Released quests leave an empty slot behind
+		const EQuestStatus Status = Comparator.GetStatus();
+		if (!Comparator.QuestClass || Status == EQuestStatus::INVALID) continue;
+
+		FQuestSaveRecord& QuestRecord = OutRecord.Quests.AddDefaulted_GetRef();
+		QuestRecord.ClassIndex = GetClassIndex(Comparator.QuestClass);
+		FillQuestSaveRecord(Comparator, QuestRecord, SaveGameClasses);
+	}
+
+	//Untouched quests of a mounted snapshot get copied as they are
+	ForEachMappedOwnerQuest(Owner,
+		[this, &OutRecord, &GetClassIndex](TSubclassOf<UQuestObject> QuestClass, const FQuestMappedSnapshot::FQuest& MappedQuest)
+		{
+			FQuestSaveRecord QuestRecord;
+			if (MappedQuest.GetStatus() == EQuestStatus::INVALID || !MappedSnapshot->ReadQuest(MappedQuest, QuestRecord)) return;
+			
+			QuestRecord.ClassIndex = GetClassIndex(QuestClass);
+			OutRecord.Quests.Add(MoveTemp(QuestRecord));
+		});
+}
+
+void UQuestSubsystem::FillQuestSaveRecord(const FQuestComparator& Comparator, FQuestSaveRecord& OutRecord,
+	TMap<const UClass*, bool>& SaveGameClasses) const
+{
+	OutRecord.Status = Comparator.GetStatus();
+	
+	UQuestObject* QuestObject = Comparator.QuestObject;
+	if (!IsValid(QuestObject)) return;
+
+	if (QuestSave::HasSaveGameProperties(QuestObject->GetClass(), SaveGameClasses))
+	{
+		QuestSave::WriteSaveGameProperties(QuestObject, OutRecord.SaveGameData);
+	}
+
+	OutRecord.Objectives.SetNum(QuestObject->QuestObjectives.Num());
+	for (int32 i = 0; i < QuestObject->QuestObjectives.Num(); i++)
+	{
+		UQuestObjective* Objective = QuestObject->QuestObjectives[i];
+		if (!Objective) continue;
+
+		FQuestObjectiveSaveRecord& ObjectiveRecord = OutRecord.Objectives[i];
+		ObjectiveRecord.Status = Objective->Status;
+		if (QuestSave::HasSaveGameProperties(Objective->GetClass(), SaveGameClasses))
+		{
+			QuestSave::WriteSaveGameProperties(Objective, ObjectiveRecord.SaveGameData);
+		}
+	}
+}
+
+void UQuestSubsystem::FillQuestSaveRecord(FQuestOwnerHandle Owner, const UClass* QuestClass, FQuestSaveRecord& OutRecord,
+	TMap<const UClass*, bool>& SaveGameClasses) const
+{
+	const FTArrayQuestComparator* OwnerQuests = FindOwnerQuests(Owner);
+	if (const FQuestComparator* Comparator = OwnerQuests ? OwnerQuests->Find(QuestClass) : nullptr)
+	{
+		FillQuestSaveRecord(*Comparator, OutRecord, SaveGameClasses);
+	}
+	else if (const FQuestMappedSnapshot::FQuest* MappedQuest = FindMappedQuest(Owner, QuestClass))
+	{
+		const int32 ClassIndex = OutRecord.ClassIndex;
+		if (!MappedSnapshot->ReadQuest(*MappedQuest, OutRecord)) OutRecord = FQuestSaveRecord();
+		OutRecord.ClassIndex = ClassIndex;
+	}
+}
+
+bool UQuestSubsystem::ApplySaveSnapshot(const FQuestSaveSnapshot& Snapshot)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::ApplySaveSnapshot)
+
+	//Restoring is no change worth journaling, the journal starts over from the loaded state below
+	TGuardValue<bool> SuspendChanges(bQuestChangesSuspended, true);
+	ClearQuests();
+
+	TArray<TSubclassOf<UQuestObject>> QuestClasses;
+	QuestClasses.Reserve(Snapshot.QuestClasses.Num());
+	for (const FString& ClassPath : Snapshot.QuestClasses)
+	{
+		QuestClasses.Add(FSoftClassPath(ClassPath).TryLoadClass<UQuestObject>());
+	}
+
+	for (const FQuestOwnerSaveRecord& OwnerRecord : Snapshot.Owners)
+	{
+		const FQuestOwnerHandle Owner = FindOrAddOwnerHandle(OwnerRecord.Owner);
+		FTArrayQuestComparator* OwnerQuests = FindOwnerQuests(Owner);
+		if (!OwnerQuests) continue;
+		
+		OwnerQuests->Reserve(OwnerRecord.Quests.Num());
+		for (const FQuestSaveRecord& QuestRecord : OwnerRecord.Quests)
+		{
+			//Quest classes that don't exist anymore get dropped
+			if (!QuestClasses.IsValidIndex(QuestRecord.ClassIndex) || !QuestClasses[QuestRecord.ClassIndex]) continue;
+			
+			RestoreQuest(Owner, QuestClasses[QuestRecord.ClassIndex], QuestRecord);
+		}
+	}
+
+	if (IsQuestJournalEnabled())
+	{
+		CompactQuestJournal();
+	}
+	ResetQuestDeltas();
+
+	return true;
+}
+
+FString UQuestSubsystem::GetQuestSaveFilePath(const FString& SlotName)
+{
+	return FPaths::ProjectSavedDir() / TEXT("QuestSystem") / SlotName + TEXT(".quests");
+}
+
+void UQuestSubsystem::EnableQuestJournal(const FString& SlotName)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::EnableQuestJournal)
+	if (SlotName.IsEmpty()) return;
+	
+	DisableQuestJournal();
+	JournalSlot = SlotName;
+	
+	//The journal only makes sense on top of a snapshot of the current state
+	CompactQuestJournal();
+}
+
+void UQuestSubsystem::DisableQuestJournal()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::DisableQuestJournal)
+	if (!IsQuestJournalEnabled()) return;
+	
+	FlushQuestJournal();
+	JournalSlot.Empty();
+	JournalChangedQuests.Empty();
+}
+
+void UQuestSubsystem::FlushQuestJournal()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::FlushQuestJournal)
+	QUEST_SCOPE_CYCLE_COUNTER(JournalFlush);
+	
+	JournalFlushTimer = 0.f;
+	if (!IsQuestJournalEnabled() || JournalChangedQuests.Num() == 0) return;
+
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data, true);
+
+	//The header is written by the pipe, it knows whether the compaction before succeeded
+	const bool bStartJournal = bStartNewJournal;
+	bStartNewJournal = false;
+
+	TMap<const UClass*, bool> SaveGameClasses;
+	for (const FQuestJournalKey& ChangedQuest : JournalChangedQuests)
+	{
+		const FQuestOwnerHandle Owner = ChangedQuest.Key;
+		const UClass* QuestClass = ChangedQuest.Value;
+		
+		if (!JournalOwners.Contains(Owner.GetIndex()))
+		{
+			JournalOwners.Add(Owner.GetIndex());
+			FQuestJournal::WriteOwner(Writer, Owner.GetIndex(), GetOwnerName(Owner));
+		}
+		
+		const int32* ClassId = JournalClasses.Find(QuestClass);
+		if (!ClassId)
+		{
+			ClassId = &JournalClasses.Add(QuestClass, JournalClasses.Num());
+			FQuestJournal::WriteQuestClass(Writer, *ClassId, QuestClass->GetPathName());
+		}
+
+		//Released and cleared quests keep the INVALID status, replaying drops them
+		FQuestSaveRecord Record;
+		Record.ClassIndex = *ClassId;
+		FillQuestSaveRecord(Owner, QuestClass, Record, SaveGameClasses);
+		FQuestJournal::WriteQuest(Writer, Owner.GetIndex(), Record);
+	}
+	JournalChangedQuests.Reset();
+
+	QuestSave::WritePipe.Launch(TEXT("QuestJournalAppend"),
+		[Data = MoveTemp(Data), FilePath = GetQuestJournalFilePath(JournalSlot), bStartJournal, SnapshotWritten = JournalSnapshotWritten]() mutable
+		{
+			if (!QuestSave::AppendJournal(Data, FilePath, bStartJournal, *SnapshotWritten))
+			{
+				UE_LOG(LogQuestSystem, Error, TEXT("Failed to append %d bytes to the quest journal %s"), Data.Num(), *FilePath);
+			}
+		});
+}
+
+void UQuestSubsystem::CompactQuestJournal()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::CompactQuestJournal)
+	if (!IsQuestJournalEnabled()) return;
+
+	//The next batch starts a new journal if the snapshot gets written. Pending changes stay pending, the old journal
+	//has to keep them if it fails. Quest entries hold the whole quest, replaying them on the new snapshot is harmless
+	JournalOwners.Reset();
+	JournalClasses.Reset();
+	bStartNewJournal = true;
+	JournalSnapshotWritten = MakeShared<bool, ESPMode::ThreadSafe>(false);
+
+	FQuestSaveSnapshot Snapshot;
+	CreateSaveSnapshot(Snapshot);
+	
+	QuestSave::WritePipe.Launch(TEXT("QuestJournalCompact"),
+		[Snapshot = MoveTemp(Snapshot), SnapshotPath = GetQuestSaveFilePath(JournalSlot), JournalPath = GetQuestJournalFilePath(JournalSlot),
+			SnapshotWritten = JournalSnapshotWritten]() mutable
+		{
+			*SnapshotWritten = QuestSave::WriteSnapshot(Snapshot, SnapshotPath);
+			if (*SnapshotWritten)
+			{
+				IFileManager::Get().Delete(*JournalPath, false, false, true);
+			}
+			else
+			{
+				UE_LOG(LogQuestSystem, Error, TEXT("Failed to write the quest snapshot %s, the journal is kept"), *SnapshotPath);
+			}
+		});
+}
+
+bool UQuestSubsystem::RecoverQuests(const FString& SlotName)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::RecoverQuests)
+	
+	FQuestSaveSnapshot Snapshot;
+	
+	TArray<uint8> Data;
+	const bool bHasSnapshot = FFileHelper::LoadFileToArray(Data, *GetQuestSaveFilePath(SlotName), FILEREAD_Silent);
+	if (bHasSnapshot)
+	{
+		FMemoryReader Reader(Data, true);
+		Reader << Snapshot;
+		if (Reader.IsError()) return false;
+	}
+
+	Data.Reset();
+	const bool bHasJournal = FFileHelper::LoadFileToArray(Data, *GetQuestJournalFilePath(SlotName), FILEREAD_Silent)
+		&& FQuestJournal::Replay(Data, Snapshot);
+	
+	if (!bHasSnapshot && !bHasJournal) return false;
+
+	return ApplySaveSnapshot(Snapshot);
+}
+
+FString UQuestSubsystem::GetQuestJournalFilePath(const FString& SlotName)
+{
+	return FPaths::ProjectSavedDir() / TEXT("QuestSystem") / SlotName + TEXT(".journal");
+}
+
+void UQuestSubsystem::WaitForQuestWrites()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::WaitForQuestWrites)
+	
+	//The pipe runs its tasks in order, an empty one finishes after all of them
+	QuestSave::WritePipe.Launch(TEXT("QuestWriteFence"), []() {}).Wait();
+}
+
+void UQuestSubsystem::SaveQuestSnapshot(const FString& SlotName)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::SaveQuestSnapshot)
+
+	//Replacing the file would pull the mapped memory away from under the unrestored quests
+	if (MappedSnapshot && MappedSnapshotSlot == SlotName)
+	{
+		UE_LOG(LogQuestSystem, Warning, TEXT("Can't save the quest snapshot to %s, the slot is currently mounted"), *SlotName);
+		OnQuestsSavedDelegate.Broadcast(SlotName, false);
+		return;
+	}
+	
+	FQuestSaveSnapshot Snapshot;
+	CreateSaveSnapshot(Snapshot);
+
+	TWeakObjectPtr<UQuestSubsystem> WeakThis(this);
+	QuestSave::WritePipe.Launch(TEXT("QuestMappedSnapshot"),
+		[Snapshot = MoveTemp(Snapshot), FilePath = GetQuestSnapshotFilePath(SlotName), WeakThis, SlotName]()
+		{
+			TArray<uint8> Data;
+			FQuestMappedSnapshot::Write(Snapshot, Data);
+			
+			const FString TempFilePath = FilePath + TEXT(".tmp");
+			const bool bSuccess = FFileHelper::SaveArrayToFile(Data, *TempFilePath) && IFileManager::Get().Move(*FilePath, *TempFilePath, true);
+			
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, SlotName, bSuccess]()
+			{
+				UQuestSubsystem* QuestSubsystem = WeakThis.Get();
+				if (QuestSubsystem && QuestSubsystem->OnQuestsSavedDelegate.IsBound())
+				{
+					QuestSubsystem->OnQuestsSavedDelegate.Broadcast(SlotName, bSuccess);
+				}
+			});
+		});
+}
+
+bool UQuestSubsystem::MountQuestSnapshot(const FString& SlotName)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::MountQuestSnapshot)
+	
+	TUniquePtr<FQuestMappedSnapshot> Snapshot = FQuestMappedSnapshot::Open(GetQuestSnapshotFilePath(SlotName));
+	if (!Snapshot) return false;
+
+	{
+		TGuardValue<bool> SuspendChanges(bQuestChangesSuspended, true);
+		ClearQuests();
+		MappedSnapshot = MoveTemp(Snapshot);
+		MappedSnapshotSlot = SlotName;
+
+		MappedClasses.Reserve(MappedSnapshot->NumClasses());
+		for (int32 ClassIndex = 0; ClassIndex < MappedSnapshot->NumClasses(); ClassIndex++)
+		{
+			//Quest classes that don't exist anymore stay unresolved, their quests are ignored
+			TSubclassOf<UQuestObject> QuestClass = FSoftClassPath(MappedSnapshot->GetClassPath(ClassIndex)).TryLoadClass<UQuestObject>();
+			MappedClasses.Add(QuestClass);
+			if (QuestClass) MappedClassIndices.Add(QuestClass, ClassIndex);
+		}
+
+		MappedOwners.Reserve(MappedSnapshot->NumOwners());
+		for (int32 OwnerIndex = 0; OwnerIndex < MappedSnapshot->NumOwners(); OwnerIndex++)
+		{
+			MappedOwners.Add(FindOrAddOwnerHandle(MappedSnapshot->GetOwnerName(OwnerIndex)));
+		}
+
+		MappedOwnerIndices.Init(INDEX_NONE, OwnerNames.Num());
+		for (int32 OwnerIndex = 0; OwnerIndex < MappedOwners.Num(); OwnerIndex++)
+		{
+			if (MappedOwners[OwnerIndex].IsValid()) MappedOwnerIndices[MappedOwners[OwnerIndex].GetIndex()] = OwnerIndex;
+		}
+
+		//Running quests need to tick and take progress, they get restored right away
+		for (const FQuestOwnerHandle& Owner : MappedOwners)
+		{
+			TArray<TSubclassOf<UQuestObject>, TInlineAllocator<16>> RunningQuests;
+			ForEachMappedOwnerQuest(Owner, [&RunningQuests](TSubclassOf<UQuestObject> QuestClass, const FQuestMappedSnapshot::FQuest& MappedQuest)
+			{
+				if (MappedQuest.GetStatus() == EQuestStatus::IN_PROGRESS) RunningQuests.Add(QuestClass);
+			});
+
+			for (const TSubclassOf<UQuestObject>& QuestClass : RunningQuests)
+			{
+				FaultInMappedQuest(QuestClass, Owner);
+			}
+		}
+	}
+
+	if (IsQuestJournalEnabled())
+	{
+		CompactQuestJournal();
+	}
+	ResetQuestDeltas();
+
+	return true;
+}
+
+FString UQuestSubsystem::GetQuestSnapshotFilePath(const FString& SlotName)
+{
+	return FPaths::ProjectSavedDir() / TEXT("QuestSystem") / SlotName + TEXT(".questmap");
+}
+
+void UQuestSubsystem::EnableQuestDeltaTracking()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::EnableQuestDeltaTracking)
+	
+	//A new epoch invalidates every version handed out before, nothing else needs to be tracked yet
+	const uint32 PreviousEpoch = QuestDeltaEpoch;
+	do
+	{
+		QuestDeltaEpoch = FGuid::NewGuid().A;
+	}
+	while (QuestDeltaEpoch == 0 || QuestDeltaEpoch == PreviousEpoch);
+	
+	QuestDeltaOwners.Reset();
+}
+
+void UQuestSubsystem::DisableQuestDeltaTracking()
+{
+	QuestDeltaEpoch = 0;
+	QuestDeltaOwners.Empty();
+}
+
+bool UQuestSubsystem::CreateQuestDelta(FQuestOwnerHandle Owner, const FQuestDeltaVersion& Acknowledged, FQuestDelta& OutDelta) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::CreateQuestDelta)
+	
+	OutDelta = FQuestDelta();
+	if (!IsQuestDeltaTrackingEnabled() || !FindOwnerQuests(Owner)) return false;
+
+	static const FQuestDeltaOwner UnchangedOwner;
+	const FQuestDeltaOwner& DeltaOwner = QuestDeltaOwners.IsValidIndex(Owner.GetIndex()) ? QuestDeltaOwners[Owner.GetIndex()] : UnchangedOwner;
+
+	OutDelta.Version.Epoch = QuestDeltaEpoch;
+	OutDelta.Version.Sequence = DeltaOwner.Sequence;
+	OutDelta.Changes.Owner = OwnerNames[Owner.GetIndex()];
+	
+	TMap<const UClass*, int32> ClassIndices;
+	TMap<const UClass*, bool> SaveGameClasses;
+	auto GetClassIndex = [&ClassIndices, &OutDelta](const UClass* QuestClass)
+	{
+		int32& ClassIndex = ClassIndices.FindOrAdd(QuestClass, INDEX_NONE);
+		if (ClassIndex == INDEX_NONE)
+		{
+			ClassIndex = OutDelta.QuestClasses.Add(QuestClass->GetPathName());
+		}
+		return ClassIndex;
+	};
+
+	OutDelta.bFullState = Acknowledged.Epoch != QuestDeltaEpoch || Acknowledged.Sequence < DeltaOwner.FirstDeltaSequence
+		|| Acknowledged.Sequence > DeltaOwner.Sequence;
+	if (OutDelta.bFullState)
+	{
+		FillOwnerSaveRecord(Owner, OutDelta.Changes, GetClassIndex, SaveGameClasses);
+		return true;
+	}
+
+	if (Acknowledged.Sequence == DeltaOwner.Sequence) return false;
+
+	OutDelta.Base = Acknowledged;
+	for (const TPair<const UClass*, uint32>& ChangedQuest : DeltaOwner.ChangedQuests)
+	{
+		if (ChangedQuest.Value <= Acknowledged.Sequence) continue;
+
+		//Removed quests keep the INVALID status
+		FQuestSaveRecord& Record = OutDelta.Changes.Quests.AddDefaulted_GetRef();
+		Record.ClassIndex = GetClassIndex(ChangedQuest.Key);
+		FillQuestSaveRecord(Owner, ChangedQuest.Key, Record, SaveGameClasses);
+	}
+	
+	return true;
+}
+
+void UQuestSubsystem::AcknowledgeQuestDelta(FQuestOwnerHandle Owner, const FQuestDeltaVersion& Acknowledged)
+{
+	if (Acknowledged.Epoch != QuestDeltaEpoch || !QuestDeltaOwners.IsValidIndex(Owner.GetIndex())) return;
+
+	FQuestDeltaOwner& DeltaOwner = QuestDeltaOwners[Owner.GetIndex()];
+	if (Acknowledged.Sequence <= DeltaOwner.FirstDeltaSequence || Acknowledged.Sequence > DeltaOwner.Sequence) return;
+
+	DeltaOwner.FirstDeltaSequence = Acknowledged.Sequence;
+	for (auto It = DeltaOwner.ChangedQuests.CreateIterator(); It; ++It)
+	{
+		if (It.Value() <= Acknowledged.Sequence) It.RemoveCurrent();
+	}
+}
+
+FQuestDeltaVersion UQuestSubsystem::GetQuestDeltaVersion(FQuestOwnerHandle Owner) const
+{
+	FQuestDeltaVersion Version;
+	Version.Epoch = QuestDeltaEpoch;
+	Version.Sequence = QuestDeltaOwners.IsValidIndex(Owner.GetIndex()) ? QuestDeltaOwners[Owner.GetIndex()].Sequence : 0;
+	return Version;
+}
+
+void UQuestSubsystem::MarkQuestDeltaChanged(FQuestOwnerHandle Owner, const UClass* QuestClass)
+{
+	if (!Owner.IsValid() || !QuestClass) return;
+	
+	if (!QuestDeltaOwners.IsValidIndex(Owner.GetIndex()))
+	{
+		QuestDeltaOwners.SetNum(Owner.GetIndex() + 1);
+	}
+
+	FQuestDeltaOwner& DeltaOwner = QuestDeltaOwners[Owner.GetIndex()];
+	DeltaOwner.ChangedQuests.Add(QuestClass, ++DeltaOwner.Sequence);
+}
+
+void UQuestSubsystem::ResetQuestDeltas()
+{
+	if (!IsQuestDeltaTrackingEnabled()) return;
+
+	QuestDeltaOwners.SetNum(OwnerNames.Num());
+	for (FQuestDeltaOwner& DeltaOwner : QuestDeltaOwners)
+	{
+		DeltaOwner.FirstDeltaSequence = ++DeltaOwner.Sequence;
+		DeltaOwner.ChangedQuests.Empty();
+	}
+}
+
+void UQuestSubsystem::UnmountQuestSnapshot()
+{
+	MappedSnapshot.Reset();
+	MappedSnapshotSlot.Empty();
+	MappedClasses.Empty();
+	MappedClassIndices.Empty();
+	MappedOwners.Empty();
+	MappedOwnerIndices.Empty();
+}
+
+const FQuestMappedSnapshot::FQuest* UQuestSubsystem::FindMappedQuest(FQuestOwnerHandle Owner, const UClass* QuestClass) const
+{
+	if (!MappedSnapshot || !MappedOwnerIndices.IsValidIndex(Owner.GetIndex())) return nullptr;
+
+	const int32 MappedOwner = MappedOwnerIndices[Owner.GetIndex()];
+	const int32* MappedClass = MappedClassIndices.Find(QuestClass);
+	if (MappedOwner == INDEX_NONE || !MappedClass) return nullptr;
+
+	//A quest that already lives in Quests hides its mapped state
+	const FTArrayQuestComparator* OwnerQuests = FindOwnerQuests(Owner);
+	if (OwnerQuests && OwnerQuests->Find(QuestClass)) return nullptr;
+	
+	return MappedSnapshot->FindQuest(MappedOwner, *MappedClass);
+}
+
+void UQuestSubsystem::ForEachMappedOwnerQuest(FQuestOwnerHandle Owner,
+	TFunctionRef<void(TSubclassOf<UQuestObject>, const FQuestMappedSnapshot::FQuest&)> Visitor) const
+{
+	if (!MappedSnapshot || !MappedOwnerIndices.IsValidIndex(Owner.GetIndex())) return;
+	
+	const int32 MappedOwner = MappedOwnerIndices[Owner.GetIndex()];
+	if (MappedOwner == INDEX_NONE) return;
+
+	const FTArrayQuestComparator* OwnerQuests = FindOwnerQuests(Owner);
+	for (const FQuestMappedSnapshot::FQuest& MappedQuest : MappedSnapshot->GetOwnerQuests(MappedOwner))
+	{
+		const TSubclassOf<UQuestObject> QuestClass = MappedClasses.IsValidIndex(MappedQuest.ClassIndex) ? MappedClasses[MappedQuest.ClassIndex] : nullptr;
+		if (!QuestClass || (OwnerQuests && OwnerQuests->Find(QuestClass))) continue;
+
+		Visitor(QuestClass, MappedQuest);
+	}
+}
+
+void UQuestSubsystem::ForEachMappedClassOwner(TSubclassOf<UQuestObject> QuestClass,
+	TFunctionRef<bool(FQuestOwnerHandle, EQuestStatus)> Visitor) const
+{
+	const int32* MappedClass = MappedSnapshot ? MappedClassIndices.Find(QuestClass) : nullptr;
+	if (!MappedClass) return;
+
+	for (const FQuestMappedSnapshot::FClassOwner& ClassOwner : MappedSnapshot->GetClassOwners(*MappedClass))
+	{
+		const FQuestMappedSnapshot::FQuest* MappedQuest = MappedSnapshot->GetQuest(ClassOwner.QuestIndex);
+		if (!MappedQuest || !MappedOwners.IsValidIndex(ClassOwner.OwnerIndex)) continue;
+
+		const FQuestOwnerHandle Owner = MappedOwners[ClassOwner.OwnerIndex];
+		const FTArrayQuestComparator* OwnerQuests = FindOwnerQuests(Owner);
+		if (!OwnerQuests || OwnerQuests->Find(QuestClass) || MappedQuest->GetStatus() == EQuestStatus::INVALID) continue;
+
+		if (!Visitor(Owner, MappedQuest->GetStatus())) return;
+	}
+}
+
+void UQuestSubsystem::FaultInMappedQuest(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner)
+{
+	const FQuestMappedSnapshot::FQuest* MappedQuest = FindMappedQuest(Owner, QuestClass);
+	if (!MappedQuest) return;
+	
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::FaultInMappedQuest)
+
+	FQuestSaveRecord Record;
+	if (!MappedSnapshot->ReadQuest(*MappedQuest, Record)) return;
+
+	//The quest only moves from the snapshot into Quests, nothing changed
+	TGuardValue<bool> SuspendChanges(bQuestChangesSuspended, true);
+	RestoreQuest(Owner, QuestClass, Record);
+}
+
+void UQuestSubsystem::FaultInMappedOwner(FQuestOwnerHandle Owner)
+{
+	TArray<TSubclassOf<UQuestObject>, TInlineAllocator<16>> MappedQuests;
+	ForEachMappedOwnerQuest(Owner, [&MappedQuests](TSubclassOf<UQuestObject> QuestClass, const FQuestMappedSnapshot::FQuest&)
+	{
+		MappedQuests.Add(QuestClass);
+	});
+
+	for (const TSubclassOf<UQuestObject>& QuestClass : MappedQuests)
+	{
+		FaultInMappedQuest(QuestClass, Owner);
+	}
+}
+
+void UQuestSubsystem::MarkQuestChanged(const UQuestObject* Quest)
+{
+	if (IsValid(Quest)) MarkQuestChanged(Quest->QuestOwnerHandle, Quest->GetClass());
+}
+
+void UQuestSubsystem::RestoreQuest(FQuestOwnerHandle Owner, TSubclassOf<UQuestObject> QuestClass, const FQuestSaveRecord& Record)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::RestoreQuest)
+	
+	FTArrayQuestComparator* OwnerQuests = FindOwnerQuests(Owner);
+	if (!OwnerQuests || OwnerQuests->Find(QuestClass) || Record.Status == EQuestStatus::INVALID) return;
+
+	const bool bKeepRecord = (Record.Status == EQuestStatus::LOCKED || Record.Status == EQuestStatus::UNLOCKED)
+		&& Record.SaveGameData.Num() == 0 && SupportsQuestRecords(QuestClass);
+	if (bKeepRecord)
+	{
+		FQuestComparator QuestRecord;
+		QuestRecord.QuestClass = QuestClass;
+		QuestRecord.RecordStatus = Record.Status;
+		OwnerQuests->Add(QuestRecord);
+		UpdateQuestOwnerIndex(QuestClass, Owner, EQuestStatus::INVALID, Record.Status);
+		return;
+	}
+
+	const FQuestComparator NewComparator = CreateNewComparator(QuestClass, Owner);
+	UQuestObject* QuestObject = NewComparator.QuestObject;
+	if (!QuestObject) return;
+	OwnerQuests->Add(NewComparator);
+
+	QuestSave::ReadSaveGameProperties(QuestObject, Record.SaveGameData);
+
+	//Objectives are matched by index, extra or missing ones of a changed quest class keep their defaults
+	const int32 NumObjectives = FMath::Min(Record.Objectives.Num(), QuestObject->QuestObjectives.Num());
+	for (int32 i = 0; i < NumObjectives; i++)
+	{
+		UQuestObjective* Objective = QuestObject->QuestObjectives[i];
+		if (!Objective) continue;
+
+		Objective->Status = Record.Objectives[i].Status;
+		QuestSave::ReadSaveGameProperties(Objective, Record.Objectives[i].SaveGameData);
+	}
+
+	QuestObject->RestoreSavedStatus(Record.Status);
+
+	//Registers tick and progress routes the same way the regular transitions do
+	OnQuestStatusChanged(QuestObject, EQuestStatus::INVALID);
+	for (UQuestObjective* Objective : QuestObject->QuestObjectives)
+	{
+		if (Objective) OnObjectiveStatusChanged(Objective, EQuestStatus::INVALID);
+	}
+}
+
+FQuestComparator UQuestSubsystem::CreateNewComparator(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner, bool AutoUnlocked)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::CreateNewComparator)
+
+	if (!QuestClass || !FindOwnerQuests(Owner))
+	{
+		InvalidQuestComparator = FQuestComparator();
+		return InvalidQuestComparator;
+	}
+	
+	TSharedRef<const FQuestDefinition> Definition = GetQuestDefinition(QuestClass);
+	
+	FQuestComparator NewComparator;
+	NewComparator.QuestObject = TakePooledQuest(QuestClass);
+	if (!NewComparator.QuestObject)
+	{
+		//Shared rewards get referenced instead of instanced for every owner
+		FObjectInstancingGraph InstancingGraph;
+		Definition->AddSharedSubobjects(InstancingGraph);
+		NewComparator.QuestObject = NewObject<UQuestObject>(this, QuestClass, NAME_None, RF_NoFlags, nullptr, false, &InstancingGraph);
+
+		//Only the definition holds them, the object keeps its runtime state. Pooled objects come back without them
+		if (Definition->bSharesRewards)
+		{
+			NewComparator.QuestObject->QuestRewards.Empty();
+			for (UQuestObjective* Objective : NewComparator.QuestObject->QuestObjectives)
+			{
+				if (Objective) Objective->ObjectiveRewards.Empty();
+			}
+		}
+	}
+	NewComparator.QuestObject->Definition = MoveTemp(Definition);
+	NewComparator.QuestClass = QuestClass;
+	NewComparator.QuestObject->QuestOwner = OwnerNames[Owner.GetIndex()];
+	NewComparator.QuestObject->QuestOwnerHandle = Owner;
+	NewComparator.QuestObject->QuestStatus = AutoUnlocked ? EQuestStatus::UNLOCKED : EQuestStatus::LOCKED;
+	
+	return NewComparator;
+	
+}
+
+TSharedRef<const FQuestDefinition> UQuestSubsystem::GetQuestDefinition(TSubclassOf<UQuestObject> QuestClass)
+{
+	if (const TSharedRef<FQuestDefinition>* Definition = QuestDefinitions.Find(QuestClass))
+	{
+		return *Definition;
+	}
+
+	return QuestDefinitions.Add(QuestClass, FQuestDefinition::Compile(QuestClass));
+}
+
+UQuestObject* UQuestSubsystem::TakePooledQuest(TSubclassOf<UQuestObject> QuestClass)
+{
+	FQuestObjectPool* Pool = QuestPools.Find(QuestClass);
+	while (Pool && Pool->Objects.Num() > 0)
+	{
+		UQuestObject* QuestObject = Pool->Objects.Pop(false);
+		if (IsValid(QuestObject)) return QuestObject;
+	}
+
+	return nullptr;
+}
+
+UQuestObject* UQuestSubsystem::MaterializeQuest(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::MaterializeQuest)
+
+	FTArrayQuestComparator* OwnerQuests = FindOwnerQuests(Owner);
+	if (!OwnerQuests || !QuestClass) return nullptr;
+
+	FQuestComparator* Comparator = OwnerQuests->Find(QuestClass);
+	if (Comparator && IsValid(Comparator->QuestObject)) return Comparator->QuestObject;
+
+	const EQuestStatus RecordStatus = Comparator ? Comparator->RecordStatus : EQuestStatus::INVALID;
+	FQuestComparator NewComparator = CreateNewComparator(QuestClass, Owner, RecordStatus == EQuestStatus::UNLOCKED);
+	if (!NewComparator.QuestObject) return nullptr;
+
+	if (!Comparator)
+	{
+		Comparator = &OwnerQuests->Add(NewComparator);
+	}
+	else
+	{
+		*Comparator = NewComparator;
+	}
+
+	//A record is already listed under its status, a lost object may still be listed under its last one
+	if (RecordStatus == EQuestStatus::INVALID)
+	{
+		RemoveFromQuestOwnerIndex(QuestClass, Owner);
+		OnQuestStatusChanged(NewComparator.QuestObject, EQuestStatus::INVALID);
+	}
+
+	return NewComparator.QuestObject;
+}
+
+bool UQuestSubsystem::SupportsQuestRecords(TSubclassOf<UQuestObject> QuestClass)
+{
+	const UQuestObject* QuestCDO = QuestClass ? QuestClass->GetDefaultObject<UQuestObject>() : nullptr;
+	if (!QuestCDO || !QuestCDO->bCreateObjectOnDemand) return false;
+
+	//A blueprint override of Unlock needs the object to run
+	const UFunction* UnlockFunction = QuestClass->FindFunctionByName(GET_FUNCTION_NAME_CHECKED(UQuestObject, Unlock));
+	if (!UnlockFunction || UnlockFunction->GetOuter() != UQuestObject::StaticClass()) return false;
+
+	//So does a native override of Unlock_Implementation, which only the native class itself can rule out
+	const UClass* NativeClass = QuestClass;
+	while (!NativeClass->HasAnyClassFlags(CLASS_Native))
+	{
+		NativeClass = NativeClass->GetSuperClass();
+	}
+	return NativeClass == QuestCDO->GetDefaultUnlockClass();
+}
+
+void UQuestSubsystem::OnQuestStatusChanged(UQuestObject* Quest, EQuestStatus OldStatus)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::OnQuestStatusChanged)
+	
+	if (!IsValid(Quest) || !Quest->QuestOwnerHandle.IsValid()) return;
+	
+	const EQuestStatus NewStatus = Quest->GetStatus();
+	if (NewStatus == OldStatus) return;
+
+	if (NewStatus == EQuestStatus::IN_PROGRESS && Quest->NeedsTick())
+	{
+		QuestTickManager.RegisterQuest(Quest);
+	}
+	else if (OldStatus == EQuestStatus::IN_PROGRESS)
+	{
+		QuestTickManager.UnregisterQuest(Quest);
+	}
+
+	UpdateQuestOwnerIndex(Quest->GetClass(), Quest->QuestOwnerHandle, OldStatus, NewStatus);
+}
+
+void UQuestSubsystem::UpdateQuestOwnerIndex(const UClass* QuestClass, FQuestOwnerHandle Owner, EQuestStatus OldStatus,
+	EQuestStatus NewStatus)
+{
+	MarkQuestChanged(Owner, QuestClass);
+	
+	FQuestClassOwners& ClassOwners = QuestClassOwners.FindOrAdd(QuestClass);
+	ClassOwners.OwnersByStatus[static_cast<int32>(OldStatus)].Remove(Owner);
+	
+	if (NewStatus != EQuestStatus::INVALID)
+	{
+		ClassOwners.OwnersByStatus[static_cast<int32>(NewStatus)].Add(Owner);
+	}
+}
+
+void UQuestSubsystem::RemoveFromQuestOwnerIndex(const UClass* QuestClass, FQuestOwnerHandle Owner)
+{
+	MarkQuestChanged(Owner, QuestClass);
+	
+	FQuestClassOwners* ClassOwners = QuestClassOwners.Find(QuestClass);
+	if (!ClassOwners) return;
+
+	for (TSet<FQuestOwnerHandle>& Owners : ClassOwners->OwnersByStatus)
+	{
+		Owners.Remove(Owner);
+	}
+}
+
+void UQuestSubsystem::OnObjectiveStatusChanged(UQuestObjective* Objective, EQuestStatus OldStatus)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::OnObjectiveStatusChanged)
+	
+	if (!IsValid(Objective)) return;
+	MarkQuestChanged(Objective->GetOwningQuestObject());
+	
+	const bool WasInProgress = OldStatus == EQuestStatus::IN_PROGRESS;
+	const bool IsInProgress = Objective->Status == EQuestStatus::IN_PROGRESS;
+	if (WasInProgress == IsInProgress) return;
+	ProgressRoutesVersion++;
+
+	if (IsInProgress && Objective->NeedsTick())
+	{
+		QuestTickManager.RegisterObjective(Objective);
+	}
+	else if (WasInProgress)
+	{
+		QuestTickManager.UnregisterObjective(Objective);
+	}
+
+	UQuestObject* Quest = Objective->GetOwningQuestObject();
+	if (!IsValid(Quest)) return;
+
+	const FTArrayQuestComparator* OwnerQuests = FindOwnerQuests(Quest->QuestOwnerHandle);
+	if (!OwnerQuests) return;
+
+	const FQuestProgressRouteKey Key(Quest->QuestOwnerHandle, Objective->GetClass());
+	
+	if (IsInProgress)
+	{
+		TArray<FQuestProgressRouteEntry>& Route = ProgressRoutes.FindOrAdd(Key);
+		if (FQuestProgressRouteEntry* Entry = Route.FindByPredicate([Quest](const FQuestProgressRouteEntry& RouteEntry) { return RouteEntry.Quest == Quest; }))
+		{
+			Entry->ActiveObjectives++;
+			return;
+		}
+
+		FQuestProgressRouteEntry NewEntry;
+		NewEntry.Quest = Quest;
+		NewEntry.StorageIndex = OwnerQuests->IndexOf(Quest->GetClass());
+		NewEntry.ActiveObjectives = 1;
+
+		int32 InsertAt = 0;
+		while (InsertAt < Route.Num() && Route[InsertAt].StorageIndex <= NewEntry.StorageIndex)
+		{
+			InsertAt++;
+		}
+		Route.Insert(NewEntry, InsertAt);
+		return;
+	}
+
+	TArray<FQuestProgressRouteEntry>* Route = ProgressRoutes.Find(Key);
+	if (!Route) return;
+
+	const int32 EntryIndex = Route->IndexOfByPredicate([Quest](const FQuestProgressRouteEntry& RouteEntry) { return RouteEntry.Quest == Quest; });
+	if (EntryIndex == INDEX_NONE) return;
+
+	if (--(*Route)[EntryIndex].ActiveObjectives <= 0)
+	{
+		Route->RemoveAt(EntryIndex);
+		if (Route->Num() == 0)
+		{
+			ProgressRoutes.Remove(Key);
+		}
+	}
+}
+
+void UQuestSubsystem::GetRoutedQuests(FQuestOwnerHandle Owner, const UClass* ObjectiveClass, FRoutedQuestArray& OutQuests) const
+{
+	const TArray<FQuestProgressRouteEntry>* Route = ProgressRoutes.Find(FQuestProgressRouteKey(Owner, ObjectiveClass));
+	if (!Route) return;
+
+	for (const FQuestProgressRouteEntry& Entry : *Route)
+	{
+		OutQuests.Add(Entry.Quest);
+	}
+}
+
+TArray<UQuestObject*> UQuestSubsystem::GetQuestObjects(const FString& QuestsOwner)
+{
+	return GetQuestObjects(FindOwnerHandle(QuestsOwner));
+}
+
+TArray<UQuestObject*> UQuestSubsystem::GetQuestObjects(FQuestOwnerHandle QuestsOwner)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::GetQuestObjects)
+	QUEST_COUNTER_ADD(Lookups, 1);
+	FaultInMappedOwner(QuestsOwner);
+	
+	const TConstArrayView<FQuestComparator> Comparators = GetQuestComparators(QuestsOwner);
+
+	TArray<UQuestObject*> QuestObjects = TArray<UQuestObject*>();
+	QuestObjects.Reserve(Comparators.Num());
+
+	//Materializing records doesn't add entries, the view stays valid
+	for (const FQuestComparator& QuestComparator : Comparators)
+	{
+		QuestObjects.Add(QuestComparator.IsRecord() ? MaterializeQuest(QuestComparator.QuestClass, QuestsOwner) : QuestComparator.QuestObject);
+	}
+
+	return QuestObjects;
+}
+
+TConstArrayView<FQuestComparator> UQuestSubsystem::GetQuestComparators(FQuestOwnerHandle QuestsOwner) const
+{
+	const FTArrayQuestComparator* OwnerQuests = FindOwnerQuests(QuestsOwner);
+	return OwnerQuests ? OwnerQuests->GetView() : TConstArrayView<FQuestComparator>();
+}
+
+void UQuestSubsystem::ForEachQuest(const FString& QuestsOwner, TFunctionRef<bool(UQuestObject*)> Visitor) const
+{
+	ForEachQuest(FindOwnerHandle(QuestsOwner), Visitor);
+}
+
+void UQuestSubsystem::ForEachQuest(FQuestOwnerHandle QuestsOwner, TFunctionRef<bool(UQuestObject*)> Visitor) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::ForEachQuest)
+
+	//Index based and re-fetched on every step, the visitor may unlock new quests or register owners
+	for (int32 i = 0; ; i++)
+	{
+		const FTArrayQuestComparator* OwnerQuests = FindOwnerQuests(QuestsOwner);
+		if (!OwnerQuests || i >= OwnerQuests->Num()) return;
+
+		UQuestObject* QuestObject = (*OwnerQuests)[i].QuestObject;
+		if (!IsValid(QuestObject)) continue;
+		
+		if (!Visitor(QuestObject)) return;
+	}
+}
+
+void UQuestSubsystem::DumpQuests(FOutputDevice& Ar, const FString& OwnerFilter) const
+{
+	const UEnum* StatusEnum = StaticEnum<EQuestStatus>();
+	int32 NumOwners = 0;
+	int32 NumQuests = 0;
+	
+	for (int32 OwnerIndex = 0; OwnerIndex < OwnerNames.Num(); OwnerIndex++)
+	{
+		if (!OwnerFilter.IsEmpty() && !OwnerNames[OwnerIndex].Equals(OwnerFilter, ESearchCase::IgnoreCase)) continue;
+
+		const FQuestOwnerHandle Owner(OwnerIndex);
+		Ar.Logf(TEXT("%s"), *OwnerNames[OwnerIndex]);
+		NumOwners++;
+		
+		for (const FQuestComparator& Comparator : GetQuestComparators(Owner))
+		{
+			Ar.Logf(TEXT("    %s: %s%s"), *GetNameSafe(Comparator.QuestClass),
+				*StatusEnum->GetNameStringByValue(static_cast<int64>(Comparator.GetStatus())), Comparator.IsRecord() ? TEXT(" (record)") : TEXT(""));
+			NumQuests++;
+		}
+
+		ForEachMappedOwnerQuest(Owner, [&Ar, StatusEnum, &NumQuests](TSubclassOf<UQuestObject> QuestClass, const FQuestMappedSnapshot::FQuest& MappedQuest)
+		{
+			Ar.Logf(TEXT("    %s: %s (mapped)"), *GetNameSafe(QuestClass), *StatusEnum->GetNameStringByValue(static_cast<int64>(MappedQuest.GetStatus())));
+			NumQuests++;
+		});
+	}
+
+	Ar.Logf(TEXT("%d quests of %d owners"), NumQuests, NumOwners);
+}
+
+
+bool UQuestSubsystem::EnsurePlayerEntryExists(const FString& Owner)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UQuestSubsystem::EnsurePlayerEntryExists)
+
+	//Registering the owner creates its (empty) quest entry
+	return FindOrAddOwnerHandle(Owner).IsValid();
+}
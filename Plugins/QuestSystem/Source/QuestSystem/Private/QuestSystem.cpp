@@ -1,18 +1,53 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "QuestSystem.h"
+#include "QuestNativeDispatch.h"
+#include "QuestSubsystem.h"
+#include "UObject/UObjectGlobals.h"
+#include "UObject/UObjectIterator.h"
 
 #define LOCTEXT_NAMESPACE "FQuestSystemModule"
 
+#if WITH_EDITOR
+namespace
+{
+	void ResetQuestClassCaches()
+	{
+		QuestNativeDispatch::Reset();
+		for (TObjectIterator<UQuestSubsystem> It; It; ++It)
+		{
+			It->ResetQuestDefinitions();
+		}
+	}
+}
+#endif
+
 void FQuestSystemModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+#if WITH_EDITOR
+	//Blueprint compiles and live coding can add or remove overrides of natively dispatched events and replace the
+	//class default objects the quest definitions were compiled from
+	ObjectsReinstancedHandle = FCoreUObjectDelegates::OnObjectsReinstanced.AddLambda([](const TMap<UObject*, UObject*>&)
+	{
+		ResetQuestClassCaches();
+	});
+	ReloadCompleteHandle = FCoreUObjectDelegates::ReloadCompleteDelegate.AddLambda([](EReloadCompleteReason)
+	{
+		ResetQuestClassCaches();
+	});
+#endif
 }
 
 void FQuestSystemModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectsReinstanced.Remove(ObjectsReinstancedHandle);
+	FCoreUObjectDelegates::ReloadCompleteDelegate.Remove(ReloadCompleteHandle);
+#endif
+	QuestNativeDispatch::Reset();
 }
 
 #undef LOCTEXT_NAMESPACE
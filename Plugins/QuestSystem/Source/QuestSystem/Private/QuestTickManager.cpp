@@ -0,0 +1,193 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestTickManager.h"
+#include "QuestObject.h"
+#include "QuestObjective.h"
+#include "QuestNativeDispatch.h"
+#include "QuestStats.h"
+
+void FQuestTickManager::RegisterObjective(UQuestObjective* Objective)
+{
+	if (!IsValid(Objective)) return;
+	if (Objectives.IsValidIndex(Objective->TickIndex) && Objectives[Objective->TickIndex].Objective == Objective) return;
+
+	FQuestObjectiveTickEntry Entry;
+	Entry.Objective = Objective;
+	Entry.LastTickTime = Clock;
+	Objective->TickIndex = Objectives.Add(Entry);
+}
+
+void FQuestTickManager::UnregisterObjective(UQuestObjective* Objective)
+{
+	if (!Objective) return;
+	
+	const int32 Index = Objective->TickIndex;
+	Objective->TickIndex = INDEX_NONE;
+	if (!Objectives.IsValidIndex(Index) || Objectives[Index].Objective != Objective) return;
+
+	//Only clear the slot while ticking so the running pass stays valid
+	if (bTicking)
+	{
+		Objectives[Index].Objective = nullptr;
+		bNeedsCompaction = true;
+		return;
+	}
+
+	Objectives.RemoveAtSwap(Index);
+	if (Objectives.IsValidIndex(Index) && Objectives[Index].Objective)
+	{
+		Objectives[Index].Objective->TickIndex = Index;
+	}
+}
+
+void FQuestTickManager::RegisterQuest(UQuestObject* Quest)
+{
+	if (!IsValid(Quest)) return;
+	if (Quests.IsValidIndex(Quest->TickIndex) && Quests[Quest->TickIndex] == Quest) return;
+
+	Quest->TickIndex = Quests.Add(Quest);
+}
+
+void FQuestTickManager::UnregisterQuest(UQuestObject* Quest)
+{
+	if (!Quest) return;
+	
+	const int32 Index = Quest->TickIndex;
+	Quest->TickIndex = INDEX_NONE;
+	if (!Quests.IsValidIndex(Index) || Quests[Index] != Quest) return;
+
+	if (bTicking)
+	{
+		Quests[Index] = nullptr;
+		bNeedsCompaction = true;
+		return;
+	}
+
+	Quests.RemoveAtSwap(Index);
+	if (Quests.IsValidIndex(Index) && Quests[Index])
+	{
+		Quests[Index]->TickIndex = Index;
+	}
+}
+
+void FQuestTickManager::Tick(float DeltaTime, float BudgetMs)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FQuestTickManager::Tick)
+	bTicking = true;
+	Clock += DeltaTime;
+
+	TickObjectives(BudgetMs);
+
+	{
+		QUEST_SCOPE_CYCLE_COUNTER(TickQuests);
+		
+		//Quests registered while ticking get their first tick next frame
+		const int32 NumQuests = Quests.Num();
+		for (int32 i = 0; i < NumQuests; i++)
+		{
+			UQuestObject* Quest = Quests[i];
+			if (!IsValid(Quest))
+			{
+				bNeedsCompaction = true;
+				continue;
+			}
+			
+			QUEST_NATIVE_EVENT(Quest, QuestTick, DeltaTime);
+		}
+	}
+
+	bTicking = false;
+	
+	if (bNeedsCompaction)
+	{
+		Compact();
+	}
+}
+
+void FQuestTickManager::TickObjectives(float BudgetMs)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FQuestTickManager::TickObjectives)
+	QUEST_SCOPE_CYCLE_COUNTER(TickObjectives);
+	
+	//Objectives registered while ticking get their first tick next pass
+	const int32 NumObjectives = Objectives.Num();
+	if (NumObjectives == 0) return;
+	
+	const bool bBudgeted = BudgetMs > 0.f;
+	const double EndTime = bBudgeted ? FPlatformTime::Seconds() + BudgetMs / 1000.0 : 0.0;
+	
+	int32 Index = NextObjective < NumObjectives ? NextObjective : 0;
+	for (int32 Visited = 0; Visited < NumObjectives; Visited++)
+	{
+		FQuestObjectiveTickEntry& Entry = Objectives[Index];
+		Index = (Index + 1) % NumObjectives;
+		
+		UQuestObjective* Objective = Entry.Objective;
+		if (!IsValid(Objective))
+		{
+			bNeedsCompaction = true;
+			continue;
+		}
+
+		const double Elapsed = Clock - Entry.LastTickTime;
+		if (Elapsed <= 0.0 || Elapsed < Objective->GetTickInterval()) continue;
+
+		//Entry may be invalidated by registrations inside the tick, write it before
+		Entry.LastTickTime = Clock;
+		QUEST_NATIVE_EVENT(Objective, TickObjective, Objective->GetOwningQuestObject(), static_cast<float>(Elapsed));
+
+		if (bBudgeted && FPlatformTime::Seconds() >= EndTime) break;
+	}
+
+	NextObjective = Index;
+}
+
+void FQuestTickManager::Compact()
+{
+	int32 Write = 0;
+	int32 NewNextObjective = NextObjective;
+	for (int32 Read = 0; Read < Objectives.Num(); Read++)
+	{
+		if (!IsValid(Objectives[Read].Objective))
+		{
+			if (Read < NextObjective) NewNextObjective--;
+			continue;
+		}
+
+		Objectives[Read].Objective->TickIndex = Write;
+		if (Write != Read)
+		{
+			Objectives[Write] = Objectives[Read];
+		}
+		Write++;
+	}
+	Objectives.SetNum(Write);
+	NextObjective = NewNextObjective;
+	
+	Quests.RemoveAll([](const TObjectPtr<UQuestObject>& Quest) { return !IsValid(Quest); });
+	for (int32 i = 0; i < Quests.Num(); i++)
+	{
+		Quests[i]->TickIndex = i;
+	}
+	
+	bNeedsCompaction = false;
+}
+
+void FQuestTickManager::Reset()
+{
+	for (const FQuestObjectiveTickEntry& Entry : Objectives)
+	{
+		if (Entry.Objective) Entry.Objective->TickIndex = INDEX_NONE;
+	}
+
+	for (UQuestObject* Quest : Quests)
+	{
+		if (Quest) Quest->TickIndex = INDEX_NONE;
+	}
+	
+	Objectives.Reset();
+	Quests.Reset();
+	NextObjective = 0;
+	bNeedsCompaction = false;
+}
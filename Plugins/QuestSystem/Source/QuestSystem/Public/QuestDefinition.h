@@ -0,0 +1,50 @@
+﻿// Protected under GPL-3.0 License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/SubclassOf.h"
+#include "UObject/ObjectPtr.h"
+
+class UQuestObject;
+class UQuestReward;
+class FReferenceCollector;
+struct FObjectInstancingGraph;
+
+// Read only data of one objective, matches UQuestObject::QuestObjectives by index
+struct QUESTSYSTEM_API FQuestObjectiveDefinition
+{
+	// Reward templates of the objective, owned by the class default object
+	TArray<TObjectPtr<UQuestReward>> Rewards;
+};
+
+/**
+ * Read only data of a quest class, compiled once from its class default object and shared by every owner.
+ * 
+ * When the quest class shares its rewards (see UQuestObject::bShareRewards) the reward templates of the quest and its
+ * objectives live here only. Quest objects and objectives of the owners keep their runtime state (status, objective
+ * counters and progress) and leave their reward arrays empty. Objectives stay objects of every owner, their status,
+ * progress and blueprint events are per owner.
+ */
+struct QUESTSYSTEM_API FQuestDefinition
+{
+	TSubclassOf<UQuestObject> QuestClass;
+
+	// Reward templates of the quest, owned by the class default object. Empty unless shared
+	TArray<TObjectPtr<UQuestReward>> Rewards;
+
+	// One entry per objective slot of the class default object. Empty unless shared
+	TArray<FQuestObjectiveDefinition> Objectives;
+
+	bool bSharesRewards = false;
+
+	static TSharedRef<FQuestDefinition> Compile(TSubclassOf<UQuestObject> QuestClass);
+
+	// Maps the reward templates onto themselves so objects constructed with the graph reference them instead of instancing copies
+	void AddSharedSubobjects(FObjectInstancingGraph& InstancingGraph) const;
+
+	void AddReferencedObjects(FReferenceCollector& Collector);
+
+	// Heap memory of the definition itself, the reward templates belong to the class default object
+	SIZE_T GetAllocatedSize() const;
+};
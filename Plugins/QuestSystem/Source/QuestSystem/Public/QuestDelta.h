@@ -0,0 +1,112 @@
+﻿// Protected under GPL-3.0 License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "QuestSaveData.h"
+
+class UQuestObject;
+
+/**
+ * Version of the quest state of one owner. Sequence grows with every change, Epoch changes whenever the
+ * quest subsystem starts tracking anew, so versions of different tracking sessions never get mixed up.
+ */
+struct QUESTSYSTEM_API FQuestDeltaVersion
+{
+	uint32 Epoch = 0;
+	uint32 Sequence = 0;
+
+	bool operator==(const FQuestDeltaVersion& Other) const { return Epoch == Other.Epoch && Sequence == Other.Sequence; }
+	bool operator!=(const FQuestDeltaVersion& Other) const { return !(*this == Other); }
+
+	friend FArchive& operator<<(FArchive& Ar, FQuestDeltaVersion& Version);
+};
+
+/**
+ * Quest changes of one owner between two versions. Every changed quest is sent with its complete state
+ * (status, objective status and SaveGame properties), so applying a delta again or applying overlapping
+ * deltas yields the same state. Contains no UObject pointers and serializes through any FArchive,
+ * so it can be sent over whatever transport the game uses.
+ */
+struct QUESTSYSTEM_API FQuestDelta
+{
+	static constexpr uint32 Magic = 0x5153444C; // "QSDL"
+
+	// Version the delta builds on, the receiver needs at least this version. Unused for full states
+	FQuestDeltaVersion Base;
+
+	// Version the receiver has after applying the delta
+	FQuestDeltaVersion Version;
+
+	// Replaces all quests of the owner instead of patching them
+	bool bFullState = false;
+
+	// Every quest class is sent once as path, the quest records refer to it by index
+	TArray<FString> QuestClasses;
+
+	// Changed quests of the owner, removed quests have the INVALID status
+	FQuestOwnerSaveRecord Changes;
+
+	/**
+	 * Reads or writes the whole delta including header. Sets the archive error when the data
+	 * is not a quest delta or has been written by a newer version.
+	 */
+	friend QUESTSYSTEM_API FArchive& operator<<(FArchive& Ar, FQuestDelta& Delta);
+
+	bool ToBytes(TArray<uint8>& OutData);
+	bool FromBytes(const TArray<uint8>& Data);
+};
+
+// Change tracking of one owner on the producing side, see UQuestSubsystem::CreateQuestDelta
+struct QUESTSYSTEM_API FQuestDeltaOwner
+{
+	uint32 Sequence = 0;
+
+	// Changes up to this sequence have been dropped, older versions receive the full state
+	uint32 FirstDeltaSequence = 0;
+
+	// Quest class -> sequence of its last change
+	TMap<const UClass*, uint32> ChangedQuests;
+};
+
+enum class EQuestDeltaResult : uint8
+{
+	Applied,
+	
+	// The mirror already has this or a newer version, nothing changed
+	AlreadyApplied,
+	
+	// The delta builds on a version the mirror does not have, acknowledge the current version to receive the full state
+	MissingBase
+};
+
+/**
+ * Receiving side of quest deltas. Keeps the last received state of every quest per owner, quest classes are
+ * identified by path so nothing has to be loaded. Acknowledge GetVersion to the producer after applying.
+ */
+struct QUESTSYSTEM_API FQuestDeltaMirror
+{
+	struct FOwner
+	{
+		FQuestDeltaVersion Version;
+
+		// Quest class path -> last received state, ClassIndex is unused
+		TMap<FString, FQuestSaveRecord> Quests;
+	};
+
+	EQuestDeltaResult Apply(const FQuestDelta& Delta);
+
+	FQuestDeltaVersion GetVersion(const FString& Owner) const;
+
+	const FOwner* FindOwner(const FString& Owner) const { return Owners.Find(Owner); }
+	const FQuestSaveRecord* FindQuest(const FString& Owner, const FString& QuestClassPath) const;
+	
+	// INVALID when the owner does not have the quest
+	EQuestStatus GetQuestStatus(const FString& Owner, const UClass* QuestClass) const;
+
+	void Reset() { Owners.Empty(); }
+
+private:
+	// Case insensitive like the owner names of the quest subsystem
+	TMap<FString, FOwner> Owners;
+};
@@ -20,6 +20,9 @@ enum class EQuestStatus : uint8
 	FAILED,
 };
 
+// Number of EQuestStatus values, used to size per status tables
+constexpr int32 QuestStatusCount = static_cast<int32>(EQuestStatus::FAILED) + 1;
+
 UENUM(BlueprintType)
 enum class EQuestEnterCommand : uint8
 {
@@ -27,4 +30,5 @@ enum class EQuestEnterCommand : uint8
 	ACCEPT,
 	INITIALIZE,
 	START,
+	REPEAT,
 };
\ No newline at end of file
@@ -0,0 +1,40 @@
+﻿// Protected under GPL-3.0 License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Logging/LogMacros.h"
+
+QUESTSYSTEM_API DECLARE_LOG_CATEGORY_EXTERN(LogQuestSystem, Log, All);
+
+// Diagnostics are meant for hot paths and compile out of shipping builds, define QUEST_DIAGNOSTICS=1 to keep them
+#ifndef QUEST_DIAGNOSTICS
+	#define QUEST_DIAGNOSTICS !UE_BUILD_SHIPPING
+#endif
+
+#if QUEST_DIAGNOSTICS
+namespace QuestDiagnostics
+{
+	// Set through QuestSystem.Debug.OnScreen
+	extern QUESTSYSTEM_API bool bOnScreen;
+
+	// Game thread only, messages from other threads are only logged
+	QUESTSYSTEM_API void AddOnScreenMessage(ELogVerbosity::Type Verbosity, const FString& Message);
+}
+
+/**
+ * Logs to LogQuestSystem and mirrors the message to the screen while QuestSystem.Debug.OnScreen is set.
+ * The message is only formatted when the verbosity is active, raise it with "Log LogQuestSystem Verbose".
+ */
+#define QUEST_DIAG(Verbosity, Format, ...) \
+	do \
+	{ \
+		UE_LOG(LogQuestSystem, Verbosity, Format, ##__VA_ARGS__); \
+		if (QuestDiagnostics::bOnScreen && UE_LOG_ACTIVE(LogQuestSystem, Verbosity)) \
+		{ \
+			QuestDiagnostics::AddOnScreenMessage(ELogVerbosity::Verbosity, FString::Printf(Format, ##__VA_ARGS__)); \
+		} \
+	} while (false)
+#else
+#define QUEST_DIAG(Verbosity, Format, ...) do {} while (false)
+#endif
@@ -0,0 +1,134 @@
+﻿// Protected under GPL-3.0 License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "QuestSaveData.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Read only quest status tables laid out to be used straight from a memory mapped file.
+ * Opening only validates the header, nothing gets parsed up front:
+ *  - Owners point to their quests, which are sorted by class index for binary search
+ *  - Classes point to the owners that have them, sorted by owner index
+ *  - Quests that carry object state point to their serialized FQuestSaveRecord
+ */
+class QUESTSYSTEM_API FQuestMappedSnapshot
+{
+public:
+	static constexpr uint32 Magic = 0x5153534D; // "QSSM"
+
+	struct FStringRef
+	{
+		uint32 Offset = 0;
+		uint32 Length = 0;
+	};
+	
+	struct FHeader
+	{
+		uint32 Magic = 0;
+		int32 Version = 0;
+		uint32 NumOwners = 0;
+		uint32 NumClasses = 0;
+		uint32 NumQuests = 0;
+		uint32 NumClassOwners = 0;
+		uint64 OwnersOffset = 0;
+		uint64 ClassesOffset = 0;
+		uint64 QuestsOffset = 0;
+		uint64 ClassOwnersOffset = 0;
+		uint64 StringsOffset = 0;
+		uint64 StringsSize = 0;
+		uint64 RecordsOffset = 0;
+		uint64 RecordsSize = 0;
+	};
+
+	struct FOwner
+	{
+		FStringRef Name;
+		uint32 FirstQuest = 0;
+		uint32 NumQuests = 0;
+	};
+
+	struct FClass
+	{
+		FStringRef Path;
+		uint32 FirstOwner = 0;
+		uint32 NumOwners = 0;
+	};
+
+	struct FQuest
+	{
+		// Relative to RecordsOffset, the record is only there if RecordSize is not 0
+		uint64 RecordOffset = 0;
+		uint32 RecordSize = 0;
+		uint32 ClassIndex = 0;
+		uint8 Status = 0;
+		uint8 Padding[7] = {};
+
+		EQuestStatus GetStatus() const { return static_cast<EQuestStatus>(Status); }
+	};
+
+	struct FClassOwner
+	{
+		uint32 OwnerIndex = 0;
+		
+		// Index into the quests of the whole snapshot
+		uint32 QuestIndex = 0;
+	};
+
+	~FQuestMappedSnapshot();
+
+	/**
+	 * Builds the mapped layout of the snapshot.
+	 */
+	static void Write(const FQuestSaveSnapshot& Snapshot, TArray<uint8>& OutData);
+
+	/**
+	 * Maps the file into memory, falls back to reading it when the platform can't map files.
+	 * 
+	 * @return nullptr if the file is missing or not a valid snapshot
+	 */
+	static TUniquePtr<FQuestMappedSnapshot> Open(const FString& FilePath);
+
+	int32 NumOwners() const { return Header->NumOwners; }
+	int32 NumClasses() const { return Header->NumClasses; }
+	
+	FString GetOwnerName(int32 OwnerIndex) const;
+	FString GetClassPath(int32 ClassIndex) const;
+
+	TConstArrayView<FQuest> GetOwnerQuests(int32 OwnerIndex) const;
+	const FQuest* FindQuest(int32 OwnerIndex, int32 ClassIndex) const;
+	const FQuest* GetQuest(uint32 QuestIndex) const { return QuestIndex < Header->NumQuests ? &Quests[QuestIndex] : nullptr; }
+	
+	TConstArrayView<FClassOwner> GetClassOwners(int32 ClassIndex) const;
+
+	/**
+	 * Fills the record with the status of the quest and, if stored, its objectives and SaveGame properties.
+	 * ClassIndex is the snapshot class index.
+	 */
+	bool ReadQuest(const FQuest& Quest, FQuestSaveRecord& OutRecord) const;
+
+private:
+	FQuestMappedSnapshot();
+
+	// Checks the header and points the tables into the data
+	bool InitializeTables();
+	FString ReadString(const FStringRef& String) const;
+	
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	// Only used when the file could not be mapped
+	TArray64<uint8> LoadedData;
+
+	const uint8* Data = nullptr;
+	int64 Size = 0;
+
+	const FHeader* Header = nullptr;
+	const FOwner* Owners = nullptr;
+	const FClass* Classes = nullptr;
+	const FQuest* Quests = nullptr;
+	const FClassOwner* ClassOwners = nullptr;
+};
@@ -0,0 +1,48 @@
+﻿// Protected under GPL-3.0 License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// BlueprintNativeEvents the quest system calls on hot paths, see QUEST_NATIVE_EVENT
+enum class EQuestNativeEvent : uint8
+{
+	//UQuestObject
+	ProgressQuest,
+	ProgressQuestEvent,
+	QuestTick,
+	
+	//UQuestObjective
+	AddProgress,
+	AddProgressEvent,
+	UpdateStatus,
+	ForceStatus,
+	TickObjective,
+	TryStartObjective,
+	StartObjective,
+
+	//UQuestReward
+	ClaimReward,
+
+	Count
+};
+
+namespace QuestNativeDispatch
+{
+	/**
+	 * @return True if the class of the object does not override the event in a blueprint.
+	 * Resolved once per class on first use. Game thread only.
+	 */
+	QUESTSYSTEM_API bool IsNative(const UObject* Object, EQuestNativeEvent Event);
+
+	// Drops the resolved classes, needed whenever blueprints get recompiled or reinstanced
+	QUESTSYSTEM_API void Reset();
+}
+
+/**
+ * Calls the _Implementation of the BlueprintNativeEvent directly when no blueprint overrides it,
+ * skipping ProcessEvent and the parameter marshalling. Native overrides of the _Implementation still get called.
+ * Object gets evaluated more than once, pass a plain pointer.
+ */
+#define QUEST_NATIVE_EVENT(Object, Event, ...) \
+	(QuestNativeDispatch::IsNative(Object, EQuestNativeEvent::Event) ? (Object)->Event##_Implementation(__VA_ARGS__) : (Object)->Event(__VA_ARGS__))
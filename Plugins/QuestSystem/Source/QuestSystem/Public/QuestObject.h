@@ -3,7 +3,9 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "QuestDefinition.h"
 #include "QuestObjective.h"
+#include "QuestOwnerHandle.h"
 #include "IO/IoDispatcher.h"
 #include "UObject/Object.h"
 #include "QuestObject.generated.h"
@@ -18,6 +20,12 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnQuestTick, UQuestObject*, Quest,
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnQuestFinished, UQuestObject*, Quest, EQuestStatus, QuestFinishedStatus);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnQuestProgressUpdated, UQuestObject*, Quest, TArray<UQuestObjective*>&, QuestModifiers, UQuestProgressionObject*, Progress);
 
+//Native counterparts, broadcast together with the dynamic delegates but without going through reflection
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnQuestStartedNative, UQuestObject* /*Quest*/);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnQuestTickNative, UQuestObject* /*Quest*/, float /*DeltaTime*/);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnQuestFinishedNative, UQuestObject* /*Quest*/, EQuestStatus /*QuestFinishedStatus*/);
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnQuestProgressUpdatedNative, UQuestObject* /*Quest*/, const TArray<UQuestObjective*>& /*QuestModifiers*/, UQuestProgressionObject* /*Progress*/);
+
 
 
 /**
@@ -25,7 +33,7 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnQuestProgressUpdated, UQuestOb
  *
  */
 UCLASS(Category="QuestSystem|Quest", BlueprintType, Blueprintable, Abstract)
-class QUESTSYSTEM_API UQuestObject : public UObject, public FTickableGameObject
+class QUESTSYSTEM_API UQuestObject : public UObject
 {
 	GENERATED_BODY()
 
@@ -34,9 +42,29 @@ public:
 	
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="QuestSystem|Quest")
 	FName QuestName;
+
+	/**
+	 * While locked or unlocked the quest is only kept as a small record by the subsystem, the object gets created
+	 * once it is needed (accepting, GetQuestObject...). Ignored when Unlock is overridden in a blueprint
+	 * or might be overridden natively, see GetDefaultUnlockClass.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="QuestSystem|Quest")
+	bool bCreateObjectOnDemand = true;
+
+	/**
+	 * Rewards are design data, by default they only exist on the class default object and every owner claims them
+	 * from the quest definition, see FQuestDefinition. OwningQuest of a shared reward is only set while its ClaimReward
+	 * runs, turn this off for rewards that keep per owner state or claim asynchronously.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="QuestSystem|Quest")
+	bool bShareRewards = true;
 	
 	UPROPERTY(Category="QuestSystem|Quest", BlueprintReadOnly, VisibleInstanceOnly)
 	FString QuestOwner;
+
+	//Interned owner identifier issued by the quest subsystem, matches QuestOwner
+	UPROPERTY(Category="QuestSystem|Quest", BlueprintReadOnly, VisibleInstanceOnly)
+	FQuestOwnerHandle QuestOwnerHandle;
 	
 	UPROPERTY(BlueprintAssignable, Category="QuestSystem|Quest|Event")
 	FOnQuestStarted OnQuestStartedDelegate;
@@ -49,45 +77,41 @@ public:
 
 	UPROPERTY(BlueprintAssignable, Category="QuestSystem|Quest|Event")
 	FOnQuestProgressUpdated OnQuestProgressUpdatedDelegate;
+
+	// C++ listeners should bind to these, they skip ProcessEvent entirely
+	FOnQuestStartedNative OnQuestStartedNative;
+	FOnQuestTickNative OnQuestTickNative;
+	FOnQuestFinishedNative OnQuestFinishedNative;
+	FOnQuestProgressUpdatedNative OnQuestProgressUpdatedNative;
 	
 public:
 	
-#pragma region TickableGameObject
-	virtual void Tick(float DeltaTime) override { QuestTick(DeltaTime); }
-	virtual ETickableTickType GetTickableTickType() const override
-	{
-		return ETickableTickType::Conditional;
-	}
-	virtual TStatId GetStatId() const override
-	{
-		RETURN_QUICK_DECLARE_CYCLE_STAT(FQuestObject, STATGROUP_Tickables);
-	}
-	virtual bool IsTickableWhenPaused() const override
-	{
-		return true;
-	}
-	virtual bool IsTickableInEditor() const override
-	{
-		return false;
-	}
-	virtual bool IsTickable() const override //This defines whether tick is called or not
-	{
-		return ShouldTick;
-	}
-
-#pragma endregion TickableGameObject
-
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Objectives", Instanced)
 	TArray<UQuestObjective*> QuestObjectives;
 
+	// Empty on quest objects sharing their rewards, see GetQuestRewards
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Rewards", Instanced)
 	TArray<UQuestReward*> QuestRewards;
 	
 	UFUNCTION(Category="Quest", BlueprintCallable)
 	TArray<FString> GetQuestObjectiveDescriptions() const;
 
+	// Rewards of this quest, the shared ones of the definition or the own ones
+	UFUNCTION(Category="Rewards", BlueprintCallable)
+	TArray<UQuestReward*> GetQuestRewards() const;
+
+	// Read only data shared by every quest object of this class, NULL for quests not created by the quest subsystem
+	const FQuestDefinition* GetDefinition() const { return Definition.Get(); }
+
 	UFUNCTION(Category="Quest", BlueprintCallable, BlueprintNativeEvent, meta=(ForceAsFunction))
 	bool Unlock();
+
+	/**
+	 * Closest native class known not to override Unlock_Implementation. Native overrides can't be seen through
+	 * reflection, quests whose closest native class is another one are assumed to override it and always get
+	 * their object. Native subclasses that keep the default Unlock return their StaticClass().
+	 */
+	virtual const UClass* GetDefaultUnlockClass() const { return UQuestObject::StaticClass(); }
 	
 	//Don't forget to call super when overriding
 	UFUNCTION(Category="Quest", BlueprintCallable, BlueprintNativeEvent, meta=(ForceAsFunction))
@@ -101,6 +125,30 @@ public:
 	
 	UFUNCTION(Category="Quest", BlueprintCallable, BlueprintNativeEvent)
 	void ProgressQuest(UQuestProgressionObject* Progress);
+
+	/**
+	 * Value type version of ProgressQuest, no UObject gets created or destroyed.
+	 * OnQuestProgressUpdatedDelegate receives the wrapped progression object, which is NULL for pure struct events.
+	 * 
+	 * @return True when an objective consumed the event
+	 */
+	UFUNCTION(Category="Quest", BlueprintCallable, BlueprintNativeEvent)
+	bool ProgressQuestEvent(const FQuestProgressEvent& Event);
+
+	/**
+	 * Applies the event to the matching objectives without broadcasting or checking for completion.
+	 * Used by batched progress, call EndProgressBatch once all events are applied.
+	 * 
+	 * @return True when an objective consumed the event
+	 */
+	bool ApplyProgressEvent(const FQuestProgressEvent& Event);
+
+	/**
+	 * Broadcasts a single OnQuestProgressUpdatedDelegate and checks once for completion.
+	 * 
+	 * @param Progress The progression object of the last batched event that wrapped one, NULL if none did
+	 */
+	void EndProgressBatch(UQuestProgressionObject* Progress);
 	
 	UFUNCTION(Category="Quest", BlueprintCallable, BlueprintNativeEvent)
 	void QuestFinished(EQuestStatus Status);
@@ -109,19 +157,31 @@ public:
 	void ClaimRewards();
 	
 	/**
-	 * Gets called when the Quest starts. This should always broadcast the OnQuestStarted Delegate
+	 * Gets called when the Quest starts. This should always broadcast the OnQuestStarted Delegate, so call parent when overriding
 	 */
 	UFUNCTION(Category="Quest", BlueprintCallable, BlueprintNativeEvent)
 	void QuestStarted();
-	void QuestStarted_Implementation() { OnQuestStartedDelegate.Broadcast(this); }
+	void QuestStarted_Implementation();
 
 	/**
-	 * To have this called "ShouldTick" needs to be true
+	 * To have this called "ShouldTick" needs to be true, see SetShouldTick.
+	 * Ticked by the quest subsystem while the quest is in progress. Objectives tick on their own and don't need this.
+	 * Quests with a ticking objective that override this in a blueprint or have OnQuestTickDelegate bound when they
+	 * start turn ShouldTick on by themselves. Native overrides need to call SetShouldTick.
 	 * @param DeltaTime 
 	 */
 	UFUNCTION(Category="Quest", BlueprintCallable, BlueprintNativeEvent)
 	void QuestTick(float DeltaTime);
 
+	/**
+	 * Enables or disables QuestTick. Use this instead of writing ShouldTick, it updates the subsystem tick registration.
+	 */
+	UFUNCTION(Category="Quest", BlueprintCallable)
+	void SetShouldTick(bool bShouldTick);
+
+	UFUNCTION(Category="Quest", BlueprintCallable)
+	bool NeedsTick() const { return ShouldTick; }
+
 	UFUNCTION(Category="Quest", BlueprintCallable, BlueprintNativeEvent)
 	bool AcceptQuest();
 
@@ -131,9 +191,35 @@ public:
 	UFUNCTION(Category="Quest", BlueprintCallable, BlueprintNativeEvent, meta=(ForceAsFunction))
 	bool StartQuest();
 	
+	/**
+	 * Finishes the quest when no objective is pending anymore. Reads the objective counters, the objectives
+	 * are only visited when one of them failed.
+	 * 
+	 * @return COMPLETED or FAILED when the quest finished, INVALID while objectives are pending
+	 */
 	UFUNCTION(Category="Quest", BlueprintCallable)
 	EQuestStatus TryFinishQuest();
 
+	/**
+	 * Puts a quest that is not running back into UNLOCKED so it can be accepted again, reusing this object and its objectives.
+	 * Locked and invalid quests keep their status, only their objectives get reset.
+	 * Also used before the quest subsystem pools the object. Override to reset your own state and call parent.
+	 * 
+	 * @return False while the quest is accepted, starting or in progress
+	 */
+	UFUNCTION(Category="Quest", BlueprintCallable, BlueprintNativeEvent, meta=(ForceAsFunction))
+	bool ResetForRepeat();
+
+	/**
+	 * Rebuilds the objective counters from the objectives. Only needed after changing QuestObjectives
+	 * or writing an objectives Status directly, Initialize calls it.
+	 */
+	UFUNCTION(Category="Quest", BlueprintCallable)
+	void RecountObjectives();
+
+	UFUNCTION(Category="Quest", BlueprintCallable)
+	int32 GetPendingObjectiveCount() const { return QuestObjectives.Num() - EmptyObjectiveSlots - CompletedObjectives - FailedObjectives; }
+
 	/**
 	 * OVERRIDE THIS!
 	 * When in multiplayer there is no good way of identifying a specific player
@@ -152,5 +238,45 @@ protected:
 	UPROPERTY(Category="Quest", BlueprintReadWrite, VisibleInstanceOnly)
 	EQuestStatus QuestStatus = EQuestStatus::LOCKED;
 
+private:
+	// Broadcasts the native and, when bound, the dynamic progress delegate
+	void BroadcastProgressUpdated(UQuestProgressionObject* Progress);
+
+	// Called by the objectives whenever their status changes
+	void OnObjectiveStatusChanged(const UQuestObjective* Objective, EQuestStatus OldStatus);
+	void AdjustObjectiveCounter(EQuestStatus Status, int32 Delta);
+
+	// Read when checking, FailingObjectiveFailsQuest may change while the objective is failed
+	bool HasQuestFailingObjective() const;
+
+	// Runs TryFinishQuest only when an objective changed its status since the last check
+	void TryFinishQuestIfChanged();
+
+	// Puts the quest into a loaded status without running any of the transition events
+	void RestoreSavedStatus(EQuestStatus Status);
+
+	// Turns ShouldTick on for quests with a ticking objective that make use of QuestTick, they always ticked before
+	void TickWithTickingObjectives();
+
+	int32 CompletedObjectives = 0;
+	int32 FailedObjectives = 0;
+	
+	// Null entries of QuestObjectives, they are never pending
+	int32 EmptyObjectiveSlots = 0;
+
+	bool bObjectiveStatusChanged = true;
+	
+	// Slot in the FQuestTickManager while registered
+	int32 TickIndex = INDEX_NONE;
+
+	TSharedPtr<const FQuestDefinition> Definition;
+
+	bool SharesRewards() const { return Definition.IsValid() && Definition->bSharesRewards; }
+
+	// Shared data of the objective, NULL unless the rewards are shared
+	const FQuestObjectiveDefinition* FindSharedObjective(const UQuestObjective* Objective) const;
+
 	friend class UQuestSubsystem;
+	friend class UQuestObjective;
+	friend struct FQuestTickManager;
 };
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "QuestEnums.h"
+#include "QuestProgressEvent.h"
 #include "QuestObjective.generated.h"
 
 
@@ -15,6 +16,10 @@ struct FQuestProgressor;
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnObjectiveStatusUpdated, UQuestObjective*, Objective, EQuestStatus, UpdatedStatus, EQuestStatus, OldStatus);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnProgressUpdated, UQuestProgressionObject*, ProgressAdded);
 
+//Native counterparts of the objective delegates, see FOnQuestStartedNative
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnObjectiveStatusUpdatedNative, UQuestObjective* /*Objective*/, EQuestStatus /*UpdatedStatus*/, EQuestStatus /*OldStatus*/);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnProgressUpdatedNative, UQuestProgressionObject* /*ProgressAdded*/);
+
 /**
  * The Quest Objective tells a quest object when it's done. A Quest Object can have multiple
  * Quest Objectives and only when every Objective is completed the quest is considered to be completed.
@@ -23,8 +28,9 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnProgressUpdated, UQuestProgressio
  *  - GetObjectiveDescription : The description that may get shown in the ui
  *  - Initialize : (Call Parent) Initializes the data by getting all required pointers and makes the quest ready to be started.
  *  - AddProgress : Adds progress towards the quest objective through the QuestProgressionObject
+ *  - AddProgressEvent : Adds progress through FQuestProgressEvent, allocation free for events without Payload. Defaults to AddProgress for wrapped progression objects.
  *  - UpdateStatus : (Call Parent) Used to update the objective's status. Add functionality to when a specific status is hit.
- *  - TickObjective : If your objective requires tick you need to enable "ShouldTick" and then overwrite this event.
+ *  - TickObjective : If your objective requires tick you need to enable "ShouldTick" and then overwrite this event. It gets called by the quest subsystem while the objective is in progress.
  *  - TryStartObjective : Override if you want to have your own starting behavior
  */
 UCLASS(Category="QuestSystem|Quest|Objective", BlueprintType, Abstract, Blueprintable, EditInlineNew)
@@ -41,11 +47,16 @@ public:
 
 	UPROPERTY(BlueprintAssignable, Category="QuestObjective", BlueprintReadWrite)
 	FOnProgressUpdated OnProgressUpdatedDelegate;
+
+	// See UQuestObject::OnQuestStartedNative
+	FOnObjectiveStatusUpdatedNative OnObjectiveStatusUpdatedNative;
+	FOnProgressUpdatedNative OnProgressUpdatedNative;
 	
 //member	
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category="QuestObjective")
 	EQuestStatus Status = EQuestStatus::INVALID;
 
+	// Empty on objectives of quests sharing their rewards, see GetObjectiveRewards
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category="QuestObjective", Instanced)
 	TArray<UQuestReward*> ObjectiveRewards;
 	
@@ -56,6 +67,13 @@ public:
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category="QuestObjective", meta=(ForceAsFunction=true))
 	void AddProgress(UQuestProgressionObject* Progress, UPARAM(ref) bool& Consume);
 
+	/**
+	 * Value type version of AddProgress. The default implementation forwards events that wrap a
+	 * progression object to AddProgress, override it to handle Amount, Tag or the Payload.
+	 */
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category="QuestObjective", meta=(ForceAsFunction=true))
+	void AddProgressEvent(const FQuestProgressEvent& Event, UPARAM(ref) bool& Consume);
+
 	UFUNCTION(BlueprintCallable, Category="QuestObjective")
 	void BroadcastProgress(UQuestProgressionObject* AddedProgress);
 	
@@ -91,8 +109,15 @@ public:
 	UFUNCTION(BlueprintCallable, Category="QuestObjective")
 	bool NeedsTick() const {return ShouldTick; };
 
+	UFUNCTION(BlueprintCallable, Category="QuestObjective")
+	float GetTickInterval() const { return TickInterval; }
+
 	UFUNCTION(BlueprintCallable, Category="QuestObjective")
 	void ClaimRewards();
+
+	// Rewards of this objective, the shared ones of the quest definition or the own ones
+	UFUNCTION(BlueprintCallable, Category="QuestObjective")
+	TArray<UQuestReward*> GetObjectiveRewards() const;
 	
 	//utility methods
 
@@ -103,6 +128,13 @@ public:
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category="QuestObjective")
 	void ForceStatus(EQuestStatus NewStatus);
 
+	/**
+	 * Puts the objective back into its initial state when the owning quest gets repeated or pooled.
+	 * Override to reset your own progress variables and call parent.
+	 */
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category="QuestObjective")
+	void ResetForRepeat();
+
 	UFUNCTION(BlueprintCallable, Category="QuestObjective")
 	FString GetQuestOwner() const;
 
@@ -112,4 +144,20 @@ public:
 protected:
 	UPROPERTY(EditDefaultsOnly, Category="QuestObjective", meta=(AllowPrivateAccess=true))
 	bool ShouldTick = false;
+
+	/**
+	 * Seconds between two ticks, 0 ticks every frame. TickObjective receives the time since its last tick,
+	 * which is at least this interval and can be longer when the quest tick budget delayed it.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="QuestObjective", meta=(AllowPrivateAccess=true, EditCondition="ShouldTick", ClampMin=0, Units="s"))
+	float TickInterval = 0.f;
+
+private:
+	// Tells the owning quest and the subsystem about a status change
+	void NotifyStatusChanged(EQuestStatus OldStatus);
+	
+	// Slot in the FQuestTickManager while registered
+	int32 TickIndex = INDEX_NONE;
+
+	friend struct FQuestTickManager;
 };
@@ -0,0 +1,32 @@
+﻿// Protected under GPL-3.0 License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "QuestOwnerHandle.generated.h"
+
+/**
+ * Interned identifier for a quest owner, issued by the UQuestSubsystem.
+ * The owner string is hashed once when the handle gets created, after that every lookup
+ * is a plain index into the subsystem storage. Handles stay valid for the lifetime of the subsystem.
+ */
+USTRUCT(BlueprintType, Category="QuestSystem")
+struct QUESTSYSTEM_API FQuestOwnerHandle
+{
+	GENERATED_BODY()
+
+	FQuestOwnerHandle() = default;
+	explicit FQuestOwnerHandle(int32 InIndex) : Index(InIndex) {}
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+	int32 GetIndex() const { return Index; }
+
+	bool operator==(const FQuestOwnerHandle& Other) const { return Index == Other.Index; }
+	bool operator!=(const FQuestOwnerHandle& Other) const { return Index != Other.Index; }
+
+	friend uint32 GetTypeHash(const FQuestOwnerHandle& Handle) { return ::GetTypeHash(Handle.Index); }
+
+private:
+	UPROPERTY(VisibleInstanceOnly, Category="QuestSystem")
+	int32 Index = INDEX_NONE;
+};
@@ -0,0 +1,58 @@
+﻿// Protected under GPL-3.0 License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InstancedStruct.h"
+#include "Templates/SubclassOf.h"
+#include "QuestProgressEvent.generated.h"
+
+class UQuestObjective;
+class UQuestProgressionObject;
+
+/**
+ * Value type alternative to UQuestProgressionObject. Carries progress for one objective class
+ * without creating a UObject per event.
+ *
+ * Amount and Tag cover the common counting events, events using only those don't allocate.
+ * Anything else goes into Payload, read it in the objective through GetPayload. Setting a Payload
+ * allocates, FInstancedStruct keeps its value on the heap.
+ */
+USTRUCT(BlueprintType, Category="QuestSystem|Quest|Objective|Progressor")
+struct QUESTSYSTEM_API FQuestProgressEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "QuestObjective")
+	TSubclassOf<UQuestObjective> ObjectiveToProgress = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "QuestObjective")
+	int32 Amount = 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "QuestObjective")
+	FName Tag = NAME_None;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "QuestObjective")
+	FInstancedStruct Payload;
+
+	// Set when the event wraps a legacy progression object, see UQuestObjective::AddProgressEvent
+	UPROPERTY(BlueprintReadOnly, Category = "QuestObjective")
+	TObjectPtr<UQuestProgressionObject> ProgressionObject = nullptr;
+
+	template<typename T>
+	static FQuestProgressEvent Make(TSubclassOf<UQuestObjective> InObjectiveToProgress, const T& InPayload)
+	{
+		FQuestProgressEvent Event;
+		Event.ObjectiveToProgress = InObjectiveToProgress;
+		Event.Payload = FInstancedStruct::Make(InPayload);
+		return Event;
+	}
+
+	static FQuestProgressEvent MakeFromObject(UQuestProgressionObject* InProgressionObject);
+
+	template<typename T>
+	const T* GetPayload() const
+	{
+		return Payload.GetPtr<T>();
+	}
+};
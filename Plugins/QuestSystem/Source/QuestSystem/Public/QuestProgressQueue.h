@@ -0,0 +1,109 @@
+﻿// Protected under GPL-3.0 License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/**
+ * Bounded queue for many producer threads and one consumer, used for the deferred progress of the quest subsystem.
+ * The ring of slots is allocated once by Init, Enqueue and Dequeue never allocate and a full queue refuses new items.
+ *
+ * Every slot carries a sequence number telling producers and the consumer whose turn it is. Producers claim
+ * a position with a CAS on the tail, items of one producer thread are dequeued in the order they were enqueued.
+ */
+template<typename T>
+class TQuestProgressQueue
+{
+public:
+	TQuestProgressQueue() = default;
+	UE_NONCOPYABLE(TQuestProgressQueue);
+
+	// Not thread safe, no producer may run while the ring gets allocated. Capacity is rounded up to a power of two
+	void Init(int32 InCapacity)
+	{
+		const uint32 Capacity = FMath::RoundUpToPowerOfTwo(static_cast<uint32>(FMath::Max(InCapacity, 2)));
+		Slots = MakeUnique<FSlot[]>(Capacity);
+		for (uint32 Index = 0; Index < Capacity; Index++)
+		{
+			Slots[Index].Sequence.store(Index, std::memory_order_relaxed);
+		}
+
+		Mask = Capacity - 1;
+		Head = 0;
+		Tail.store(0, std::memory_order_release);
+	}
+
+	int32 GetCapacity() const { return Slots ? static_cast<int32>(Mask + 1) : 0; }
+
+	/**
+	 * Safe to call from any thread.
+	 *
+	 * @return False if the queue is full or not initialized
+	 */
+	template<typename ItemType>
+	bool Enqueue(ItemType&& Item)
+	{
+		if (!Slots) return false;
+
+		uint64 Position = Tail.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			FSlot& Slot = Slots[Position & Mask];
+			const int64 Lag = static_cast<int64>(Slot.Sequence.load(std::memory_order_acquire)) - static_cast<int64>(Position);
+			if (Lag == 0)
+			{
+				//On failure Position receives the current tail and we try again
+				if (Tail.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed))
+				{
+					Slot.Item = Forward<ItemType>(Item);
+					Slot.Sequence.store(Position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (Lag < 0)
+			{
+				//The consumer did not free this slot yet, the ring is full
+				return false;
+			}
+			else
+			{
+				Position = Tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Consumer thread only
+	bool Dequeue(T& OutItem)
+	{
+		if (!Slots) return false;
+
+		FSlot& Slot = Slots[Head & Mask];
+		if (Slot.Sequence.load(std::memory_order_acquire) != Head + 1) return false;
+
+		OutItem = MoveTemp(Slot.Item);
+		Slot.Sequence.store(Head + Mask + 1, std::memory_order_release);
+		Head++;
+		return true;
+	}
+
+	// Consumer thread only
+	bool IsEmpty() const
+	{
+		return !Slots || Slots[Head & Mask].Sequence.load(std::memory_order_acquire) != Head + 1;
+	}
+
+private:
+	struct FSlot
+	{
+		std::atomic<uint64> Sequence{0};
+		T Item;
+	};
+
+	TUniquePtr<FSlot[]> Slots;
+	uint64 Mask = 0;
+
+	// Producers and the consumer get their own cache line
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> Tail{0};
+	alignas(PLATFORM_CACHE_LINE_SIZE) uint64 Head = 0;
+};
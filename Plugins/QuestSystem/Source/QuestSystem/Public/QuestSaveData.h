@@ -0,0 +1,105 @@
+﻿// Protected under GPL-3.0 License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "QuestEnums.h"
+
+/**
+ * Versions of the binary quest save format. Add new versions above VersionPlusOne and
+ * handle older versions while serializing.
+ */
+enum class EQuestSaveVersion : int32
+{
+	Initial = 1,
+
+	VersionPlusOne,
+	Latest = VersionPlusOne - 1
+};
+
+struct QUESTSYSTEM_API FQuestObjectiveSaveRecord
+{
+	EQuestStatus Status = EQuestStatus::INVALID;
+
+	// Properties of the objective flagged with SaveGame
+	TArray<uint8> SaveGameData;
+
+	friend FArchive& operator<<(FArchive& Ar, FQuestObjectiveSaveRecord& Record);
+};
+
+struct QUESTSYSTEM_API FQuestSaveRecord
+{
+	// Index into FQuestSaveSnapshot::QuestClasses
+	int32 ClassIndex = INDEX_NONE;
+	
+	EQuestStatus Status = EQuestStatus::INVALID;
+
+	// Properties of the quest flagged with SaveGame, empty for quests that only exist as record
+	TArray<uint8> SaveGameData;
+
+	// Matches UQuestObject::QuestObjectives by index
+	TArray<FQuestObjectiveSaveRecord> Objectives;
+
+	friend FArchive& operator<<(FArchive& Ar, FQuestSaveRecord& Record);
+};
+
+struct QUESTSYSTEM_API FQuestOwnerSaveRecord
+{
+	FString Owner;
+	TArray<FQuestSaveRecord> Quests;
+
+	friend FArchive& operator<<(FArchive& Ar, FQuestOwnerSaveRecord& Record);
+};
+
+/**
+ * Plain copy of the quest state of every owner. Gets taken on the game thread and contains no UObject
+ * pointers, so it can be serialized on any thread.
+ */
+struct QUESTSYSTEM_API FQuestSaveSnapshot
+{
+	static constexpr uint32 Magic = 0x51535653; // "QSVS"
+	
+	int32 Version = static_cast<int32>(EQuestSaveVersion::Latest);
+
+	// Every quest class is stored once as path, the quest records refer to it by index
+	TArray<FString> QuestClasses;
+	
+	TArray<FQuestOwnerSaveRecord> Owners;
+
+	/**
+	 * Reads or writes the whole snapshot including header. Sets the archive error when the data
+	 * is not a quest save or has been written by a newer version.
+	 */
+	friend QUESTSYSTEM_API FArchive& operator<<(FArchive& Ar, FQuestSaveSnapshot& Snapshot);
+};
+
+/**
+ * Append-only log of quest changes made after a snapshot. Every quest entry holds the complete state of one quest,
+ * so replaying the journal in order on top of its snapshot yields the latest state no matter how often a quest changed.
+ * Owners and quest classes are written once per journal and referred to by id afterwards, declaring an id again replaces it.
+ */
+struct QUESTSYSTEM_API FQuestJournal
+{
+	static constexpr uint32 Magic = 0x51534A4E; // "QSJN"
+
+	enum class EEntry : uint8
+	{
+		Owner,
+		QuestClass,
+		Quest
+	};
+	
+	static void WriteHeader(FArchive& Ar);
+	static void WriteOwner(FArchive& Ar, int32 OwnerId, FString Owner);
+	static void WriteQuestClass(FArchive& Ar, int32 ClassId, FString ClassPath);
+	
+	// Record.ClassIndex is the journal class id
+	static void WriteQuest(FArchive& Ar, int32 OwnerId, FQuestSaveRecord& Record);
+
+	/**
+	 * Applies the journal onto the snapshot. Stops at the first incomplete entry, the tail a crash while appending leaves behind.
+	 * 
+	 * @return False if the data is not a journal
+	 */
+	static bool Replay(const TArray<uint8>& Data, FQuestSaveSnapshot& Snapshot);
+};
@@ -0,0 +1,50 @@
+﻿// Protected under GPL-3.0 License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "QuestEnums.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("QuestSystem"), STATGROUP_QuestSystem, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Subsystem Tick"), STAT_QuestSystem_Tick, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tick Objectives"), STAT_QuestSystem_TickObjectives, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tick Quests"), STAT_QuestSystem_TickQuests, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Drain Deferred Progress"), STAT_QuestSystem_DrainDeferredProgress, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Delegate Broadcasts"), STAT_QuestSystem_Broadcast, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Journal Flush"), STAT_QuestSystem_JournalFlush, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+
+//Reset every frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Progress Events"), STAT_QuestSystem_ProgressEvents, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Discarded Progress Events"), STAT_QuestSystem_DiscardedEvents, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Lookups"), STAT_QuestSystem_Lookups, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+
+//Quests per status of every owner, set by the subsystem tick. Quests only living in a mounted snapshot are not counted
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Quests Locked"), STAT_QuestSystem_QuestsLocked, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Quests Unlocked"), STAT_QuestSystem_QuestsUnlocked, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Quests Accepted"), STAT_QuestSystem_QuestsAccepted, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Quests Starting"), STAT_QuestSystem_QuestsStarting, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Quests In Progress"), STAT_QuestSystem_QuestsInProgress, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Quests Completed"), STAT_QuestSystem_QuestsCompleted, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Quests Failed"), STAT_QuestSystem_QuestsFailed, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Objectives Ticking"), STAT_QuestSystem_ObjectivesTicking, STATGROUP_QuestSystem, QUESTSYSTEM_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(QUESTSYSTEM_API, QuestSystem);
+
+// Times the scope for the stats group and the QuestSystem CSV category, Stat is the name without STAT_QuestSystem_
+#define QUEST_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(STAT_QuestSystem_##Stat); \
+	CSV_SCOPED_TIMING_STAT(QuestSystem, Stat)
+
+// Adds to a per frame counter of the stats group and the QuestSystem CSV category
+#define QUEST_COUNTER_ADD(Stat, Amount) \
+	INC_DWORD_STAT_BY(STAT_QuestSystem_##Stat, Amount); \
+	CSV_CUSTOM_STAT(QuestSystem, Stat, static_cast<int32>(Amount), ECsvCustomStatOp::Accumulate)
+
+namespace QuestStats
+{
+	void SetQuestsPerStatus(const int32 (&QuestsPerStatus)[QuestStatusCount]);
+	void SetObjectivesTicking(int32 NumObjectives);
+}
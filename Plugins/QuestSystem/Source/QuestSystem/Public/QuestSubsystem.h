@@ -3,12 +3,25 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "QuestDefinition.h"
+#include "QuestDelta.h"
 #include "QuestObject.h"
+#include "QuestMappedSnapshot.h"
+#include "QuestOwnerHandle.h"
+#include "QuestProgressQueue.h"
+#include "QuestSaveData.h"
+#include "QuestStats.h"
+#include "QuestTickManager.h"
+#include "Async/Future.h"
 #include "Subsystems/GameInstanceSubsystem.h"
+#include "Tickable.h"
+#include <atomic>
 #include "QuestSubsystem.generated.h"
 	
 class UQuestObject;
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnQuestsSaved, const FString&, SlotName, bool, bSuccess);
+
 
 #pragma region QuestContainer
 USTRUCT()
@@ -21,6 +34,20 @@ struct FQuestComparator
 
 	UPROPERTY()
 	TSubclassOf<UQuestObject> QuestClass = nullptr;
+
+	//Status of a quest without an object yet, INVALID as soon as the object exists
+	UPROPERTY()
+	EQuestStatus RecordStatus = EQuestStatus::INVALID;
+
+	EQuestStatus GetStatus() const
+	{
+		return IsValid(QuestObject) ? QuestObject->GetStatus() : RecordStatus;
+	}
+
+	bool IsRecord() const
+	{
+		return !IsValid(QuestObject) && RecordStatus != EQuestStatus::INVALID;
+	}
 	
 	
 	bool operator==(const FQuestComparator& other) const
@@ -44,36 +71,209 @@ struct FTArrayQuestComparator
 
 	void Clear()
 	{
-		for (auto Object : QuestObjects)
+		for (const FQuestComparator& Object : QuestObjects)
 		{
-			Object.QuestObject->ConditionalBeginDestroy();
+			if (Object.QuestObject) Object.QuestObject->ConditionalBeginDestroy();
 		}
 
 		QuestObjects.Empty();
+		ClassIndex.Empty();
 	}
-	
+
+	/**
+	 * Mutable access to the underlying array. When adding or removing entries through this
+	 * call RebuildIndex afterwards, otherwise Find will return stale results.
+	 */
 	TArray<FQuestComparator>& GetRef()
 	{
 		return QuestObjects;
 	}
 
-	TArray<FQuestComparator> Get() const
+	const TArray<FQuestComparator>& Get() const
+	{
+		return QuestObjects;
+	}
+
+	/**
+	 * Read only view over the stored comparators. Invalidated when quests get added for this owner.
+	 */
+	TConstArrayView<FQuestComparator> GetView() const
 	{
 		return QuestObjects;
 	}
 
-	FQuestComparator operator[](int Index)
+	int32 Num() const
+	{
+		return QuestObjects.Num();
+	}
+
+	FQuestComparator& operator[](int Index)
+	{
+		return QuestObjects[Index];
+	}
+
+	const FQuestComparator& operator[](int Index) const
+	{
+		return QuestObjects[Index];
+	}
+
+	/**
+	 * Constant time lookup of the comparator holding the given quest class.
+	 * @return The stored comparator or nullptr if this owner has no entry for that class
+	 */
+	FQuestComparator* Find(const UClass* QuestClass)
+	{
+		const int32* Index = ClassIndex.Find(QuestClass);
+		return Index ? &QuestObjects[*Index] : nullptr;
+	}
+
+	const FQuestComparator* Find(const UClass* QuestClass) const
+	{
+		const int32* Index = ClassIndex.Find(QuestClass);
+		return Index ? &QuestObjects[*Index] : nullptr;
+	}
+
+	int32 IndexOf(const UClass* QuestClass) const
+	{
+		const int32* Index = ClassIndex.Find(QuestClass);
+		return Index ? *Index : INDEX_NONE;
+	}
+
+	/**
+	 * Appends the comparator and registers its class in the lookup index.
+	 * Does not check for duplicates, use Find beforehand.
+	 */
+	FQuestComparator& Add(const FQuestComparator& Comparator)
 	{
+		const int32 Index = QuestObjects.Add(Comparator);
+		ClassIndex.Add(Comparator.QuestClass, Index);
 		return QuestObjects[Index];
 	}
+
+	void Reserve(int32 Number)
+	{
+		QuestObjects.Reserve(Number);
+		ClassIndex.Reserve(Number);
+	}
+
+	void RebuildIndex()
+	{
+		ClassIndex.Reset();
+		ClassIndex.Reserve(QuestObjects.Num());
+		for (int32 i = 0; i < QuestObjects.Num(); i++)
+		{
+			ClassIndex.Add(QuestObjects[i].QuestClass, i);
+		}
+	}
+
+private:
+	// Quest class -> index into QuestObjects. Not a UPROPERTY, the array holds the references.
+	TMap<const UClass*, int32> ClassIndex;
+};
+
+/**
+ * Owners holding an instance of one quest class, bucketed by the status of that instance.
+ * Kept up to date by the subsystem so cross owner queries never walk all owners.
+ */
+struct FQuestClassOwners
+{
+	TSet<FQuestOwnerHandle> OwnersByStatus[QuestStatusCount];
+};
+
+/**
+ * A quest of one owner that has at least one IN_PROGRESS objective of a specific class.
+ */
+struct FQuestProgressRouteEntry
+{
+	UQuestObject* Quest = nullptr;
+	
+	// Position of the quest in the owners storage, routes are sorted by it to keep the progress order of the storage
+	int32 StorageIndex = INDEX_NONE;
+
+	// How many objectives of the routed class are in progress in this quest
+	int32 ActiveObjectives = 0;
 };
+
+// (Owner, objective class) -> quests that can currently take progress for that class
+using FQuestProgressRouteKey = TPair<FQuestOwnerHandle, const UClass*>;
+
+// (Owner, quest class)
+using FQuestJournalKey = TPair<FQuestOwnerHandle, const UClass*>;
 #pragma endregion QuestContainer
 
+USTRUCT()
+struct FQuestObjectPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UQuestObject>> Objects;
+};
+
+#pragma region DeferredProgress
+/**
+ * Progress event queued from any thread. Producers without a handle pass the owner name,
+ * it gets resolved on the game thread.
+ */
+struct FQuestDeferredProgress
+{
+	FQuestOwnerHandle Owner;
+	FString OwnerName;
+	FQuestProgressEvent Event;
+};
+
+USTRUCT(BlueprintType, Category="QuestSystem")
+struct FQuestDeferredProgressStats
+{
+	GENERATED_BODY()
+
+	// Events accepted into the queue
+	UPROPERTY(BlueprintReadOnly, Category="QuestSystem")
+	int64 Enqueued = 0;
+
+	// Events applied on the game thread
+	UPROPERTY(BlueprintReadOnly, Category="QuestSystem")
+	int64 Processed = 0;
+
+	// Events refused because the queue was at MaxDeferredProgressPending or full
+	UPROPERTY(BlueprintReadOnly, Category="QuestSystem")
+	int64 Rejected = 0;
+
+	// Events currently waiting
+	UPROPERTY(BlueprintReadOnly, Category="QuestSystem")
+	int64 Pending = 0;
+
+	// Highest number of waiting events seen at the start of a drain
+	UPROPERTY(BlueprintReadOnly, Category="QuestSystem")
+	int64 PeakPending = 0;
+
+	// Frames that hit MaxDeferredProgressPerFrame and left events for the next frame
+	UPROPERTY(BlueprintReadOnly, Category="QuestSystem")
+	int64 SaturatedFrames = 0;
+};
+#pragma endregion DeferredProgress
+
+/**
+ * Outcome of one owner and quest class of UQuestSubsystem::ApplyCommandToQuests.
+ */
+USTRUCT(BlueprintType, Category="QuestSystem")
+struct FQuestCommandResult
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="QuestSystem")
+	bool bSuccess = false;
+
+	// Status of the quest after the command, INVALID if the owner or quest class was invalid
+	UPROPERTY(BlueprintReadOnly, Category="QuestSystem")
+	EQuestStatus Status = EQuestStatus::INVALID;
+};
+
 /**
  * 
  */
 UCLASS()
-class QUESTSYSTEM_API UQuestSubsystem : public UGameInstanceSubsystem
+class QUESTSYSTEM_API UQuestSubsystem : public UGameInstanceSubsystem, public FTickableGameObject
 {
 	GENERATED_BODY()
 
@@ -82,12 +282,90 @@ public:
 	
 	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
 	virtual void Deinitialize() override;
+
+	// Keeps the reward templates of the compiled quest definitions alive
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
+#pragma region TickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override
+	{
+		return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+	}
+	virtual TStatId GetStatId() const override
+	{
+		return GET_STATID(STAT_QuestSystem_Tick);
+	}
+	virtual bool IsTickableWhenPaused() const override
+	{
+		return true;
+	}
+	virtual bool IsTickableInEditor() const override
+	{
+		return false;
+	}
+	virtual bool IsTickable() const override
+	{
+		return bInitialized;
+	}
+#pragma endregion TickableGameObject
+
+	// Whether quests and objectives keep ticking while the game is paused
+	UPROPERTY(BlueprintReadWrite, Category = "QuestSystem")
+	bool bTickQuestsWhenPaused = false;
+
+	// Milliseconds objectives may spend ticking per frame, objectives over budget continue next frame. 0 or less means no limit
+	UPROPERTY(BlueprintReadWrite, Category = "QuestSystem")
+	float QuestTickBudgetMs = 0.f;
+
+	// How many deferred progress events get applied per frame at most, 0 or less means no limit
+	UPROPERTY(BlueprintReadWrite, Category = "QuestSystem")
+	int32 MaxDeferredProgressPerFrame = 4096;
+
+	// How many deferred progress events may wait at most before new ones get rejected, 0 or less means only DeferredProgressCapacity limits
+	UPROPERTY(BlueprintReadWrite, Category = "QuestSystem")
+	int32 MaxDeferredProgressPending = 0;
+
+	// Size of the deferred progress queue, allocated once in Initialize
+	static constexpr int32 DeferredProgressCapacity = 16384;
 	
+	// Quest storage per owner, indexed by FQuestOwnerHandle::GetIndex()
 	UPROPERTY()
-	TMap<FString, FTArrayQuestComparator> Quests = TMap<FString, FTArrayQuestComparator>();
+	TArray<FTArrayQuestComparator> Quests = TArray<FTArrayQuestComparator>();
+
+	/**
+	 * Interns the owner name and returns its handle. Use the handle based overloads in hot code
+	 * to skip hashing the owner string on every call.
+	 * 
+	 * @return The handle for this owner, invalid if the owner is empty
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
+	FQuestOwnerHandle FindOrAddOwnerHandle(const FString& QuestOwner);
+
+	/**
+	 * @return The handle for this owner, invalid if the owner has never been registered
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
+	FQuestOwnerHandle FindOwnerHandle(const FString& QuestOwner) const;
+
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
+	FString GetOwnerName(FQuestOwnerHandle QuestOwner) const;
+
+	/**
+	 * Creates the quest object first when the quest is only stored as a record.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
+	UQuestObject* GetQuestObject(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner);
+	UQuestObject* GetQuestObject(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner);
 
+	/**
+	 * Same as GetQuestObject(...)->GetStatus() without creating the object of a quest record.
+	 * 
+	 * @return INVALID if the owner does not have the quest
+	 */
 	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
-	UQuestObject* GetQuestObject(TSubclassOf<UQuestObject> QuestClass, FString QuestOwner) const;
+	EQuestStatus GetQuestStatus(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner) const;
+	EQuestStatus GetQuestStatus(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner) const;
 
 	/**
 	 * @param QuestClass 
@@ -96,8 +374,45 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
 	FString GetQuestOwner(TSubclassOf<UQuestObject> QuestClass) const;
 
+	/**
+	 * @param QuestClass 
+	 * @param StatusFilter Only owners whose quest has this status. INVALID returns every owner that has the quest unlocked.
+	 * @return All owners holding the quest class with the given status
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
+	TArray<FString> GetQuestOwners(TSubclassOf<UQuestObject> QuestClass, EQuestStatus StatusFilter = EQuestStatus::INVALID) const;
+	void GetQuestOwnerHandles(TSubclassOf<UQuestObject> QuestClass, EQuestStatus StatusFilter, TArray<FQuestOwnerHandle>& OutOwners) const;
+
+	/**
+	 * Creates the objects of all quest records of the owner. Use ForEachQuest or GetQuestStatus if the records are enough.
+	 */
 	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
-	TArray<UQuestObject*> GetQuestObjects(FString QuestsOwner) const;
+	TArray<UQuestObject*> GetQuestObjects(const FString& QuestsOwner);
+	TArray<UQuestObject*> GetQuestObjects(FQuestOwnerHandle QuestsOwner);
+
+	/**
+	 * Read only view over the quests of the owner, does not allocate.
+	 * The view gets invalidated as soon as quests or owners are added, don't hold on to it.
+	 */
+	TConstArrayView<FQuestComparator> GetQuestComparators(FQuestOwnerHandle QuestsOwner) const;
+
+	/**
+	 * Calls the visitor for every valid quest object of the owner without allocating.
+	 * Quests that get added for this owner while visiting are visited as well.
+	 * Quest records are skipped, they have no object yet.
+	 * 
+	 * @param Visitor Return false to stop visiting
+	 */
+	void ForEachQuest(FQuestOwnerHandle QuestsOwner, TFunctionRef<bool(UQuestObject*)> Visitor) const;
+	void ForEachQuest(const FString& QuestsOwner, TFunctionRef<bool(UQuestObject*)> Visitor) const;
+
+	/**
+	 * Writes every quest and its status per owner to the output device, see QuestSystem.Debug.DumpQuests.
+	 * Does not create objects for quest records or fault in mapped quests.
+	 * 
+	 * @param OwnerFilter Only this owner when not empty
+	 */
+	void DumpQuests(FOutputDevice& Ar, const FString& OwnerFilter = FString()) const;
 
 	/**
 	 *	Unlocks the given quest. If the quest does not exist it gets created for the
@@ -108,13 +423,25 @@ public:
 	 * @return The quest object that has been unlocked to do further things like starting.
 	 */
 	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
-	UQuestObject* UnlockQuest(TSubclassOf<UQuestObject> QuestToUnlock, FString QuestOwner);
+	UQuestObject* UnlockQuest(TSubclassOf<UQuestObject> QuestToUnlock, const FString& QuestOwner);
+	UQuestObject* UnlockQuest(TSubclassOf<UQuestObject> QuestToUnlock, FQuestOwnerHandle QuestOwner);
+
+	/**
+	 * Like UnlockQuest, but quests that can be records stay lightweight records.
+	 * GetQuestObject creates the object once it is needed.
+	 * 
+	 * @return True if the quest has been unlocked
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
+	bool UnlockQuestRecord(TSubclassOf<UQuestObject> QuestToUnlock, const FString& QuestOwner);
+	bool UnlockQuestRecord(TSubclassOf<UQuestObject> QuestToUnlock, FQuestOwnerHandle QuestOwner);
 
 	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
 	UQuestObject* UnlockQuestObject(UQuestObject* QuestObject);
 	
 	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
-	bool IsQuestUnlocked(TSubclassOf<UQuestObject> QuestToCheck, FString QuestOwner) const;
+	bool IsQuestUnlocked(TSubclassOf<UQuestObject> QuestToCheck, const FString& QuestOwner) const;
+	bool IsQuestUnlocked(TSubclassOf<UQuestObject> QuestToCheck, FQuestOwnerHandle QuestOwner) const;
 
 	/**
 	 * @param QuestClass Quest class that gets accepted
@@ -122,62 +449,488 @@ public:
 	 * @return The Quest that has been accepted. Returns NULL if the quest is not unlocked. 
 	 */
 	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
-	UQuestObject* AcceptQuest(TSubclassOf<UQuestObject> QuestClass, FString QuestOwner);
+	UQuestObject* AcceptQuest(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner);
+	UQuestObject* AcceptQuest(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner);
 	
 	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
 	UQuestObject* AcceptQuestObject(UQuestObject* QuestObject);
 
 	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
-	UQuestObject* InitializeQuest(TSubclassOf<UQuestObject> QuestClass, FString QuestOwner);
+	UQuestObject* InitializeQuest(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner);
+	UQuestObject* InitializeQuest(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner);
 
 	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
 	UQuestObject* InitializeQuestObject(UQuestObject* QuestObject);
 	
 	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
-	UQuestObject* StartQuest(TSubclassOf<UQuestObject> QuestClass, FString QuestOwner);
+	UQuestObject* StartQuest(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner);
+	UQuestObject* StartQuest(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner);
 
 	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
 	UQuestObject* StartQuestObject(UQuestObject* QuestObject);
 
+	/**
+	 * Puts a finished quest back into UNLOCKED, reusing the existing quest object.
+	 * 
+	 * @return The quest object ready to be accepted again. Returns NULL if the quest is still running.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
+	UQuestObject* RepeatQuest(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner);
+	UQuestObject* RepeatQuest(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner);
+
+	/**
+	 * Removes a quest that is not running from its owner and keeps the object for reuse.
+	 * The next quest of that class created for any owner takes it from the pool instead of allocating.
+	 * Released quests and their objectives lose their delegate bindings, the properties their classes add
+	 * are reset to the class defaults.
+	 * Don't hold on to the released object, it gets handed out again.
+	 * 
+	 * @return True when the quest has been released
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
+	bool ReleaseQuest(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner);
+	bool ReleaseQuest(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner);
+
+	// How many released quest objects are kept per quest class
+	UPROPERTY(BlueprintReadWrite, Category = "QuestSystem")
+	int32 MaxPooledQuestsPerClass = 32;
+
+	/**
+	 * Returns the shared read only definition of the quest class, compiled from its class default object on first use.
+	 * Every quest object of the class points to the same definition, see UQuestObject::GetDefinition.
+	 */
+	TSharedRef<const FQuestDefinition> GetQuestDefinition(TSubclassOf<UQuestObject> QuestClass);
+
+	// Drops the compiled definitions, they get compiled again on next use. Called when classes got reinstanced
+	void ResetQuestDefinitions() { QuestDefinitions.Empty(); }
+
+#pragma region SaveGame
+	UPROPERTY(BlueprintAssignable, Category = "QuestSystem|SaveGame")
+	FOnQuestsSaved OnQuestsSavedDelegate;
+	
+	/**
+	 * Saves the quests of every owner into the save slot. The state gets copied right away,
+	 * writing the file happens on a worker thread. OnQuestsSavedDelegate is broadcast once the file is written.
+	 *
+	 * Saved are quest status, objective status and all quest and objective properties flagged with SaveGame.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|SaveGame")
+	void SaveQuests(const FString& SlotName);
+
+	/**
+	 * Replaces all quests with the ones of the save slot. The quests get restored in their saved status
+	 * without running Unlock, AcceptQuest, StartQuest etc. again.
+	 * 
+	 * @return False if the slot does not exist or could not be read, the quests stay untouched then
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|SaveGame")
+	bool LoadQuests(const FString& SlotName);
+	
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|SaveGame")
+	bool DoesQuestSaveExist(const FString& SlotName) const;
+
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|SaveGame")
+	bool SaveQuestsToMemory(TArray<uint8>& OutData) const;
+
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|SaveGame")
+	bool LoadQuestsFromMemory(const TArray<uint8>& Data);
+	
+	/**
+	 * @param OnSaved Optional, gets called on the game thread with the result
+	 * @return Resolves on the worker thread once the file has been written
+	 */
+	TFuture<bool> SaveQuestsToFileAsync(const FString& FilePath, TUniqueFunction<void(bool)>&& OnSaved = nullptr);
+	bool LoadQuestsFromFile(const FString& FilePath);
+
+	// Copies the state of every quest, needs to run on the game thread
+	void CreateSaveSnapshot(FQuestSaveSnapshot& OutSnapshot) const;
+	bool ApplySaveSnapshot(const FQuestSaveSnapshot& Snapshot);
+
+	static FString GetQuestSaveFilePath(const FString& SlotName);
+
+	/**
+	 * Starts recording every quest change into the journal of the save slot, on top of a fresh snapshot of the slot.
+	 * Changed quests get appended in batches every QuestJournalFlushInterval seconds on a worker thread, so the cost
+	 * depends on how much changed and not on how many quests exist. Use RecoverQuests to bring the state back and
+	 * CompactQuestJournal to fold the journal into the snapshot from time to time.
+	 *
+	 * Recorded are status changes of quests and objectives and quests that received progress. Other changes to
+	 * SaveGame properties (e.g. done in TickObjective) need MarkQuestChanged.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|SaveGame")
+	void EnableQuestJournal(const FString& SlotName);
+
+	// Flushes the pending changes and stops recording
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|SaveGame")
+	void DisableQuestJournal();
+
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|SaveGame")
+	bool IsQuestJournalEnabled() const { return !JournalSlot.IsEmpty(); }
+
+	// Appends all changes since the last flush to the journal
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|SaveGame")
+	void FlushQuestJournal();
+
+	// Writes a new snapshot of the journaled slot and starts a new journal once the snapshot is written, a failed snapshot keeps the journal
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|SaveGame")
+	void CompactQuestJournal();
+
+	/**
+	 * Loads the snapshot of the slot and replays its journal on top, bringing back the state of the last flush.
+	 * 
+	 * @return False if neither snapshot nor journal could be read
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|SaveGame")
+	bool RecoverQuests(const FString& SlotName);
+
+	// Records the quest with the next journal flush and the next quest delta of its owner
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|SaveGame")
+	void MarkQuestChanged(const UQuestObject* Quest);
+	void MarkQuestChanged(FQuestOwnerHandle Owner, const UClass* QuestClass)
+	{
+		if (bQuestChangesSuspended) return;
+		if (IsQuestJournalEnabled()) JournalChangedQuests.Add(FQuestJournalKey(Owner, QuestClass));
+		if (IsQuestDeltaTrackingEnabled()) MarkQuestDeltaChanged(Owner, QuestClass);
+	}
+
+	// Seconds between two journal flushes, 0 or less flushes every frame
+	UPROPERTY(BlueprintReadWrite, Category = "QuestSystem|SaveGame")
+	float QuestJournalFlushInterval = 1.f;
+
+	static FString GetQuestJournalFilePath(const FString& SlotName);
+
+	// Blocks until every snapshot and journal batch launched so far is written
+	static void WaitForQuestWrites();
+
+	/**
+	 * Writes the quests of every owner as mapped snapshot of the slot on a worker thread, see MountQuestSnapshot.
+	 * OnQuestsSavedDelegate is broadcast once the file is written. The slot that is currently mounted is still mapped
+	 * and gets refused, OnQuestsSavedDelegate is broadcast with failure right away then.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|SaveGame")
+	void SaveQuestSnapshot(const FString& SlotName);
+
+	/**
+	 * Replaces all quests with the mapped snapshot of the slot. The file gets mapped into memory and status queries
+	 * (GetQuestStatus, IsQuestUnlocked, GetQuestOwner(s)) read it directly. A quest only gets restored once it is
+	 * touched by a command, GetQuestObject(s) or ReleaseQuest. Quests in progress get restored right away since they
+	 * tick and take progress. The snapshot stays mounted until ClearQuests or the next load.
+	 * 
+	 * @return False if the slot has no valid mapped snapshot, the quests stay untouched then
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|SaveGame")
+	bool MountQuestSnapshot(const FString& SlotName);
+
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|SaveGame")
+	bool IsQuestSnapshotMounted() const { return MappedSnapshot.IsValid(); }
+
+	static FString GetQuestSnapshotFilePath(const FString& SlotName);
+#pragma endregion SaveGame
+
+#pragma region Replication
+	/**
+	 * Starts tracking quest changes per owner, so CreateQuestDelta can send clients only what changed since the
+	 * version they acknowledged. The same changes as for the journal are tracked, see EnableQuestJournal.
+	 * Every call starts a new epoch, versions acknowledged before receive the full state.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|Replication")
+	void EnableQuestDeltaTracking();
+
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|Replication")
+	void DisableQuestDeltaTracking();
+
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem|Replication")
+	bool IsQuestDeltaTrackingEnabled() const { return QuestDeltaEpoch != 0; }
+
+	/**
+	 * Collects the quest changes of the owner since the acknowledged version. Versions that are too old, from another
+	 * epoch or unknown receive the full state of the owner instead. Apply the delta with FQuestDeltaMirror.
+	 * 
+	 * @return False when tracking is disabled or the acknowledged version is up to date
+	 */
+	bool CreateQuestDelta(FQuestOwnerHandle Owner, const FQuestDeltaVersion& Acknowledged, FQuestDelta& OutDelta) const;
+
+	/**
+	 * Drops the changes up to the acknowledged version, keeping the tracking memory small.
+	 * Receivers still on an older version get the full state afterwards.
+	 */
+	void AcknowledgeQuestDelta(FQuestOwnerHandle Owner, const FQuestDeltaVersion& Acknowledged);
+
+	FQuestDeltaVersion GetQuestDeltaVersion(FQuestOwnerHandle Owner) const;
+#pragma endregion Replication
+
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
+	void AddProgress(const FString& QuestOwner, UQuestProgressionObject* Progressor, TSubclassOf<UQuestObject> QuestClass);
+	void AddProgress(FQuestOwnerHandle QuestOwner, UQuestProgressionObject* Progressor, TSubclassOf<UQuestObject> QuestClass);
+
+	/**
+	 * Version of AddProgress without a progression object, allocation free for events without Payload. Without a QuestClass the event goes to every quest that can take it
+	 * until one of them consumes it.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
+	void AddProgressEvent(const FString& QuestOwner, const FQuestProgressEvent& Event, TSubclassOf<UQuestObject> QuestClass);
+	void AddProgressEvent(FQuestOwnerHandle QuestOwner, const FQuestProgressEvent& Event, TSubclassOf<UQuestObject> QuestClass);
+
+	/**
+	 * Applies many events in one pass. Every event is routed like AddProgressEvent without a QuestClass,
+	 * but each affected quest broadcasts its progress once and checks for completion once, after all events.
+	 * Events are grouped by objective class and the route of each class is looked up once. The groups are applied
+	 * in the order their classes first appear in Events, the events of one objective class in the order given.
+	 * Quests overriding ProgressQuestEvent in a blueprint get every event through it instead, like from AddProgressEvent.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
+	void AddProgressBatch(const FString& QuestOwner, const TArray<FQuestProgressEvent>& Events);
+	void AddProgressBatch(FQuestOwnerHandle QuestOwner, TConstArrayView<FQuestProgressEvent> Events);
+
+	/**
+	 * Queues progress to be applied on the game thread during the next subsystem tick.
+	 * Safe to call from any thread. Events of one producer thread are applied in the order they were queued.
+	 * Do not pass events wrapping a progression object from other threads, the queue does not keep it alive.
+	 * 
+	 * @return False when the queue is full, see MaxDeferredProgressPending and DeferredProgressCapacity
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
+	bool EnqueueProgress(const FString& QuestOwner, const FQuestProgressEvent& Event);
+	bool EnqueueProgress(FQuestOwnerHandle QuestOwner, const FQuestProgressEvent& Event);
+
+	/**
+	 * Applies queued progress, at most MaxDeferredProgressPerFrame events. Gets called every tick.
+	 */
+	void DrainDeferredProgress();
+
 	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
-	void AddProgress(FString QuestOwner, UQuestProgressionObject* Progressor, TSubclassOf<UQuestObject> QuestClass);
+	FQuestDeferredProgressStats GetDeferredProgressStats() const;
 	
 	/**
 	 * 
 	 * @param QuestClass The quest which should receive the command
 	 * @param QuestOwner The owner of the quest object
 	 * @param QuestCommand 
-	 * @return The quest object that received the command. Returns NULL if the command failed
+	 * @return The quest object that received the command. Returns NULL if the command failed.
+	 * The object of a quest kept as record gets created, use ApplyCommand to keep the record
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
+	UQuestObject* ApplyCommandToQuest(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner, EQuestEnterCommand QuestCommand);
+	UQuestObject* ApplyCommandToQuest(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner, EQuestEnterCommand QuestCommand);
+
+	/**
+	 * Like ApplyCommandToQuest, but returns whether the command succeeded instead of the quest object. Locked and
+	 * unlocked quests are kept as records until another command or GetQuestObject needs the object.
+	 * 
+	 * @return True if the command succeeded
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
+	bool ApplyCommand(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner, EQuestEnterCommand QuestCommand);
+	bool ApplyCommand(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner, EQuestEnterCommand QuestCommand);
+
+	/**
+	 * Runs every command on the way from the current status of the quest to TargetStatus, e.g. UNLOCK, ACCEPT, INITIALIZE
+	 * and START for a quest the owner does not have yet and IN_PROGRESS. The quest is looked up once and the subsystem
+	 * updates its bookkeeping once for the whole chain. Finished quests are not repeated, see RepeatQuest.
+	 * 
+	 * @return The quest object if it reached TargetStatus. Returns NULL if TargetStatus can't be reached or a command of the chain failed,
+	 * the quest then keeps the status of the last command that succeeded
+	 */
+	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
+	UQuestObject* AdvanceQuestTo(TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner, EQuestStatus TargetStatus);
+	UQuestObject* AdvanceQuestTo(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner, EQuestStatus TargetStatus);
+
+	/**
+	 * ApplyCommand for every owner and every quest class, e.g. unlocking a quest set for all players at once.
+	 * Owners get registered and their storage is sized once up front. Unlocking quests that can be kept
+	 * as records and that the owner does not have yet skips the per quest command entirely.
+	 * Quests that need their object still get it created one at a time through the regular command.
+	 * 
+	 * @return One result per owner and quest class, the result of QuestOwners[i] and QuestClasses[j] is at i * QuestClasses.Num() + j
 	 */
 	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
-	UQuestObject* ApplyCommandToQuest(TSubclassOf<UQuestObject> QuestClass, FString QuestOwner, EQuestEnterCommand QuestCommand);
+	TArray<FQuestCommandResult> ApplyCommandToQuests(const TArray<TSubclassOf<UQuestObject>>& QuestClasses, const TArray<FString>& QuestOwners,
+		EQuestEnterCommand QuestCommand);
+	void ApplyCommandToQuests(TConstArrayView<TSubclassOf<UQuestObject>> QuestClasses, TConstArrayView<FQuestOwnerHandle> QuestOwners,
+		EQuestEnterCommand QuestCommand, TArray<FQuestCommandResult>& OutResults);
 	
 	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
-	bool EnsurePlayerEntryExists(FString Owner);
+	bool EnsurePlayerEntryExists(const FString& Owner);
 	
 	UFUNCTION(BlueprintCallable, Category = "QuestSystem")
 	void ClearQuests();
 
 private:
-	UFUNCTION()
-	FQuestComparator& GetQuestComparatorForPlayer(TSubclassOf<UQuestObject> QuestClass, const FString Controller);
+	FTArrayQuestComparator* FindOwnerQuests(FQuestOwnerHandle Owner)
+	{
+		return Quests.IsValidIndex(Owner.GetIndex()) ? &Quests[Owner.GetIndex()] : nullptr;
+	}
 
+	const FTArrayQuestComparator* FindOwnerQuests(FQuestOwnerHandle Owner) const
+	{
+		return Quests.IsValidIndex(Owner.GetIndex()) ? &Quests[Owner.GetIndex()] : nullptr;
+	}
+	
 	UFUNCTION()
-	FQuestComparator CreateNewComparator(TSubclassOf<UQuestObject> QuestClass, FString Owner, bool AutoUnlocked = false);
+	FQuestComparator CreateNewComparator(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner, bool AutoUnlocked = false);
 
 	/**
-	 *	Adds the comparison object for quests to the list of the owning controller if there is none with
-	 *	the same quest class.
-	 * 
-	 * @param Comparator The Comparator, including the QuestObject, to add to the list of available quests
-	 * @param Owner The controlling owner of the quest object
-	 * @return True when the comparator has been added, meaning no other comparator has the same quest class
+	 * Returns the quest object of the owner, creating it from the record or creating a new locked quest
+	 * when the owner does not have the quest yet.
 	 */
-	UFUNCTION()
-	bool AddQuestComparator(FQuestComparator& Comparator, FString Owner);
+	UQuestObject* MaterializeQuest(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner);
+
+	/**
+	 * @return True if the quest class can be kept as a record while locked or unlocked, see UQuestObject::bCreateObjectOnDemand
+	 */
+	static bool SupportsQuestRecords(TSubclassOf<UQuestObject> QuestClass);
+
+	/**
+	 * Moves the quest owner into the bucket of the quests current status and updates the quests tick registration.
+	 * Needs to be called after every status transition of a stored quest.
+	 */
+	void OnQuestStatusChanged(UQuestObject* Quest, EQuestStatus OldStatus);
+
+	void RemoveFromQuestOwnerIndex(const UClass* QuestClass, FQuestOwnerHandle Owner);
+
+	void UpdateQuestOwnerIndex(const UClass* QuestClass, FQuestOwnerHandle Owner, EQuestStatus OldStatus, EQuestStatus NewStatus);
+
+	// Runs the command on the quest object without updating the subsystem, callers follow up with OnQuestStatusChanged
+	static bool ExecuteQuestCommand(UQuestObject* QuestObject, EQuestEnterCommand QuestCommand);
+
+	/**
+	 * Adds or removes the objectives quest from the progress routes and the objective from the
+	 * tick manager when the objective enters or leaves IN_PROGRESS.
+	 */
+	void OnObjectiveStatusChanged(UQuestObjective* Objective, EQuestStatus OldStatus);
+
+	using FRoutedQuestArray = TArray<UQuestObject*, TInlineAllocator<8>>;
+	
+	/**
+	 * Copies the quests of the owner that can take progress for the objective class.
+	 * Copied since progressing them can change the route.
+	 */
+	void GetRoutedQuests(FQuestOwnerHandle Owner, const UClass* ObjectiveClass, FRoutedQuestArray& OutQuests) const;
 	
 	// Do not edit, this is needed to have access to an invalid QuestComparator which we can use as a non const return value
 	UPROPERTY()
 	FQuestComparator InvalidQuestComparator = FQuestComparator();
+
+	// Owner name -> handle, case insensitive like the owner names always were
+	TMap<FString, FQuestOwnerHandle> OwnerHandles;
+
+	// Handle index -> owner name
+	TArray<FString> OwnerNames;
+
+	// Quest class -> owners holding it, see FQuestClassOwners
+	TMap<const UClass*, FQuestClassOwners> QuestClassOwners;
+
+	// Dispatch table for progress without a quest class, see OnObjectiveStatusChanged
+	TMap<FQuestProgressRouteKey, TArray<FQuestProgressRouteEntry>> ProgressRoutes;
+
+	// Changes whenever an objective enters or leaves a route, batched progress only looks routes up again then
+	uint32 ProgressRoutesVersion = 0;
+
+	bool EnqueueProgressInternal(FQuestDeferredProgress&& Progress);
+
+	// AddProgressBatch, the deferred queue skips the grouping by class to keep the order the events were queued in
+	void AddProgressBatchInternal(FQuestOwnerHandle QuestOwner, TConstArrayView<FQuestProgressEvent> Events, bool bGroupByClass);
+
+	UPROPERTY(Transient)
+	FQuestTickManager QuestTickManager;
+
+	// Released quest objects per class, see ReleaseQuest
+	UPROPERTY(Transient)
+	TMap<TSubclassOf<UQuestObject>, FQuestObjectPool> QuestPools;
+
+	UQuestObject* TakePooledQuest(TSubclassOf<UQuestObject> QuestClass);
+
+	// Compiled definitions per quest class, see GetQuestDefinition
+	TMap<const UClass*, TSharedRef<FQuestDefinition>> QuestDefinitions;
+
+	void RestoreQuest(FQuestOwnerHandle Owner, TSubclassOf<UQuestObject> QuestClass, const FQuestSaveRecord& Record);
+
+	// Copies status, SaveGame properties and objectives of the quest, ClassIndex is left to the caller
+	void FillQuestSaveRecord(const FQuestComparator& Comparator, FQuestSaveRecord& OutRecord, TMap<const UClass*, bool>& SaveGameClasses) const;
+
+	// Same for a quest that might only be mapped or not exist at all, the latter keeps the INVALID status
+	void FillQuestSaveRecord(FQuestOwnerHandle Owner, const UClass* QuestClass, FQuestSaveRecord& OutRecord, TMap<const UClass*, bool>& SaveGameClasses) const;
+
+	// Copies every quest of the owner including untouched mapped quests, GetClassIndex provides the ClassIndex of the records
+	void FillOwnerSaveRecord(FQuestOwnerHandle Owner, FQuestOwnerSaveRecord& OutRecord, TFunctionRef<int32(const UClass*)> GetClassIndex,
+		TMap<const UClass*, bool>& SaveGameClasses) const;
+
+	// Save slot the journal is written for, empty while journaling is disabled
+	FString JournalSlot;
+
+	// Quests changed since the last journal flush
+	TSet<FQuestJournalKey> JournalChangedQuests;
+
+	// Owner handle indices and quest classes already written to the current journal, the classes with their journal id
+	TSet<int32> JournalOwners;
+	TMap<const UClass*, int32> JournalClasses;
+
+	void UnmountQuestSnapshot();
+
+	// Publishes the quest counts to the stats group and the CSV profiler, does nothing when both are compiled out
+	void UpdateQuestStats() const;
+
+	void MarkQuestDeltaChanged(FQuestOwnerHandle Owner, const UClass* QuestClass);
+
+	// Every owner has to receive its full state again, used after the quests got replaced
+	void ResetQuestDeltas();
+
+	// Indexed by owner handle, owners without entry have not changed yet
+	TArray<FQuestDeltaOwner> QuestDeltaOwners;
+
+	// 0 while delta tracking is disabled
+	uint32 QuestDeltaEpoch = 0;
+
+	// Mapped quest of the owner, nullptr if there is none or the quest already lives in Quests
+	const FQuestMappedSnapshot::FQuest* FindMappedQuest(FQuestOwnerHandle Owner, const UClass* QuestClass) const;
+
+	// Visits the mapped quests of the owner that don't live in Quests yet and whose class could be resolved
+	void ForEachMappedOwnerQuest(FQuestOwnerHandle Owner, TFunctionRef<void(TSubclassOf<UQuestObject>, const FQuestMappedSnapshot::FQuest&)> Visitor) const;
+
+	// Visits the owners with a mapped quest of the class that does not live in Quests yet, return false to stop
+	void ForEachMappedClassOwner(TSubclassOf<UQuestObject> QuestClass, TFunctionRef<bool(FQuestOwnerHandle, EQuestStatus)> Visitor) const;
+
+	// Moves the mapped quest into Quests, does nothing if the quest is not mapped or already lives there
+	void FaultInMappedQuest(TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner);
+	void FaultInMappedOwner(FQuestOwnerHandle Owner);
+
+	TUniquePtr<FQuestMappedSnapshot> MappedSnapshot;
+	FString MappedSnapshotSlot;
+	
+	// Mapped class index -> resolved class, nullptr if the class doesn't exist anymore
+	UPROPERTY(Transient)
+	TArray<TSubclassOf<UQuestObject>> MappedClasses;
+	TMap<const UClass*, int32> MappedClassIndices;
+
+	// Mapped owner index -> owner handle and handle index -> mapped owner index
+	TArray<FQuestOwnerHandle> MappedOwners;
+	TArray<int32> MappedOwnerIndices;
+
+	// The next flush starts a new journal, see CompactQuestJournal
+	bool bStartNewJournal = true;
+
+	// Result of the last compaction, written by its task on the save pipe and read by the append tasks after it
+	TSharedRef<bool, ESPMode::ThreadSafe> JournalSnapshotWritten = MakeShared<bool, ESPMode::ThreadSafe>(false);
+	
+	bool bQuestChangesSuspended = false;
+	float JournalFlushTimer = 0.f;
+
+	TQuestProgressQueue<FQuestDeferredProgress> DeferredProgress;
+
+	// Reused every drain to avoid per frame allocations
+	TArray<FQuestDeferredProgress> DrainedProgress;
+	TArray<FQuestProgressEvent> DrainedBatch;
+
+	std::atomic<int64> DeferredEnqueued{0};
+	std::atomic<int64> DeferredRejected{0};
+	std::atomic<int64> DeferredPending{0};
+	int64 DeferredProcessed = 0;
+	int64 DeferredPeakPending = 0;
+	int64 DeferredSaturatedFrames = 0;
+
+	bool bInitialized = false;
+
+	friend class UQuestObject;
+	friend class UQuestObjective;
 };
 
@@ -0,0 +1,75 @@
+﻿// Protected under GPL-3.0 License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "QuestTickManager.generated.h"
+
+class UQuestObject;
+class UQuestObjective;
+
+USTRUCT()
+struct FQuestObjectiveTickEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TObjectPtr<UQuestObjective> Objective = nullptr;
+
+	// Manager clock at the last tick of this objective, the next tick receives the time passed since
+	double LastTickTime = 0.0;
+};
+
+/**
+ * Ticks every quest and objective of the quest subsystem from one place.
+ * Only objectives that are IN_PROGRESS and need tick, and quests that are IN_PROGRESS with ShouldTick enabled
+ * are registered. Both live in contiguous arrays and get called directly, nothing is broadcast.
+ *
+ * Objectives tick at their TickInterval and can be time sliced: with a budget the pass stops once the budget
+ * is used up and continues with the next objective in the following frame. Objectives that had to wait receive
+ * the whole time that passed since their last tick.
+ *
+ * Registration is driven by the status changes the subsystem gets notified about.
+ */
+USTRUCT()
+struct QUESTSYSTEM_API FQuestTickManager
+{
+	GENERATED_BODY()
+
+	void RegisterObjective(UQuestObjective* Objective);
+	void UnregisterObjective(UQuestObjective* Objective);
+	
+	void RegisterQuest(UQuestObject* Quest);
+	void UnregisterQuest(UQuestObject* Quest);
+
+	/**
+	 * @param DeltaTime Frame time
+	 * @param BudgetMs Time objectives may spend ticking this frame, 0 or less means no limit. Quests are not budgeted.
+	 */
+	void Tick(float DeltaTime, float BudgetMs = 0.f);
+
+	// Drops every registration
+	void Reset();
+
+	int32 NumTickingObjectives() const { return Objectives.Num(); }
+	int32 NumTickingQuests() const { return Quests.Num(); }
+
+private:
+	void TickObjectives(float BudgetMs);
+	void Compact();
+	
+	UPROPERTY(Transient)
+	TArray<FQuestObjectiveTickEntry> Objectives;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UQuestObject>> Quests;
+
+	// Sum of all ticked DeltaTimes
+	double Clock = 0.0;
+
+	// Round robin position in Objectives where the next pass starts
+	int32 NextObjective = 0;
+
+	bool bTicking = false;
+	bool bNeedsCompaction = false;
+};
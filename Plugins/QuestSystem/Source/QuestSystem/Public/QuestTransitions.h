@@ -0,0 +1,111 @@
+﻿// Protected under GPL-3.0 License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "QuestEnums.h"
+
+/**
+ * The quest state machine. Every status change a EQuestEnterCommand can cause is listed in Table,
+ * the quest objects and the subsystem only ever move quests along these transitions.
+ * Quests finish through their objectives, those transitions are not driven by commands and not listed.
+ */
+namespace QuestTransitions
+{
+	struct FTransition
+	{
+		EQuestStatus From;
+		EQuestEnterCommand Command;
+		EQuestStatus To;
+	};
+
+	inline constexpr FTransition Table[] = {
+		{EQuestStatus::LOCKED, EQuestEnterCommand::UNLOCK, EQuestStatus::UNLOCKED},
+		{EQuestStatus::UNLOCKED, EQuestEnterCommand::ACCEPT, EQuestStatus::ACCEPTED},
+		{EQuestStatus::ACCEPTED, EQuestEnterCommand::INITIALIZE, EQuestStatus::STARTING},
+		{EQuestStatus::STARTING, EQuestEnterCommand::START, EQuestStatus::IN_PROGRESS},
+		{EQuestStatus::COMPLETED, EQuestEnterCommand::REPEAT, EQuestStatus::UNLOCKED},
+		{EQuestStatus::FAILED, EQuestEnterCommand::REPEAT, EQuestStatus::UNLOCKED},
+	};
+
+	// @return The status the command leads to, INVALID if the command is not allowed in From
+	constexpr EQuestStatus GetTarget(EQuestStatus From, EQuestEnterCommand Command)
+	{
+		for (const FTransition& Transition : Table)
+		{
+			if (Transition.From == From && Transition.Command == Command) return Transition.To;
+		}
+		return EQuestStatus::INVALID;
+	}
+
+	constexpr bool CanApply(EQuestStatus From, EQuestEnterCommand Command)
+	{
+		return GetTarget(From, Command) != EQuestStatus::INVALID;
+	}
+
+	// REPEAT starts a quest over, chains never pass through it on their own
+	constexpr bool IsForward(const FTransition& Transition)
+	{
+		return Transition.Command != EQuestEnterCommand::REPEAT;
+	}
+
+	/**
+	 * Next command of the chain of forward commands leading from From to To.
+	 * @return False if To can't be reached from From or From already is To
+	 */
+	constexpr bool GetNextCommand(EQuestStatus From, EQuestStatus To, EQuestEnterCommand& OutCommand)
+	{
+		for (const FTransition& First : Table)
+		{
+			if (First.From != From || !IsForward(First)) continue;
+
+			//Forward transitions form a chain, walking it can't take more steps than there are statuses
+			EQuestStatus Status = First.To;
+			for (int32 Step = 0; Step < QuestStatusCount; Step++)
+			{
+				if (Status == To)
+				{
+					OutCommand = First.Command;
+					return true;
+				}
+
+				EQuestStatus Next = EQuestStatus::INVALID;
+				for (const FTransition& Transition : Table)
+				{
+					if (Transition.From == Status && IsForward(Transition)) Next = Transition.To;
+				}
+				if (Next == EQuestStatus::INVALID) break;
+				Status = Next;
+			}
+		}
+		return false;
+	}
+
+	constexpr bool IsReachable(EQuestStatus From, EQuestStatus To)
+	{
+		EQuestEnterCommand Command = EQuestEnterCommand::UNLOCK;
+		return From == To || GetNextCommand(From, To, Command);
+	}
+
+	constexpr bool IsDeterministic()
+	{
+		constexpr int32 NumTransitions = static_cast<int32>(UE_ARRAY_COUNT(Table));
+		for (int32 i = 0; i < NumTransitions; i++)
+		{
+			if (Table[i].From == EQuestStatus::INVALID || Table[i].To == EQuestStatus::INVALID) return false;
+			
+			for (int32 j = i + 1; j < NumTransitions; j++)
+			{
+				if (Table[i].From == Table[j].From && Table[i].Command == Table[j].Command) return false;
+				if (Table[i].From == Table[j].From && IsForward(Table[i]) && IsForward(Table[j])) return false;
+			}
+		}
+		return true;
+	}
+
+	static_assert(IsDeterministic(), "Every status may have one target per command and one forward transition");
+	static_assert(IsReachable(EQuestStatus::LOCKED, EQuestStatus::IN_PROGRESS), "A locked quest has to be able to run");
+	static_assert(!IsReachable(EQuestStatus::IN_PROGRESS, EQuestStatus::UNLOCKED), "Running quests can't be restarted by a command");
+	static_assert(CanApply(EQuestStatus::COMPLETED, EQuestEnterCommand::REPEAT) && CanApply(EQuestStatus::FAILED, EQuestEnterCommand::REPEAT),
+		"Finished quests have to be repeatable");
+}
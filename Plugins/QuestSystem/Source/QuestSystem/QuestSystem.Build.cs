@@ -26,6 +26,7 @@ public class QuestSystem : ModuleRules
 			new string[]
 			{
 				"Core",
+				"StructUtils",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
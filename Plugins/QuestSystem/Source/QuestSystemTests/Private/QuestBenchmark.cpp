@@ -0,0 +1,161 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestBenchmark.h"
+#include "QuestLog.h"
+#include "QuestObject.h"
+#include "HAL/FileManager.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/SoftObjectPath.h"
+
+namespace QuestBenchmark
+{
+	void ParseList(const TCHAR* Params, const TCHAR* Key, TArray<int32>& InOutList)
+	{
+		FString Value;
+		if (!FParse::Value(Params, Key, Value, false)) return;
+
+		TArray<FString> Entries;
+		Value.ParseIntoArray(Entries, TEXT(","));
+		
+		InOutList.Reset();
+		for (const FString& Entry : Entries)
+		{
+			InOutList.Add(FCString::Atoi(*Entry));
+		}
+	}
+
+	FConfig ParseConfig(const TCHAR* Params)
+	{
+		FConfig Config;
+		ParseList(Params, TEXT("Owners="), Config.OwnerCounts);
+		ParseList(Params, TEXT("Quests="), Config.QuestsPerOwner);
+		ParseList(Params, TEXT("Objectives="), Config.ObjectivesPerQuest);
+		FParse::Value(Params, TEXT("Repeats="), Config.Repeats);
+		FParse::Value(Params, TEXT("Output="), Config.OutputPath);
+
+		FString QuestClasses;
+		if (FParse::Value(Params, TEXT("QuestClasses="), QuestClasses, false))
+		{
+			TArray<FString> ClassPaths;
+			QuestClasses.ParseIntoArray(ClassPaths, TEXT(","));
+			for (const FString& ClassPath : ClassPaths)
+			{
+				if (UClass* QuestClass = FSoftClassPath(ClassPath).TryLoadClass<UQuestObject>())
+				{
+					Config.QuestClasses.Add(QuestClass);
+				}
+				else
+				{
+					UE_LOG(LogQuestSystem, Warning, TEXT("QuestBenchmark: %s is not a quest class"), *ClassPath);
+				}
+			}
+		}
+
+		//The objectives come with the classes of the game
+		if (Config.QuestClasses.Num() > 0)
+		{
+			Config.ObjectivesPerQuest = {0};
+			for (int32& Quests : Config.QuestsPerOwner)
+			{
+				Quests = FMath::Min(Quests, Config.QuestClasses.Num());
+			}
+		}
+
+		Config.Repeats = FMath::Max(Config.Repeats, 1);
+		if (Config.OutputPath.IsEmpty())
+		{
+			Config.OutputPath = FPaths::ProjectSavedDir() / TEXT("QuestSystem") / TEXT("Benchmarks")
+				/ FString::Printf(TEXT("QuestBenchmark_%s.csv"), *FDateTime::Now().ToString());
+		}
+		
+		return Config;
+	}
+
+	FString GetPluginVersion()
+	{
+		const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("QuestSystem"));
+		return Plugin.IsValid() ? Plugin->GetDescriptor().VersionName : TEXT("Unknown");
+	}
+}
+
+const QuestBenchmark::FConfig& QuestBenchmark::GetConfig()
+{
+	static const FConfig Config = []()
+	{
+		FString Params;
+		FParse::Value(FCommandLine::Get(), TEXT("QuestBenchmark="), Params, false);
+		return ParseConfig(*Params);
+	}();
+	return Config;
+}
+
+double QuestBenchmark::FResult::GetMinNs() const
+{
+	return NsPerOperation.Num() > 0 ? FMath::Min(NsPerOperation) : 0.0;
+}
+
+double QuestBenchmark::FResult::GetMedianNs() const
+{
+	if (NsPerOperation.Num() == 0) return 0.0;
+	
+	TArray<double> Sorted = NsPerOperation;
+	Sorted.Sort();
+	return Sorted[Sorted.Num() / 2];
+}
+
+QuestBenchmark::FResult& QuestBenchmark::FScenario::FindOrAddResult(const FString& Name, int64 Operations)
+{
+	FResult* Result = Results.FindByPredicate([&Name](const FResult& Other) { return Other.Name == Name; });
+	if (!Result)
+	{
+		Result = &Results.AddDefaulted_GetRef();
+		Result->Name = Name;
+		Result->Operations = Operations;
+	}
+	return *Result;
+}
+
+const QuestBenchmark::FResult* QuestBenchmark::FScenario::FindResult(const FString& Name) const
+{
+	return Results.FindByPredicate([&Name](const FResult& Other) { return Other.Name == Name; });
+}
+
+void QuestBenchmark::WriteResults(FAutomationTestBase& Test, const FScenario& Scenario)
+{
+	const FConfig& Config = GetConfig();
+	static const FString PluginVersion = GetPluginVersion();
+	
+	FString Csv;
+	if (!IFileManager::Get().FileExists(*Config.OutputPath))
+	{
+		Csv = TEXT("PluginVersion,Benchmark,Owners,QuestsPerOwner,ObjectivesPerQuest,Operations,MinNsPerOp,MedianNsPerOp,Bytes\n");
+	}
+	
+	for (const FResult& Result : Scenario.Results)
+	{
+		FString Min;
+		FString Median;
+		if (Result.NsPerOperation.Num() > 0)
+		{
+			Min = FString::SanitizeFloat(Result.GetMinNs());
+			Median = FString::SanitizeFloat(Result.GetMedianNs());
+		}
+		const FString Bytes = Result.Bytes >= 0 ? LexToString(Result.Bytes) : FString();
+		
+		Csv += FString::Printf(TEXT("%s,%s,%d,%d,%d,%lld,%s,%s,%s\n"), *PluginVersion, *Result.Name, Scenario.Owners, Scenario.Quests,
+			Scenario.Objectives, Result.Operations, *Min, *Median, *Bytes);
+		Test.AddInfo(FString::Printf(TEXT("%s: %s ns/op median, %s ns/op min, %lld operations%s"), *Result.Name, *Median, *Min,
+			Result.Operations, Bytes.IsEmpty() ? TEXT("") : *FString::Printf(TEXT(", %s bytes"), *Bytes)));
+	}
+
+	if (!FFileHelper::SaveStringToFile(Csv, *Config.OutputPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append))
+	{
+		Test.AddError(FString::Printf(TEXT("Could not write the benchmark results to %s"), *Config.OutputPath));
+	}
+}
@@ -0,0 +1,78 @@
+﻿// Protected under GPL-3.0 License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/SubclassOf.h"
+
+class FAutomationTestBase;
+class UQuestObject;
+
+/**
+ * Shared parts of the quest system benchmarks. Every benchmark appends its results to one CSV per session,
+ * so runs of different plugin versions can be compared.
+ *
+ * Options are passed on the command line, e.g. -QuestBenchmark="Owners=100,1000 Quests=10,100 Repeats=3":
+ *  - Owners=10,100,1000 : Owner counts of QuestSystem.Benchmark
+ *  - Quests=1,10,100 : Quests per owner of QuestSystem.Benchmark
+ *  - Objectives=1,4 : Objectives per quest of QuestSystem.Benchmark, only used for the generated quest classes
+ *  - QuestClasses=/Game/Quests/Q1.Q1_C,... : Quest classes of the game to run QuestSystem.Benchmark on, Quests is clamped to their number
+ *  - Repeats=5 : Runs per benchmark, the CSV holds the fastest and the median run
+ *  - Output=Path.csv : Defaults to Saved/QuestSystem/Benchmarks/QuestBenchmark_<time>.csv
+ *
+ * Run headless with "UnrealEditor-Cmd <Project> -ExecCmds="Automation RunTests QuestSystem.Benchmark;Quit" -NullRHI -unattended".
+ */
+namespace QuestBenchmark
+{
+	struct FConfig
+	{
+		TArray<int32> OwnerCounts = {10, 100, 1000};
+		TArray<int32> QuestsPerOwner = {1, 10, 100};
+		TArray<int32> ObjectivesPerQuest = {1, 4};
+		TArray<TSubclassOf<UQuestObject>> QuestClasses;
+		int32 Repeats = 5;
+		FString OutputPath;
+	};
+
+	// Parsed once from the command line
+	const FConfig& GetConfig();
+	
+	struct FResult
+	{
+		FString Name;
+		int64 Operations = 0;
+		
+		// Nanoseconds per operation of every run
+		TArray<double> NsPerOperation;
+
+		// Bytes for memory and serialization results
+		int64 Bytes = INDEX_NONE;
+
+		double GetMinNs() const;
+		double GetMedianNs() const;
+	};
+
+	struct FScenario
+	{
+		int32 Owners = 0;
+		int32 Quests = 0;
+		int32 Objectives = 0;
+		TArray<FResult> Results;
+
+		FResult& FindOrAddResult(const FString& Name, int64 Operations);
+		const FResult* FindResult(const FString& Name) const;
+	};
+
+	template <typename FunctionType>
+	void Measure(FScenario& Scenario, const FString& Name, int64 Operations, FunctionType&& Function)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		Function();
+		const double Seconds = FPlatformTime::Seconds() - StartTime;
+		
+		Scenario.FindOrAddResult(Name, Operations).NsPerOperation.Add(Seconds * 1e9 / FMath::Max<int64>(Operations, 1));
+	}
+
+	// Appends the results to the CSV of this session and reports them to the test
+	void WriteResults(FAutomationTestBase& Test, const FScenario& Scenario);
+}
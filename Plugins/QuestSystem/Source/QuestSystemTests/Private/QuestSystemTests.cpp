@@ -0,0 +1,6 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Modules/ModuleManager.h"
+
+// Automation tests and benchmarks of the quest system, editor only so they never end up in a game build
+IMPLEMENT_MODULE(FDefaultModuleImpl, QuestSystemTests)
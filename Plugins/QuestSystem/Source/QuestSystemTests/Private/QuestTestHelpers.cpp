@@ -0,0 +1,250 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestTestHelpers.h"
+#include "QuestSubsystem.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/MemoryBase.h"
+#include "UObject/Script.h"
+
+namespace QuestTest
+{
+	// Rooted so they survive garbage collection for the whole session, indexed by bQuestRecords
+	TArray<TSubclassOf<UQuestObject>> GeneratedClasses[2];
+
+	// Forwards everything to the allocator it was put in front of and counts the allocations of one thread
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		FMalloc* InnerMalloc = nullptr;
+		uint32 ThreadId = 0;
+		int64 Allocations = 0;
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return InnerMalloc->Malloc(Count, Alignment);
+		}
+
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return InnerMalloc->TryMalloc(Count, Alignment);
+		}
+		
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (Count > 0) CountAllocation();
+			return InnerMalloc->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (Count > 0) CountAllocation();
+			return InnerMalloc->TryRealloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override { InnerMalloc->Free(Original); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return InnerMalloc->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return InnerMalloc->GetAllocationSize(Original, SizeOut); }
+		virtual void Trim(bool bTrimThreadCaches) override { InnerMalloc->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { InnerMalloc->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual bool IsInternallyThreadSafe() const override { return InnerMalloc->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return InnerMalloc->ValidateHeap(); }
+		virtual void UpdateStats() override { InnerMalloc->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { InnerMalloc->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { InnerMalloc->DumpAllocatorStats(Ar); }
+		virtual const TCHAR* GetDescriptiveName() override { return TEXT("QuestTestCountingMalloc"); }
+
+	private:
+		void CountAllocation()
+		{
+			if (FPlatformTLS::GetCurrentThreadId() == ThreadId) Allocations++;
+		}
+	};
+
+	//Never deleted, other threads may still be inside of it right after it got taken out of GMalloc again
+	FCountingMalloc* CountingMalloc = nullptr;
+
+	UClass* GenerateQuestClass(const FString& Name, bool bQuestRecords)
+	{
+		UClass* SuperClass = UQuestTestQuest::StaticClass();
+		
+		//A class without properties or functions of its own, everything native comes from the super class
+		UClass* QuestClass = NewObject<UClass>(GetTransientPackage(), FName(Name), RF_Public | RF_Transient);
+		QuestClass->SetSuperStruct(SuperClass);
+		QuestClass->ClassFlags |= SuperClass->ClassFlags & CLASS_Inherit;
+		QuestClass->ClassCastFlags |= SuperClass->ClassCastFlags;
+		QuestClass->ClassWithin = SuperClass->ClassWithin;
+		QuestClass->ClassConfigName = SuperClass->ClassConfigName;
+		QuestClass->Bind();
+		QuestClass->StaticLink(true);
+		QuestClass->AssembleReferenceTokenStream(true);
+		QuestClass->AddToRoot();
+
+		QuestClass->GetDefaultObject<UQuestObject>()->bCreateObjectOnDemand = bQuestRecords;
+		return QuestClass;
+	}
+
+	// Overrides the BlueprintNativeEvent of the super class with a script function that returns right away
+	void AddScriptOverride(UClass* Class, FName FunctionName)
+	{
+		UFunction* SuperFunction = Class->GetSuperClass()->FindFunctionByName(FunctionName);
+		check(SuperFunction);
+
+		UFunction* Override = CastChecked<UFunction>(StaticDuplicateObject(SuperFunction, Class, FunctionName));
+		Override->FunctionFlags &= ~FUNC_Native;
+		Override->SetSuperStruct(SuperFunction);
+		Override->Script = {EX_Return, EX_Nothing};
+		Override->Bind();
+		Override->StaticLink(true);
+		Class->AddFunctionToFunctionMap(Override, FunctionName);
+	}
+}
+
+TSubclassOf<UQuestObject> QuestTest::GetScriptOverrideQuestClass()
+{
+	static UClass* OverrideClass = nullptr;
+	if (!OverrideClass)
+	{
+		OverrideClass = GenerateQuestClass(TEXT("QuestTestScriptOverrideQuest"), true);
+		AddScriptOverride(OverrideClass, GET_FUNCTION_NAME_CHECKED(UQuestObject, ProgressQuestEvent));
+	}
+	return OverrideClass;
+}
+
+TArray<TSubclassOf<UQuestObject>> QuestTest::GetQuestClasses(int32 Num, bool bQuestRecords)
+{
+	TArray<TSubclassOf<UQuestObject>>& Classes = GeneratedClasses[bQuestRecords ? 1 : 0];
+	Classes.Reserve(Num);
+	while (Classes.Num() < Num)
+	{
+		Classes.Add(GenerateQuestClass(FString::Printf(TEXT("%s_%d"), bQuestRecords ? TEXT("QuestTestQuest") : TEXT("QuestTestObjectQuest"), Classes.Num()), bQuestRecords));
+	}
+	
+	return TArray<TSubclassOf<UQuestObject>>(Classes.GetData(), FMath::Max(Num, 0));
+}
+
+void QuestTest::SetupQuestClasses(TConstArrayView<TSubclassOf<UQuestObject>> QuestClasses, const FClassSetup& Setup)
+{
+	for (const TSubclassOf<UQuestObject>& QuestClass : QuestClasses)
+	{
+		UQuestObject* QuestCDO = QuestClass->GetDefaultObject<UQuestObject>();
+		QuestCDO->bShareRewards = Setup.bShareRewards;
+
+		//New quest objects instance the objectives of the class default object
+		QuestCDO->QuestObjectives.Reset();
+		for (int32 i = 0; i < Setup.Objectives; i++)
+		{
+			UQuestTestObjective* Objective = NewObject<UQuestTestObjective>(QuestCDO, Setup.ObjectiveClass, NAME_None, RF_Public | RF_ArchetypeObject | RF_Transient);
+			Objective->RequiredProgress = Setup.RequiredProgress;
+			if (Setup.bObjectiveRewards)
+			{
+				Objective->ObjectiveRewards.Add(NewObject<UQuestTestReward>(Objective, NAME_None, RF_Public | RF_ArchetypeObject | RF_Transient));
+			}
+			QuestCDO->QuestObjectives.Add(Objective);
+		}
+
+		if (QuestCDO->QuestRewards.Num() == 0)
+		{
+			QuestCDO->QuestRewards.Add(NewObject<UQuestTestReward>(QuestCDO, NAME_None, RF_Public | RF_ArchetypeObject | RF_Transient));
+		}
+		GetQuestReward(QuestClass)->ClaimCount = 0;
+	}
+}
+
+UQuestTestReward* QuestTest::GetQuestReward(TSubclassOf<UQuestObject> QuestClass)
+{
+	const UQuestObject* QuestCDO = QuestClass->GetDefaultObject<UQuestObject>();
+	return QuestCDO->QuestRewards.Num() > 0 ? Cast<UQuestTestReward>(QuestCDO->QuestRewards[0]) : nullptr;
+}
+
+FString QuestTest::GetOwnerName(int32 Index)
+{
+	return FString::Printf(TEXT("QuestTestOwner%d"), Index);
+}
+
+void QuestTest::AddOwners(UQuestSubsystem* QuestSubsystem, int32 Num, TArray<FQuestOwnerHandle>& OutOwners)
+{
+	OutOwners.Reserve(OutOwners.Num() + Num);
+	for (int32 i = 0; i < Num; i++)
+	{
+		OutOwners.Add(QuestSubsystem->FindOrAddOwnerHandle(GetOwnerName(i)));
+	}
+}
+
+UQuestObject* QuestTest::AdvanceQuest(UQuestSubsystem* QuestSubsystem, TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner, EQuestStatus TargetStatus)
+{
+	return AdvanceQuest(QuestSubsystem, QuestClass, QuestSubsystem->FindOrAddOwnerHandle(QuestOwner), TargetStatus);
+}
+
+UQuestObject* QuestTest::AdvanceQuest(UQuestSubsystem* QuestSubsystem, TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner, EQuestStatus TargetStatus)
+{
+	//Every command leads to the status next to it
+	static const TPair<EQuestEnterCommand, EQuestStatus> Steps[] = {
+		{EQuestEnterCommand::UNLOCK, EQuestStatus::UNLOCKED},
+		{EQuestEnterCommand::ACCEPT, EQuestStatus::ACCEPTED},
+		{EQuestEnterCommand::INITIALIZE, EQuestStatus::STARTING},
+		{EQuestEnterCommand::START, EQuestStatus::IN_PROGRESS}
+	};
+	
+	for (const TPair<EQuestEnterCommand, EQuestStatus>& Step : Steps)
+	{
+		if (Step.Value > TargetStatus) break;
+		QuestSubsystem->ApplyCommand(QuestClass, QuestOwner, Step.Key);
+	}
+
+	//GetQuestObject would create the object of a quest record
+	if (QuestSubsystem->GetQuestStatus(QuestClass, QuestOwner) != TargetStatus || TargetStatus <= EQuestStatus::UNLOCKED) return nullptr;
+	return QuestSubsystem->GetQuestObject(QuestClass, QuestOwner);
+}
+
+QuestTest::FScopedAllocationCounter::FScopedAllocationCounter()
+{
+	check(IsInGameThread());
+	if (!CountingMalloc) CountingMalloc = new FCountingMalloc();
+	check(GMalloc != CountingMalloc);
+
+	CountingMalloc->InnerMalloc = GMalloc;
+	CountingMalloc->ThreadId = FPlatformTLS::GetCurrentThreadId();
+	CountingMalloc->Allocations = 0;
+	GMalloc = CountingMalloc;
+}
+
+QuestTest::FScopedAllocationCounter::~FScopedAllocationCounter()
+{
+	GMalloc = CountingMalloc->InnerMalloc;
+}
+
+int64 QuestTest::FScopedAllocationCounter::GetAllocations() const
+{
+	return CountingMalloc->Allocations;
+}
+
+QuestTest::FQuestTestInstance::FQuestTestInstance()
+{
+	//Creates a world context with a dummy world and initializes every game instance subsystem
+	GameInstance.Reset(NewObject<UGameInstance>(GEngine));
+	GameInstance->InitializeStandalone();
+	QuestSubsystem = GameInstance->GetSubsystem<UQuestSubsystem>();
+	check(QuestSubsystem);
+}
+
+QuestTest::FQuestTestInstance::~FQuestTestInstance()
+{
+	UWorld* World = GameInstance->GetWorld();
+	GameInstance->Shutdown();
+	if (World)
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+}
+
+void QuestTest::FQuestTestInstance::Tick(float DeltaTime) const
+{
+	QuestSubsystem->Tick(DeltaTime);
+}
@@ -0,0 +1,89 @@
+﻿// Protected under GPL-3.0 License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "QuestEnums.h"
+#include "QuestOwnerHandle.h"
+#include "QuestTestTypes.h"
+#include "UObject/StrongObjectPtr.h"
+
+class UGameInstance;
+class UQuestSubsystem;
+
+namespace QuestTest
+{
+	/**
+	 * Quest classes derived from UQuestTestQuest, generated at runtime on first use and kept for the whole session.
+	 * With bQuestRecords the quests stay records while locked or unlocked, otherwise they always get their object.
+	 */
+	TArray<TSubclassOf<UQuestObject>> GetQuestClasses(int32 Num, bool bQuestRecords = true);
+
+	struct FClassSetup
+	{
+		int32 Objectives = 1;
+		TSubclassOf<UQuestTestObjective> ObjectiveClass = UQuestTestObjective::StaticClass();
+		int32 RequiredProgress = MAX_int32;
+		bool bShareRewards = true;
+
+		// Gives every objective a reward of its own as well
+		bool bObjectiveRewards = false;
+	};
+
+	/**
+	 * Quest class whose ProgressQuestEvent is overridden by an empty script function, which is what the quest system
+	 * sees of a blueprint override. Generated on first use and kept for the whole session.
+	 */
+	TSubclassOf<UQuestObject> GetScriptOverrideQuestClass();
+
+	// Replaces the objectives of the class default objects and gives them a reward, like a designer editing the quests
+	void SetupQuestClasses(TConstArrayView<TSubclassOf<UQuestObject>> QuestClasses, const FClassSetup& Setup);
+
+	// Reward template of the class default object added by SetupQuestClasses
+	UQuestTestReward* GetQuestReward(TSubclassOf<UQuestObject> QuestClass);
+
+	FString GetOwnerName(int32 Index);
+	void AddOwners(UQuestSubsystem* QuestSubsystem, int32 Num, TArray<FQuestOwnerHandle>& OutOwners);
+
+	/**
+	 * Applies the commands from unlocking to starting in order until the quest reaches TargetStatus.
+	 * 
+	 * @return The quest object if it reached TargetStatus, a quest that stays a record returns nullptr
+	 */
+	UQuestObject* AdvanceQuest(UQuestSubsystem* QuestSubsystem, TSubclassOf<UQuestObject> QuestClass, const FString& QuestOwner, EQuestStatus TargetStatus);
+	UQuestObject* AdvanceQuest(UQuestSubsystem* QuestSubsystem, TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle QuestOwner, EQuestStatus TargetStatus);
+
+	/**
+	 * Counts the heap allocations of the game thread while in scope by putting a counting proxy in front of GMalloc.
+	 * Allocations of other threads are not counted, counters can't be nested.
+	 */
+	class FScopedAllocationCounter
+	{
+	public:
+		FScopedAllocationCounter();
+		~FScopedAllocationCounter();
+		UE_NONCOPYABLE(FScopedAllocationCounter);
+
+		int64 GetAllocations() const;
+	};
+
+	/**
+	 * Game instance with an initialized quest subsystem of its own, the quests of the game stay untouched.
+	 * Nothing ticks on its own, the game instance gets shut down at the end of the scope.
+	 */
+	class FQuestTestInstance
+	{
+	public:
+		FQuestTestInstance();
+		~FQuestTestInstance();
+		UE_NONCOPYABLE(FQuestTestInstance);
+
+		UQuestSubsystem* GetSubsystem() const { return QuestSubsystem; }
+
+		void Tick(float DeltaTime = 1.f / 60.f) const;
+
+	private:
+		TStrongObjectPtr<UGameInstance> GameInstance;
+		UQuestSubsystem* QuestSubsystem = nullptr;
+	};
+}
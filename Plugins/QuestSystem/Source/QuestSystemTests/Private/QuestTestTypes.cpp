@@ -0,0 +1,42 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestTestTypes.h"
+
+void UQuestTestObjective::AddProgress_Implementation(UQuestProgressionObject* InProgress, bool& Consume)
+{
+	Consume = true;
+	if (++Progress >= RequiredProgress) UpdateStatus(EQuestStatus::COMPLETED);
+}
+
+void UQuestTestObjective::AddProgressEvent_Implementation(const FQuestProgressEvent& Event, bool& Consume)
+{
+	Consume = true;
+	if (bRecordAmounts) (RecordAmountsTo ? *RecordAmountsTo : ReceivedAmounts).Add(Event.Amount);
+	
+	Progress += Event.Amount;
+	if (Progress >= RequiredProgress) UpdateStatus(EQuestStatus::COMPLETED);
+}
+
+void UQuestTestObjective::TickObjective_Implementation(UQuestObject* Quest, float DeltaTime)
+{
+	NumTicks++;
+}
+
+void UQuestTestObjective::ResetForRepeat_Implementation()
+{
+	Progress = 0;
+	NumTicks = 0;
+	ReceivedAmounts.Reset();
+	Super::ResetForRepeat_Implementation();
+}
+
+UQuestTestTickingObjective::UQuestTestTickingObjective()
+{
+	ShouldTick = true;
+}
+
+void UQuestTestReward::ClaimReward_Implementation()
+{
+	ClaimCount++;
+}
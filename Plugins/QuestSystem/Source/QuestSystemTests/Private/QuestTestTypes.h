@@ -0,0 +1,95 @@
+﻿// Protected under GPL-3.0 License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "QuestObject.h"
+#include "QuestObjective.h"
+#include "QuestProgressionObject.h"
+#include "QuestReward.h"
+#include "QuestTestTypes.generated.h"
+
+/**
+ * Counts the progress it receives. Completes once RequiredProgress is reached, which by default never happens.
+ */
+UCLASS(NotBlueprintable, HideDropdown, Transient)
+class UQuestTestObjective : public UQuestObjective
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(SaveGame)
+	int32 Progress = 0;
+	
+	UPROPERTY()
+	int32 RequiredProgress = MAX_int32;
+
+	// Amounts of the received events in the order they arrived, only recorded with bRecordAmounts
+	TArray<int32> ReceivedAmounts;
+	bool bRecordAmounts = false;
+
+	// Records into the list of another objective instead, e.g. to see the order across the objectives of a quest
+	TArray<int32>* RecordAmountsTo = nullptr;
+
+	int32 NumTicks = 0;
+
+	virtual void AddProgress_Implementation(UQuestProgressionObject* InProgress, bool& Consume) override;
+	virtual void AddProgressEvent_Implementation(const FQuestProgressEvent& Event, bool& Consume) override;
+	virtual void TickObjective_Implementation(UQuestObject* Quest, float DeltaTime) override;
+	virtual void ResetForRepeat_Implementation() override;
+};
+
+UCLASS(NotBlueprintable, HideDropdown, Transient)
+class UQuestTestTickingObjective : public UQuestTestObjective
+{
+	GENERATED_BODY()
+
+public:
+	UQuestTestTickingObjective();
+};
+
+UCLASS(NotBlueprintable, HideDropdown, Transient)
+class UQuestTestProgress : public UQuestProgressionObject
+{
+	GENERATED_BODY()
+};
+
+UCLASS(NotBlueprintable, HideDropdown, Transient)
+class UQuestTestReward : public UQuestReward
+{
+	GENERATED_BODY()
+
+public:
+	int32 ClaimCount = 0;
+
+	virtual void ClaimReward_Implementation() override;
+};
+
+// Counts the calls it receives through dynamic delegates
+UCLASS(NotBlueprintable, HideDropdown, Transient)
+class UQuestTestListener : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	int32 Calls = 0;
+
+	UFUNCTION()
+	void OnQuestTick(UQuestObject* Quest, float DeltaTime) { Calls++; }
+
+	UFUNCTION()
+	void OnQuestProgressUpdated(UQuestObject* Quest, TArray<UQuestObjective*>& QuestObjectives, UQuestProgressionObject* Progress) { Calls++; }
+};
+
+/**
+ * Base of the quest classes generated by QuestTest::GetQuestClasses. Quests are stored per class,
+ * so every quest an owner holds needs a class of its own.
+ */
+UCLASS(NotBlueprintable, HideDropdown, Transient)
+class UQuestTestQuest : public UQuestObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual const UClass* GetDefaultUnlockClass() const override { return UQuestTestQuest::StaticClass(); }
+};
@@ -0,0 +1,85 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestBenchmark.h"
+#include "QuestSubsystem.h"
+#include "QuestTestHelpers.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Cost of the quest tick broadcast per listener, with only native listeners against only dynamic listeners.
+ * Without listeners this is the cost of a broadcast nobody listens to.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQuestBroadcastBenchmark, "QuestSystem.Benchmark.Broadcast",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FQuestBroadcastBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace QuestBenchmark;
+	constexpr int32 Broadcasts = 100000;
+	constexpr float DeltaTime = 1.f / 60.f;
+	
+	const TArray<TSubclassOf<UQuestObject>> QuestClasses = QuestTest::GetQuestClasses(1);
+	QuestTest::SetupQuestClasses(QuestClasses, QuestTest::FClassSetup());
+
+	QuestTest::FQuestTestInstance Instance;
+	UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+	UQuestObject* Quest = QuestTest::AdvanceQuest(QuestSubsystem, QuestClasses[0], QuestTest::GetOwnerName(0), EQuestStatus::IN_PROGRESS);
+	if (!TestNotNull(TEXT("Quest in progress"), Quest)) return false;
+
+	FScenario Scenario;
+	Scenario.Owners = 1;
+	Scenario.Quests = 1;
+	Scenario.Objectives = 1;
+
+	for (const int32 NumListeners : {0, 1, 4, 16})
+	{
+		const int64 Operations = int64(Broadcasts) * FMath::Max(NumListeners, 1);
+		for (int32 Repeat = 0; Repeat < GetConfig().Repeats; Repeat++)
+		{
+			int64 NativeCalls = 0;
+			for (int32 i = 0; i < NumListeners; i++)
+			{
+				Quest->OnQuestTickNative.AddLambda([&NativeCalls](UQuestObject*, float) { NativeCalls++; });
+			}
+			
+			Measure(Scenario, FString::Printf(TEXT("Broadcast.Native.%dListeners"), NumListeners), Operations, [&]()
+			{
+				for (int32 i = 0; i < Broadcasts; i++)
+				{
+					Quest->QuestTick_Implementation(DeltaTime);
+				}
+			});
+			TestEqual(TEXT("Calls of the native listeners"), NativeCalls, int64(Broadcasts) * NumListeners);
+			Quest->OnQuestTickNative.Clear();
+
+			TArray<UQuestTestListener*> Listeners;
+			for (int32 i = 0; i < NumListeners; i++)
+			{
+				UQuestTestListener* Listener = NewObject<UQuestTestListener>(QuestSubsystem);
+				Quest->OnQuestTickDelegate.AddDynamic(Listener, &UQuestTestListener::OnQuestTick);
+				Listeners.Add(Listener);
+			}
+
+			Measure(Scenario, FString::Printf(TEXT("Broadcast.Dynamic.%dListeners"), NumListeners), Operations, [&]()
+			{
+				for (int32 i = 0; i < Broadcasts; i++)
+				{
+					Quest->QuestTick_Implementation(DeltaTime);
+				}
+			});
+			for (const UQuestTestListener* Listener : Listeners)
+			{
+				TestEqual(TEXT("Calls of the dynamic listener"), Listener->Calls, Broadcasts);
+			}
+			Quest->OnQuestTickDelegate.Clear();
+		}
+	}
+
+	WriteResults(*this, Scenario);
+	return true;
+}
+
+#endif
@@ -0,0 +1,101 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestBenchmark.h"
+#include "QuestSubsystem.h"
+#include "QuestTestHelpers.h"
+#include "Algo/Count.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Unlocking 200 quests for 2,000 owners, one ApplyCommand per quest against one ApplyCommandToQuests for all of them.
+ * Runs once with quests kept as records and once with quests that get their object right away.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQuestBulkCommandBenchmark, "QuestSystem.Benchmark.BulkCommand",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FQuestBulkCommandBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace QuestBenchmark;
+	constexpr int32 NumOwners = 2000;
+	constexpr int32 NumQuests = 200;
+	constexpr int64 Operations = int64(NumOwners) * NumQuests;
+
+	FScenario Scenario;
+	Scenario.Owners = NumOwners;
+	Scenario.Quests = NumQuests;
+	Scenario.Objectives = 0;
+
+	for (const bool bQuestRecords : {true, false})
+	{
+		//Unlocking does not need objectives, they would only add to the objects created
+		const TArray<TSubclassOf<UQuestObject>> QuestClasses = QuestTest::GetQuestClasses(NumQuests, bQuestRecords);
+		QuestTest::FClassSetup Setup;
+		Setup.Objectives = 0;
+		QuestTest::SetupQuestClasses(QuestClasses, Setup);
+		const TCHAR* Kind = bQuestRecords ? TEXT("Records") : TEXT("Objects");
+
+		auto ExpectUnlocked = [&](const TCHAR* What, const UQuestSubsystem* QuestSubsystem, TConstArrayView<FQuestOwnerHandle> Owners)
+		{
+			int64 Unlocked = 0;
+			for (const FQuestOwnerHandle& Owner : Owners)
+			{
+				for (const TSubclassOf<UQuestObject>& QuestClass : QuestClasses)
+				{
+					Unlocked += QuestSubsystem->GetQuestStatus(QuestClass, Owner) == EQuestStatus::UNLOCKED;
+				}
+			}
+			TestEqual(*FString::Printf(TEXT("Quests unlocked by %s with %s"), What, Kind), Unlocked, Operations);
+		};
+
+		for (int32 Repeat = 0; Repeat < GetConfig().Repeats; Repeat++)
+		{
+			{
+				QuestTest::FQuestTestInstance Instance;
+				UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+				TArray<FQuestOwnerHandle> Owners;
+				QuestTest::AddOwners(QuestSubsystem, NumOwners, Owners);
+
+				int64 Succeeded = 0;
+				Measure(Scenario, FString::Printf(TEXT("BulkCommand.%s.ApplyCommand"), Kind), Operations, [&]()
+				{
+					for (const FQuestOwnerHandle& Owner : Owners)
+					{
+						for (const TSubclassOf<UQuestObject>& QuestClass : QuestClasses)
+						{
+							Succeeded += QuestSubsystem->ApplyCommand(QuestClass, Owner, EQuestEnterCommand::UNLOCK);
+						}
+					}
+				});
+				TestEqual(*FString::Printf(TEXT("Succeeded ApplyCommand with %s"), Kind), Succeeded, Operations);
+				ExpectUnlocked(TEXT("ApplyCommand"), QuestSubsystem, Owners);
+			}
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+			{
+				QuestTest::FQuestTestInstance Instance;
+				UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+				TArray<FQuestOwnerHandle> Owners;
+				QuestTest::AddOwners(QuestSubsystem, NumOwners, Owners);
+
+				TArray<FQuestCommandResult> Results;
+				Measure(Scenario, FString::Printf(TEXT("BulkCommand.%s.ApplyCommandToQuests"), Kind), Operations, [&]()
+				{
+					QuestSubsystem->ApplyCommandToQuests(QuestClasses, Owners, EQuestEnterCommand::UNLOCK, Results);
+				});
+				
+				const int64 Succeeded = Algo::CountIf(Results, [](const FQuestCommandResult& Result) { return Result.bSuccess && Result.Status == EQuestStatus::UNLOCKED; });
+				TestEqual(*FString::Printf(TEXT("Succeeded results of ApplyCommandToQuests with %s"), Kind), Succeeded, Operations);
+				ExpectUnlocked(TEXT("ApplyCommandToQuests"), QuestSubsystem, Owners);
+			}
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		}
+	}
+
+	WriteResults(*this, Scenario);
+	return true;
+}
+
+#endif
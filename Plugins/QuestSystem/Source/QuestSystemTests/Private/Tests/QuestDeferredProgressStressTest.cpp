@@ -0,0 +1,127 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestSubsystem.h"
+#include "QuestTestHelpers.h"
+#include "Algo/AllOf.h"
+#include "Async/Async.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Many producer threads queue progress while the game thread drains it. Every producer has an owner of its own
+ * and numbers its events, which alternate between two objective classes. The quest of that owner has to receive
+ * all of them in the order they were queued. Producers retry what the full queue rejected, like a producer
+ * honoring back-pressure would.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQuestDeferredProgressStressTest, "QuestSystem.Progress.DeferredStress",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FQuestDeferredProgressStressTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumProducers = 8;
+	constexpr int32 EventsPerProducer = 20000;
+	constexpr double TimeoutSeconds = 60.0;
+
+	const TArray<TSubclassOf<UQuestObject>> QuestClasses = QuestTest::GetQuestClasses(1);
+	QuestTest::SetupQuestClasses(QuestClasses, QuestTest::FClassSetup());
+	const TSubclassOf<UQuestTestObjective> ObjectiveClasses[] = {UQuestTestObjective::StaticClass(), UQuestTestTickingObjective::StaticClass()};
+
+	//A second objective of another class, the draining must not regroup the events by class
+	UQuestObject* QuestCDO = QuestClasses[0]->GetDefaultObject<UQuestObject>();
+	QuestCDO->QuestObjectives.Add(NewObject<UQuestTestObjective>(QuestCDO, ObjectiveClasses[1], NAME_None, RF_Public | RF_ArchetypeObject | RF_Transient));
+
+	QuestTest::FQuestTestInstance Instance;
+	UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+	
+	TArray<FQuestOwnerHandle> Owners;
+	QuestTest::AddOwners(QuestSubsystem, NumProducers, Owners);
+	TArray<UQuestTestObjective*> Objectives;
+	for (const FQuestOwnerHandle& Owner : Owners)
+	{
+		UQuestObject* Quest = QuestTest::AdvanceQuest(QuestSubsystem, QuestClasses[0], Owner, EQuestStatus::IN_PROGRESS);
+		if (!TestNotNull(TEXT("Quest in progress"), Quest)) return false;
+
+		UQuestTestObjective* Objective = CastChecked<UQuestTestObjective>(Quest->QuestObjectives[0]);
+		Objective->bRecordAmounts = true;
+		Objective->ReceivedAmounts.Reserve(EventsPerProducer);
+		Objectives.Add(Objective);
+
+		UQuestTestObjective* SecondObjective = CastChecked<UQuestTestObjective>(Quest->QuestObjectives[1]);
+		SecondObjective->bRecordAmounts = true;
+		SecondObjective->RecordAmountsTo = &Objective->ReceivedAmounts;
+	}
+
+	//Half of the producers queue by owner name, the owner gets resolved on the game thread then
+	std::atomic<int64> Retries{0};
+	TArray<TFuture<void>> Producers;
+	for (int32 ProducerIndex = 0; ProducerIndex < NumProducers; ProducerIndex++)
+	{
+		const FQuestOwnerHandle Owner = Owners[ProducerIndex];
+		const FString OwnerName = ProducerIndex % 2 ? QuestTest::GetOwnerName(ProducerIndex) : FString();
+		Producers.Add(Async(EAsyncExecution::Thread, [QuestSubsystem, Owner, OwnerName, &ObjectiveClasses, &Retries]()
+		{
+			FQuestProgressEvent Event;
+			for (int32 Sequence = 1; Sequence <= EventsPerProducer; Sequence++)
+			{
+				Event.ObjectiveToProgress = ObjectiveClasses[Sequence % 2];
+				Event.Amount = Sequence;
+				while (!(OwnerName.IsEmpty() ? QuestSubsystem->EnqueueProgress(Owner, Event) : QuestSubsystem->EnqueueProgress(OwnerName, Event)))
+				{
+					Retries.fetch_add(1, std::memory_order_relaxed);
+					FPlatformProcess::Yield();
+				}
+			}
+		}));
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	auto ProducersDone = [&Producers]()
+	{
+		return Algo::AllOf(Producers, [](const TFuture<void>& Producer) { return Producer.IsReady(); });
+	};
+	while (!ProducersDone() || QuestSubsystem->GetDeferredProgressStats().Pending > 0)
+	{
+		if (FPlatformTime::Seconds() - StartTime > TimeoutSeconds)
+		{
+			AddError(TEXT("Deferred progress was not drained in time"));
+			break;
+		}
+		
+		Instance.Tick();
+		FPlatformProcess::Yield();
+	}
+
+	for (TFuture<void>& Producer : Producers)
+	{
+		Producer.Wait();
+	}
+
+	const FQuestDeferredProgressStats Stats = QuestSubsystem->GetDeferredProgressStats();
+	AddInfo(FString::Printf(TEXT("%lld events, %lld rejected and retried, %lld peak pending, %lld saturated frames"),
+		Stats.Enqueued, Stats.Rejected, Stats.PeakPending, Stats.SaturatedFrames));
+	TestEqual(TEXT("Enqueued events"), Stats.Enqueued, int64(NumProducers) * EventsPerProducer);
+	TestEqual(TEXT("Processed events"), Stats.Processed, int64(NumProducers) * EventsPerProducer);
+	TestEqual(TEXT("Rejected events"), Stats.Rejected, Retries.load());
+	TestEqual(TEXT("Pending events"), Stats.Pending, int64(0));
+
+	for (int32 ProducerIndex = 0; ProducerIndex < NumProducers; ProducerIndex++)
+	{
+		const TArray<int32>& Received = Objectives[ProducerIndex]->ReceivedAmounts;
+		if (!TestEqual(*FString::Printf(TEXT("Events received from producer %d"), ProducerIndex), Received.Num(), EventsPerProducer)) continue;
+
+		for (int32 i = 0; i < Received.Num(); i++)
+		{
+			if (Received[i] != i + 1)
+			{
+				AddError(FString::Printf(TEXT("Producer %d: event %d arrived at position %d"), ProducerIndex, Received[i], i + 1));
+				break;
+			}
+		}
+	}
+	
+	return true;
+}
+
+#endif
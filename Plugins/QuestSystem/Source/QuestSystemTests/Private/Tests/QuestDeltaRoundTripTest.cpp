@@ -0,0 +1,146 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestDelta.h"
+#include "QuestSubsystem.h"
+#include "QuestTestHelpers.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Round trips quest deltas of one owner through bytes into a mirror, the way a client would receive them:
+ * the full state, incremental deltas after acknowledging, duplicates, gaps, removed quests and a new epoch.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQuestDeltaRoundTripTest, "QuestSystem.Replication.DeltaRoundTrip",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FQuestDeltaRoundTripTest::RunTest(const FString& Parameters)
+{
+	//Quests that keep their object while unlocked, so unlocked quests can be released
+	const TArray<TSubclassOf<UQuestObject>> QuestClasses = QuestTest::GetQuestClasses(5, false);
+	QuestTest::SetupQuestClasses(QuestClasses, QuestTest::FClassSetup());
+
+	QuestTest::FQuestTestInstance Instance;
+	UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+	const FString OwnerName = QuestTest::GetOwnerName(0);
+	const FQuestOwnerHandle Owner = QuestSubsystem->FindOrAddOwnerHandle(OwnerName);
+	QuestSubsystem->EnableQuestDeltaTracking();
+
+	for (const TSubclassOf<UQuestObject>& QuestClass : QuestClasses)
+	{
+		QuestSubsystem->ApplyCommand(QuestClass, Owner, EQuestEnterCommand::UNLOCK);
+	}
+	QuestTest::AdvanceQuest(QuestSubsystem, QuestClasses[0], Owner, EQuestStatus::IN_PROGRESS);
+
+	FQuestProgressEvent Event;
+	Event.ObjectiveToProgress = UQuestTestObjective::StaticClass();
+	Event.Amount = 5;
+	QuestSubsystem->AddProgressEvent(Owner, Event, QuestClasses[0]);
+
+	FQuestDeltaMirror Mirror;
+	
+	//Serializes the next delta for the version the mirror has and reads it back
+	auto CreateDelta = [&](const FQuestDeltaVersion& Acknowledged, FQuestDelta& OutDelta)
+	{
+		FQuestDelta Delta;
+		if (!QuestSubsystem->CreateQuestDelta(Owner, Acknowledged, Delta)) return false;
+
+		TArray<uint8> Data;
+		return TestTrue(TEXT("Delta written"), Delta.ToBytes(Data)) && TestTrue(TEXT("Delta read"), OutDelta.FromBytes(Data));
+	};
+
+	//The mirror has to hold what a full state of the owner holds right now
+	auto ExpectMirrored = [&](const TCHAR* What)
+	{
+		FQuestDelta FullState;
+		QuestSubsystem->CreateQuestDelta(Owner, FQuestDeltaVersion(), FullState);
+		
+		const FQuestDeltaMirror::FOwner* MirroredOwner = Mirror.FindOwner(OwnerName);
+		if (!TestNotNull(*FString::Printf(TEXT("Mirrored owner %s"), What), MirroredOwner)) return;
+		TestTrue(*FString::Printf(TEXT("Mirror version %s"), What), MirroredOwner->Version == QuestSubsystem->GetQuestDeltaVersion(Owner));
+
+		int32 NumQuests = 0;
+		for (const FQuestSaveRecord& Record : FullState.Changes.Quests)
+		{
+			if (Record.Status == EQuestStatus::INVALID) continue;
+			NumQuests++;
+			
+			const FString& QuestClass = FullState.QuestClasses[Record.ClassIndex];
+			const FQuestSaveRecord* MirroredRecord = Mirror.FindQuest(OwnerName, QuestClass);
+			if (!TestNotNull(*FString::Printf(TEXT("Mirrored %s %s"), *QuestClass, What), MirroredRecord)) continue;
+
+			bool bSame = MirroredRecord->Status == Record.Status && MirroredRecord->SaveGameData == Record.SaveGameData
+				&& MirroredRecord->Objectives.Num() == Record.Objectives.Num();
+			for (int32 i = 0; bSame && i < Record.Objectives.Num(); i++)
+			{
+				bSame = MirroredRecord->Objectives[i].Status == Record.Objectives[i].Status
+					&& MirroredRecord->Objectives[i].SaveGameData == Record.Objectives[i].SaveGameData;
+			}
+			TestTrue(*FString::Printf(TEXT("Mirrored state of %s %s"), *QuestClass, What), bSame);
+		}
+		TestEqual(*FString::Printf(TEXT("Mirrored quests %s"), What), MirroredOwner->Quests.Num(), NumQuests);
+	};
+
+	//Full state for a mirror that has nothing yet
+	FQuestDelta Delta;
+	if (!TestTrue(TEXT("Full state created"), CreateDelta(Mirror.GetVersion(OwnerName), Delta))) return false;
+	TestTrue(TEXT("Full state"), Delta.bFullState);
+	TestEqual(TEXT("Quests in the full state"), Delta.Changes.Quests.Num(), QuestClasses.Num());
+	TestTrue(TEXT("Full state applied"), Mirror.Apply(Delta) == EQuestDeltaResult::Applied);
+	ExpectMirrored(TEXT("after the full state"));
+	
+	FQuestDelta UpToDate;
+	TestFalse(TEXT("Delta for an up to date mirror"), CreateDelta(Mirror.GetVersion(OwnerName), UpToDate));
+
+	//Only what changed after acknowledging
+	QuestSubsystem->AcknowledgeQuestDelta(Owner, Mirror.GetVersion(OwnerName));
+	QuestSubsystem->AddProgressEvent(Owner, Event, QuestClasses[0]);
+	QuestSubsystem->ApplyCommand(QuestClasses[1], Owner, EQuestEnterCommand::ACCEPT);
+	if (!TestTrue(TEXT("Incremental delta created"), CreateDelta(Mirror.GetVersion(OwnerName), Delta))) return false;
+	TestFalse(TEXT("Incremental delta is a full state"), Delta.bFullState);
+	TestEqual(TEXT("Quests in the incremental delta"), Delta.Changes.Quests.Num(), 2);
+	TestTrue(TEXT("Incremental delta applied"), Mirror.Apply(Delta) == EQuestDeltaResult::Applied);
+	ExpectMirrored(TEXT("after the incremental delta"));
+
+	TestTrue(TEXT("Duplicate delta"), Mirror.Apply(Delta) == EQuestDeltaResult::AlreadyApplied);
+	ExpectMirrored(TEXT("after the duplicate delta"));
+
+	//The delta in between gets lost on the way
+	QuestSubsystem->AcknowledgeQuestDelta(Owner, Mirror.GetVersion(OwnerName));
+	QuestSubsystem->ApplyCommand(QuestClasses[2], Owner, EQuestEnterCommand::ACCEPT);
+	FQuestDelta LostDelta;
+	if (!TestTrue(TEXT("Lost delta created"), CreateDelta(Mirror.GetVersion(OwnerName), LostDelta))) return false;
+	QuestSubsystem->ApplyCommand(QuestClasses[3], Owner, EQuestEnterCommand::ACCEPT);
+	if (!TestTrue(TEXT("Delta after the gap created"), CreateDelta(LostDelta.Version, Delta))) return false;
+	TestTrue(TEXT("Delta after a gap"), Mirror.Apply(Delta) == EQuestDeltaResult::MissingBase);
+
+	//Acknowledging the version the mirror really has brings it back
+	if (!TestTrue(TEXT("Delta over the gap created"), CreateDelta(Mirror.GetVersion(OwnerName), Delta))) return false;
+	TestEqual(TEXT("Quests in the delta over the gap"), Delta.Changes.Quests.Num(), 2);
+	TestTrue(TEXT("Delta over the gap applied"), Mirror.Apply(Delta) == EQuestDeltaResult::Applied);
+	ExpectMirrored(TEXT("after the gap"));
+
+	//Removed quests are sent as INVALID
+	QuestSubsystem->AcknowledgeQuestDelta(Owner, Mirror.GetVersion(OwnerName));
+	TestTrue(TEXT("Quest released"), QuestSubsystem->ReleaseQuest(QuestClasses[4], Owner));
+	if (!TestTrue(TEXT("Removal delta created"), CreateDelta(Mirror.GetVersion(OwnerName), Delta))) return false;
+	TestTrue(TEXT("Removal sent as INVALID"), Delta.Changes.Quests.Num() == 1 && Delta.Changes.Quests[0].Status == EQuestStatus::INVALID);
+	TestTrue(TEXT("Removal applied"), Mirror.Apply(Delta) == EQuestDeltaResult::Applied);
+	TestTrue(TEXT("Removed quest left the mirror"), Mirror.GetQuestStatus(OwnerName, QuestClasses[4]) == EQuestStatus::INVALID);
+	ExpectMirrored(TEXT("after the removal"));
+
+	//A new epoch sends the full state again, even to an up to date mirror
+	const FQuestDeltaVersion OldVersion = Mirror.GetVersion(OwnerName);
+	QuestSubsystem->EnableQuestDeltaTracking();
+	if (!TestTrue(TEXT("Delta of the new epoch created"), CreateDelta(OldVersion, Delta))) return false;
+	TestTrue(TEXT("New epoch sends the full state"), Delta.bFullState);
+	TestNotEqual(TEXT("Epoch"), Delta.Version.Epoch, OldVersion.Epoch);
+	TestTrue(TEXT("Full state of the new epoch applied"), Mirror.Apply(Delta) == EQuestDeltaResult::Applied);
+	ExpectMirrored(TEXT("after the new epoch"));
+
+	QuestSubsystem->DisableQuestDeltaTracking();
+	return true;
+}
+
+#endif
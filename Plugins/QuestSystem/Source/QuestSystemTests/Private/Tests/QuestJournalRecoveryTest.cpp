@@ -0,0 +1,179 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestSaveData.h"
+#include "QuestSubsystem.h"
+#include "QuestTestHelpers.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Writes journal batches of a few owners and brings them back with Replay and RecoverQuests, compared against the
+ * live quests: removed quests, ids declared again after a failed compaction and a journal with a torn tail.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQuestJournalRecoveryTest, "QuestSystem.Storage.JournalRecovery",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FQuestJournalRecoveryTest::RunTest(const FString& Parameters)
+{
+	//Quests that keep their object while unlocked, so unlocked quests can be released
+	const TArray<TSubclassOf<UQuestObject>> QuestClasses = QuestTest::GetQuestClasses(4, false);
+	QuestTest::SetupQuestClasses(QuestClasses, QuestTest::FClassSetup());
+
+	QuestTest::FQuestTestInstance Instance;
+	UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+	TArray<FQuestOwnerHandle> Owners;
+	QuestTest::AddOwners(QuestSubsystem, 3, Owners);
+
+	const FString SlotName = TEXT("QuestJournalRecoveryTest");
+	const FString SnapshotPath = UQuestSubsystem::GetQuestSaveFilePath(SlotName);
+	const FString JournalPath = UQuestSubsystem::GetQuestJournalFilePath(SlotName);
+	const FString SnapshotTempPath = SnapshotPath + TEXT(".tmp");
+	IFileManager::Get().Delete(*SnapshotPath);
+	IFileManager::Get().Delete(*JournalPath);
+
+	//Owner and class path -> record, removed quests are left out like restoring drops them
+	auto GetQuests = [](const FQuestSaveSnapshot& Snapshot)
+	{
+		TMap<FString, const FQuestSaveRecord*> SnapshotQuests;
+		for (const FQuestOwnerSaveRecord& OwnerRecord : Snapshot.Owners)
+		{
+			for (const FQuestSaveRecord& Record : OwnerRecord.Quests)
+			{
+				if (Record.Status == EQuestStatus::INVALID) continue;
+				SnapshotQuests.Add(OwnerRecord.Owner / Snapshot.QuestClasses[Record.ClassIndex], &Record);
+			}
+		}
+		return SnapshotQuests;
+	};
+
+	auto ExpectSameQuests = [&](const TCHAR* What, const FQuestSaveSnapshot& Actual, const FQuestSaveSnapshot& Expected)
+	{
+		const TMap<FString, const FQuestSaveRecord*> ActualQuests = GetQuests(Actual);
+		const TMap<FString, const FQuestSaveRecord*> ExpectedQuests = GetQuests(Expected);
+		TestEqual(*FString::Printf(TEXT("Quests %s"), What), ActualQuests.Num(), ExpectedQuests.Num());
+
+		int32 Mismatches = 0;
+		for (const TPair<FString, const FQuestSaveRecord*>& ExpectedQuest : ExpectedQuests)
+		{
+			const FQuestSaveRecord* const* Record = ActualQuests.Find(ExpectedQuest.Key);
+			bool bSame = Record && (*Record)->Status == ExpectedQuest.Value->Status && (*Record)->SaveGameData == ExpectedQuest.Value->SaveGameData
+				&& (*Record)->Objectives.Num() == ExpectedQuest.Value->Objectives.Num();
+			for (int32 i = 0; bSame && i < ExpectedQuest.Value->Objectives.Num(); i++)
+			{
+				bSame = (*Record)->Objectives[i].Status == ExpectedQuest.Value->Objectives[i].Status
+					&& (*Record)->Objectives[i].SaveGameData == ExpectedQuest.Value->Objectives[i].SaveGameData;
+			}
+			if (!bSame) Mismatches++;
+		}
+		TestEqual(*FString::Printf(TEXT("Quests with a different state %s"), What), Mismatches, 0);
+	};
+
+	//What RecoverQuests would apply right now
+	auto ReplaySlot = [&](const TCHAR* What, FQuestSaveSnapshot& OutSnapshot)
+	{
+		UQuestSubsystem::WaitForQuestWrites();
+		
+		TArray<uint8> Data;
+		if (!TestTrue(*FString::Printf(TEXT("Snapshot read %s"), What), FFileHelper::LoadFileToArray(Data, *SnapshotPath))) return false;
+		FMemoryReader Reader(Data, true);
+		Reader << OutSnapshot;
+		if (!TestFalse(*FString::Printf(TEXT("Snapshot corrupt %s"), What), Reader.IsError())) return false;
+
+		Data.Reset();
+		return TestTrue(*FString::Printf(TEXT("Journal read %s"), What), FFileHelper::LoadFileToArray(Data, *JournalPath))
+			&& TestTrue(*FString::Printf(TEXT("Journal replayed %s"), What), FQuestJournal::Replay(Data, OutSnapshot));
+	};
+
+	auto ExpectReplayed = [&](const TCHAR* What, FQuestSaveSnapshot& OutLive)
+	{
+		QuestSubsystem->FlushQuestJournal();
+		QuestSubsystem->CreateSaveSnapshot(OutLive);
+		
+		FQuestSaveSnapshot Replayed;
+		if (ReplaySlot(What, Replayed)) ExpectSameQuests(What, Replayed, OutLive);
+	};
+
+	//Unlocked before journaling, so the quests are part of the snapshot of the slot
+	for (const FQuestOwnerHandle& Owner : Owners)
+	{
+		for (const TSubclassOf<UQuestObject>& QuestClass : QuestClasses)
+		{
+			QuestSubsystem->ApplyCommand(QuestClass, Owner, EQuestEnterCommand::UNLOCK);
+		}
+	}
+	QuestSubsystem->EnableQuestJournal(SlotName);
+	UQuestSubsystem::WaitForQuestWrites();
+	TestTrue(TEXT("Snapshot written on enabling"), IFileManager::Get().FileExists(*SnapshotPath));
+	TestFalse(TEXT("Journal of an earlier run left"), IFileManager::Get().FileExists(*JournalPath));
+
+	FQuestProgressEvent Event;
+	Event.ObjectiveToProgress = UQuestTestObjective::StaticClass();
+	for (int32 OwnerIndex = 0; OwnerIndex < Owners.Num(); OwnerIndex++)
+	{
+		QuestTest::AdvanceQuest(QuestSubsystem, QuestClasses[0], Owners[OwnerIndex], EQuestStatus::IN_PROGRESS);
+		Event.Amount = OwnerIndex + 1;
+		QuestSubsystem->AddProgressEvent(Owners[OwnerIndex], Event, QuestClasses[0]);
+	}
+	FQuestSaveSnapshot FirstBatch;
+	ExpectReplayed(TEXT("after the first batch"), FirstBatch);
+
+	//Quests change again in later batches, the last entry of a quest wins
+	for (int32 OwnerIndex = 0; OwnerIndex < Owners.Num(); OwnerIndex++)
+	{
+		QuestSubsystem->AddProgressEvent(Owners[OwnerIndex], Event, QuestClasses[0]);
+		QuestSubsystem->ApplyCommand(QuestClasses[1], Owners[OwnerIndex], EQuestEnterCommand::ACCEPT);
+	}
+	
+	//Written as INVALID, replaying drops the quest of the snapshot
+	TestTrue(TEXT("Quest released"), QuestSubsystem->ReleaseQuest(QuestClasses[2], Owners[0]));
+	FQuestSaveSnapshot SecondBatch;
+	ExpectReplayed(TEXT("after the second batch"), SecondBatch);
+	TestFalse(TEXT("Released quest replayed"), GetQuests(SecondBatch).Contains(QuestTest::GetOwnerName(0) / QuestClasses[2]->GetPathName()));
+
+	//A failed compaction keeps the journal, the next batch declares its ids again and gets appended
+	AddExpectedError(TEXT("Failed to write the quest snapshot"), EAutomationExpectedErrorFlags::Contains, 0);
+	IFileManager::Get().MakeDirectory(*SnapshotTempPath, true);
+	QuestSubsystem->CompactQuestJournal();
+	UQuestSubsystem::WaitForQuestWrites();
+	IFileManager::Get().DeleteDirectory(*SnapshotTempPath, false, true);
+	TestTrue(TEXT("Journal kept after a failed compaction"), IFileManager::Get().FileSize(*JournalPath) > 0);
+
+	//The only class of the batch takes class id 0, which meant QuestClasses[0] before
+	QuestSubsystem->ApplyCommand(QuestClasses[3], Owners[1], EQuestEnterCommand::ACCEPT);
+	FQuestSaveSnapshot ThirdBatch;
+	ExpectReplayed(TEXT("after the ids got declared again"), ThirdBatch);
+
+	TArray<uint8> Journal;
+	QuestSubsystem->DisableQuestJournal();
+	UQuestSubsystem::WaitForQuestWrites();
+	if (!TestTrue(TEXT("Journal read"), FFileHelper::LoadFileToArray(Journal, *JournalPath))) return false;
+
+	//A crash while appending the last quest entry, the batches before are still recovered
+	const TArray<uint8> TornJournal(Journal.GetData(), Journal.Num() - 1);
+	FFileHelper::SaveArrayToFile(TornJournal, *JournalPath);
+	FQuestSaveSnapshot Recovered;
+	TestTrue(TEXT("Quests recovered with a torn tail"), QuestSubsystem->RecoverQuests(SlotName));
+	QuestSubsystem->CreateSaveSnapshot(Recovered);
+	ExpectSameQuests(TEXT("recovered with a torn tail"), Recovered, SecondBatch);
+
+	FFileHelper::SaveArrayToFile(Journal, *JournalPath);
+	TestTrue(TEXT("Quests recovered"), QuestSubsystem->RecoverQuests(SlotName));
+	QuestSubsystem->CreateSaveSnapshot(Recovered);
+	ExpectSameQuests(TEXT("recovered"), Recovered, ThirdBatch);
+	const UQuestObject* RecoveredQuest = QuestSubsystem->GetQuestObject(QuestClasses[0], Owners[2]);
+	if (TestNotNull(TEXT("Recovered quest"), RecoveredQuest))
+	{
+		TestEqual(TEXT("Progress of a recovered quest"), CastChecked<UQuestTestObjective>(RecoveredQuest->QuestObjectives[0])->Progress, 6);
+	}
+
+	IFileManager::Get().Delete(*SnapshotPath);
+	IFileManager::Get().Delete(*JournalPath);
+	return true;
+}
+
+#endif
@@ -0,0 +1,100 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestBenchmark.h"
+#include "QuestSubsystem.h"
+#include "QuestTestHelpers.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Cost of the per owner quest lookups from 10 to 5,000 quests of one owner. The lookups go through the class index
+ * of the owner, the cost per lookup should stay flat.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQuestLookupBenchmark, "QuestSystem.Benchmark.Lookup",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FQuestLookupBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace QuestBenchmark;
+	constexpr int32 Lookups = 100000;
+	const TCHAR* Lookup = TEXT("Lookup.GetQuestObject");
+
+	TArray<FScenario> Scenarios;
+	for (const int32 NumQuests : {10, 100, 1000, 5000})
+	{
+		FScenario& Scenario = Scenarios.AddDefaulted_GetRef();
+		Scenario.Owners = 1;
+		Scenario.Quests = NumQuests;
+		Scenario.Objectives = 1;
+
+		const TArray<TSubclassOf<UQuestObject>> QuestClasses = QuestTest::GetQuestClasses(NumQuests);
+		QuestTest::SetupQuestClasses(QuestClasses, QuestTest::FClassSetup());
+
+		QuestTest::FQuestTestInstance Instance;
+		UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+		const FString Owner = QuestTest::GetOwnerName(0);
+		for (const TSubclassOf<UQuestObject>& QuestClass : QuestClasses)
+		{
+			QuestTest::AdvanceQuest(QuestSubsystem, QuestClass, Owner, EQuestStatus::ACCEPTED);
+		}
+
+		//Same number of lookups for every size, in an order the cache can't predict
+		TArray<TSubclassOf<UQuestObject>> LookupOrder;
+		LookupOrder.Reserve(Lookups);
+		FRandomStream Random(NumQuests);
+		for (int32 i = 0; i < Lookups; i++)
+		{
+			LookupOrder.Add(QuestClasses[Random.RandHelper(NumQuests)]);
+		}
+
+		for (int32 Repeat = 0; Repeat < GetConfig().Repeats; Repeat++)
+		{
+			int32 Found = 0;
+			Measure(Scenario, Lookup, Lookups, [&]()
+			{
+				for (const TSubclassOf<UQuestObject>& QuestClass : LookupOrder)
+				{
+					Found += QuestSubsystem->GetQuestObject(QuestClass, Owner) != nullptr;
+				}
+			});
+			TestEqual(TEXT("Quest objects found"), Found, Lookups);
+
+			int32 Unlocked = 0;
+			Measure(Scenario, TEXT("Lookup.IsQuestUnlocked"), Lookups, [&]()
+			{
+				for (const TSubclassOf<UQuestObject>& QuestClass : LookupOrder)
+				{
+					Unlocked += QuestSubsystem->IsQuestUnlocked(QuestClass, Owner);
+				}
+			});
+			TestEqual(TEXT("Unlocked quests found"), Unlocked, Lookups);
+
+			int32 Accepted = 0;
+			Measure(Scenario, TEXT("Lookup.GetQuestStatus"), Lookups, [&]()
+			{
+				for (const TSubclassOf<UQuestObject>& QuestClass : LookupOrder)
+				{
+					Accepted += QuestSubsystem->GetQuestStatus(QuestClass, Owner) == EQuestStatus::ACCEPTED;
+				}
+			});
+			TestEqual(TEXT("Accepted quests found"), Accepted, Lookups);
+		}
+
+		WriteResults(*this, Scenario);
+	}
+
+	//Timings are too noisy to fail on, a lookup that scales with the quest count is still off by far more than that
+	const double SmallestNs = Scenarios[0].FindResult(Lookup)->GetMedianNs();
+	const double LargestNs = Scenarios.Last().FindResult(Lookup)->GetMedianNs();
+	if (LargestNs > SmallestNs * 4)
+	{
+		AddWarning(FString::Printf(TEXT("Lookups with %d quests take %.1f ns, %.1fx the %.1f ns with %d quests"), Scenarios.Last().Quests,
+			LargestNs, LargestNs / SmallestNs, SmallestNs, Scenarios[0].Quests));
+	}
+	
+	return true;
+}
+
+#endif
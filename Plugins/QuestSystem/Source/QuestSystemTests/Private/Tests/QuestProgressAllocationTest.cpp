@@ -0,0 +1,110 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestSubsystem.h"
+#include "QuestTestHelpers.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Heap allocations per progress call through the owner handle and through the owner name. Both resolve the owner
+ * without building strings, calls with a progression event don't allocate at all.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQuestProgressAllocationTest, "QuestSystem.Progress.Allocations",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FQuestProgressAllocationTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumQuests = 10;
+	constexpr int32 Calls = 1000;
+
+	const TArray<TSubclassOf<UQuestObject>> QuestClasses = QuestTest::GetQuestClasses(NumQuests);
+	QuestTest::SetupQuestClasses(QuestClasses, QuestTest::FClassSetup());
+
+	QuestTest::FQuestTestInstance Instance;
+	UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+	const FString OwnerName = QuestTest::GetOwnerName(0);
+	const FQuestOwnerHandle Owner = QuestSubsystem->FindOrAddOwnerHandle(OwnerName);
+	for (const TSubclassOf<UQuestObject>& QuestClass : QuestClasses)
+	{
+		TestNotNull(TEXT("Quest in progress"), QuestTest::AdvanceQuest(QuestSubsystem, QuestClass, Owner, EQuestStatus::IN_PROGRESS));
+	}
+
+	FQuestProgressEvent Event;
+	Event.ObjectiveToProgress = UQuestTestObjective::StaticClass();
+	
+	//Quests consume the progression objects, every call needs its own and creating them is not part of the call
+	TArray<UQuestTestProgress*> Progressors;
+	auto CreateProgressors = [&]()
+	{
+		Progressors.Reset(Calls + 1);
+		for (int32 i = 0; i <= Calls; i++)
+		{
+			UQuestTestProgress* Progress = NewObject<UQuestTestProgress>(QuestSubsystem);
+			Progress->ObjectiveToProgress = UQuestTestObjective::StaticClass();
+			Progressors.Add(Progress);
+		}
+	};
+
+	//The first call of every kind may build caches that stay
+	auto CountAllocations = [&](const TCHAR* What, TFunctionRef<void(int32)> Call)
+	{
+		Call(Calls);
+		
+		int64 Allocations = 0;
+		{
+			QuestTest::FScopedAllocationCounter AllocationCounter;
+			for (int32 i = 0; i < Calls; i++)
+			{
+				Call(i);
+			}
+			Allocations = AllocationCounter.GetAllocations();
+		}
+		
+		const double PerCall = double(Allocations) / Calls;
+		AddInfo(FString::Printf(TEXT("%s: %.2f allocations per call"), What, PerCall));
+		return PerCall;
+	};
+
+	CreateProgressors();
+	const double ByHandle = CountAllocations(TEXT("AddProgress by owner handle"), [&](int32 i)
+	{
+		QuestSubsystem->AddProgress(Owner, Progressors[i], QuestClasses[i % NumQuests]);
+	});
+
+	CreateProgressors();
+	const double ByName = CountAllocations(TEXT("AddProgress by owner name"), [&](int32 i)
+	{
+		QuestSubsystem->AddProgress(OwnerName, Progressors[i], QuestClasses[i % NumQuests]);
+	});
+
+	CreateProgressors();
+	CountAllocations(TEXT("AddProgress without quest class"), [&](int32 i)
+	{
+		QuestSubsystem->AddProgress(Owner, Progressors[i], nullptr);
+	});
+
+	const double EventByHandle = CountAllocations(TEXT("AddProgressEvent by owner handle"), [&](int32 i)
+	{
+		QuestSubsystem->AddProgressEvent(Owner, Event, QuestClasses[i % NumQuests]);
+	});
+	
+	const double EventByName = CountAllocations(TEXT("AddProgressEvent by owner name"), [&](int32 i)
+	{
+		QuestSubsystem->AddProgressEvent(OwnerName, Event, QuestClasses[i % NumQuests]);
+	});
+	
+	const double EventWithoutClass = CountAllocations(TEXT("AddProgressEvent without quest class"), [&](int32 i)
+	{
+		QuestSubsystem->AddProgressEvent(Owner, Event, nullptr);
+	});
+
+	TestTrue(TEXT("The owner name costs no allocations over the owner handle"), ByName <= ByHandle);
+	TestEqual(TEXT("Allocations per AddProgressEvent by owner handle"), EventByHandle, 0.0);
+	TestEqual(TEXT("Allocations per AddProgressEvent by owner name"), EventByName, 0.0);
+	TestEqual(TEXT("Allocations per AddProgressEvent without quest class"), EventWithoutClass, 0.0);
+	return true;
+}
+
+#endif
@@ -0,0 +1,94 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestBenchmark.h"
+#include "QuestSubsystem.h"
+#include "QuestTestHelpers.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Throughput of AddProgressBatch against the same events passed one by one to AddProgressEvent,
+ * for batches from a single event up to an area of effect kill and beyond.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQuestProgressBatchBenchmark, "QuestSystem.Benchmark.ProgressBatch",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FQuestProgressBatchBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace QuestBenchmark;
+	constexpr int32 NumQuests = 10;
+	constexpr int32 NumEvents = 40000;
+
+	const TArray<TSubclassOf<UQuestObject>> QuestClasses = QuestTest::GetQuestClasses(NumQuests);
+	QuestTest::SetupQuestClasses(QuestClasses, QuestTest::FClassSetup());
+
+	FQuestProgressEvent Event;
+	Event.ObjectiveToProgress = UQuestTestObjective::StaticClass();
+	TArray<FQuestProgressEvent> Events;
+	Events.Init(Event, NumEvents);
+
+	FScenario Scenario;
+	Scenario.Owners = 1;
+	Scenario.Quests = NumQuests;
+	Scenario.Objectives = 1;
+
+	for (const int32 BatchSize : {1, 8, 40, 200})
+	{
+		const int32 NumBatches = NumEvents / BatchSize;
+		for (int32 Repeat = 0; Repeat < GetConfig().Repeats; Repeat++)
+		{
+			for (const bool bBatched : {false, true})
+			{
+				QuestTest::FQuestTestInstance Instance;
+				UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+				const FQuestOwnerHandle Owner = QuestSubsystem->FindOrAddOwnerHandle(QuestTest::GetOwnerName(0));
+				
+				UQuestTestListener* Listener = NewObject<UQuestTestListener>(QuestSubsystem);
+				TArray<UQuestObject*> Quests;
+				for (const TSubclassOf<UQuestObject>& QuestClass : QuestClasses)
+				{
+					UQuestObject* Quest = QuestTest::AdvanceQuest(QuestSubsystem, QuestClass, Owner, EQuestStatus::IN_PROGRESS);
+					if (!TestNotNull(TEXT("Quest in progress"), Quest)) return false;
+					
+					Quest->OnQuestProgressUpdatedDelegate.AddDynamic(Listener, &UQuestTestListener::OnQuestProgressUpdated);
+					Quests.Add(Quest);
+				}
+
+				const FString Name = FString::Printf(TEXT("%s.%dEvents"), bBatched ? TEXT("AddProgressBatch") : TEXT("AddProgressEvent"), BatchSize);
+				Measure(Scenario, Name, NumEvents, [&]()
+				{
+					for (int32 Batch = 0; Batch < NumBatches; Batch++)
+					{
+						const TConstArrayView<FQuestProgressEvent> BatchEvents(Events.GetData() + Batch * BatchSize, BatchSize);
+						if (bBatched)
+						{
+							QuestSubsystem->AddProgressBatch(Owner, BatchEvents);
+							continue;
+						}
+
+						for (const FQuestProgressEvent& BatchEvent : BatchEvents)
+						{
+							QuestSubsystem->AddProgressEvent(Owner, BatchEvent, nullptr);
+						}
+					}
+				});
+
+				//Every event is consumed by the first quest that can take it, a batch notifies that quest once
+				int64 Progress = 0;
+				for (const UQuestObject* Quest : Quests)
+				{
+					Progress += CastChecked<UQuestTestObjective>(Quest->QuestObjectives[0])->Progress;
+				}
+				TestEqual(*FString::Printf(TEXT("%s progress"), *Name), Progress, int64(NumBatches) * BatchSize);
+				TestEqual(*FString::Printf(TEXT("%s notifications"), *Name), Listener->Calls, bBatched ? NumBatches : NumBatches * BatchSize);
+			}
+		}
+	}
+
+	WriteResults(*this, Scenario);
+	return true;
+}
+
+#endif
@@ -0,0 +1,80 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestSubsystem.h"
+#include "QuestTestHelpers.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * The read only query path over the quests of an owner must not touch the heap.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQuestQueryAllocationTest, "QuestSystem.Storage.QueryAllocations",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FQuestQueryAllocationTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumQuests = 100;
+	constexpr int32 Queries = 1000;
+	
+	const TArray<TSubclassOf<UQuestObject>> QuestClasses = QuestTest::GetQuestClasses(NumQuests);
+	QuestTest::SetupQuestClasses(QuestClasses, QuestTest::FClassSetup());
+
+	QuestTest::FQuestTestInstance Instance;
+	UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+	const FString OwnerName = QuestTest::GetOwnerName(0);
+	const FQuestOwnerHandle Owner = QuestSubsystem->FindOrAddOwnerHandle(OwnerName);
+
+	//Half of the quests have their object, the other half stays records
+	for (int32 i = 0; i < NumQuests; i++)
+	{
+		QuestTest::AdvanceQuest(QuestSubsystem, QuestClasses[i], Owner, i % 2 ? EQuestStatus::UNLOCKED : EQuestStatus::ACCEPTED);
+	}
+
+	int64 Comparators = 0;
+	int64 Accepted = 0;
+	int64 Visited = 0;
+	int64 VisitedByName = 0;
+	int64 Allocations = 0;
+	{
+		QuestTest::FScopedAllocationCounter AllocationCounter;
+		for (int32 i = 0; i < Queries; i++)
+		{
+			for (const FQuestComparator& Comparator : QuestSubsystem->GetQuestComparators(Owner))
+			{
+				Comparators++;
+				Accepted += Comparator.GetStatus() == EQuestStatus::ACCEPTED;
+			}
+			
+			QuestSubsystem->ForEachQuest(Owner, [&Visited](UQuestObject* Quest)
+			{
+				Visited++;
+				return true;
+			});
+			
+			QuestSubsystem->ForEachQuest(OwnerName, [&VisitedByName](UQuestObject* Quest)
+			{
+				VisitedByName++;
+				return true;
+			});
+		}
+		Allocations = AllocationCounter.GetAllocations();
+	}
+
+	TestEqual(TEXT("Heap allocations of GetQuestComparators and ForEachQuest"), Allocations, int64(0));
+	TestEqual(TEXT("Quests in the view"), Comparators, int64(NumQuests) * Queries);
+	TestEqual(TEXT("Accepted quests in the view"), Accepted, int64(NumQuests / 2) * Queries);
+	TestEqual(TEXT("Quest objects visited"), Visited, int64(NumQuests / 2) * Queries);
+	TestEqual(TEXT("Quest objects visited by owner name"), VisitedByName, int64(NumQuests / 2) * Queries);
+
+	int32 VisitedBeforeStop = 0;
+	QuestSubsystem->ForEachQuest(Owner, [&VisitedBeforeStop](UQuestObject* Quest)
+	{
+		return ++VisitedBeforeStop < 2;
+	});
+	TestEqual(TEXT("Quests visited until the visitor stopped"), VisitedBeforeStop, 2);
+	return true;
+}
+
+#endif
@@ -0,0 +1,62 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestSubsystem.h"
+#include "QuestTestHelpers.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Which entry points keep a locked or unlocked quest as record and which ones hand out its object.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQuestRecordTest, "QuestSystem.Storage.Records",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FQuestRecordTest::RunTest(const FString& Parameters)
+{
+	const TArray<TSubclassOf<UQuestObject>> QuestClasses = QuestTest::GetQuestClasses(4);
+	QuestTest::SetupQuestClasses(QuestClasses, QuestTest::FClassSetup());
+
+	QuestTest::FQuestTestInstance Instance;
+	UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+	const FQuestOwnerHandle Owner = QuestSubsystem->FindOrAddOwnerHandle(QuestTest::GetOwnerName(0));
+
+	auto IsRecord = [&](TSubclassOf<UQuestObject> QuestClass)
+	{
+		const FQuestComparator* Comparator = QuestSubsystem->GetQuestComparators(Owner).FindByPredicate([QuestClass](const FQuestComparator& Entry)
+		{
+			return Entry.QuestClass == QuestClass;
+		});
+		return Comparator && Comparator->IsRecord();
+	};
+
+	TestTrue(TEXT("UnlockQuestRecord succeeded"), QuestSubsystem->UnlockQuestRecord(QuestClasses[0], Owner));
+	TestTrue(TEXT("UnlockQuestRecord kept the record"), IsRecord(QuestClasses[0]));
+
+	//The entry points returning the quest object create it
+	const UQuestObject* Unlocked = QuestSubsystem->UnlockQuest(QuestClasses[1], Owner);
+	TestTrue(TEXT("UnlockQuest returned the unlocked object"), Unlocked && Unlocked->GetStatus() == EQuestStatus::UNLOCKED);
+	TestNotNull(TEXT("ApplyCommandToQuest(UNLOCK) returned the object"), QuestSubsystem->ApplyCommandToQuest(QuestClasses[2], Owner, EQuestEnterCommand::UNLOCK));
+	TestNotNull(TEXT("AdvanceQuestTo(UNLOCKED) returned the object"), QuestSubsystem->AdvanceQuestTo(QuestClasses[3], Owner, EQuestStatus::UNLOCKED));
+
+	//Progress for a quest that is not in progress neither creates its object nor counts as change
+	QuestSubsystem->EnableQuestDeltaTracking();
+	const FQuestDeltaVersion Version = QuestSubsystem->GetQuestDeltaVersion(Owner);
+	
+	UQuestTestProgress* Progress = NewObject<UQuestTestProgress>(QuestSubsystem);
+	Progress->ObjectiveToProgress = UQuestTestObjective::StaticClass();
+	QuestSubsystem->AddProgress(Owner, Progress, QuestClasses[0]);
+	
+	FQuestProgressEvent Event;
+	Event.ObjectiveToProgress = UQuestTestObjective::StaticClass();
+	QuestSubsystem->AddProgressEvent(Owner, Event, QuestClasses[0]);
+	QuestSubsystem->AddProgressEvent(Owner, Event, QuestClasses[1]);
+
+	TestTrue(TEXT("Progress kept the record"), IsRecord(QuestClasses[0]));
+	TestTrue(TEXT("Progress for unlocked quests changed nothing"), QuestSubsystem->GetQuestDeltaVersion(Owner) == Version);
+	QuestSubsystem->DisableQuestDeltaTracking();
+	return true;
+}
+
+#endif
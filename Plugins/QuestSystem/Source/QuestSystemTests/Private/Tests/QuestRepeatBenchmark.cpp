@@ -0,0 +1,131 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestBenchmark.h"
+#include "QuestSubsystem.h"
+#include "QuestTestHelpers.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/UObjectArray.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	// Counts every UObject created while in scope
+	class FObjectCreateCounter : public FUObjectArray::FUObjectCreateListener
+	{
+	public:
+		int64 Created = 0;
+		
+		FObjectCreateCounter() { GUObjectArray.AddUObjectCreateListener(this); }
+		virtual ~FObjectCreateCounter() override { GUObjectArray.RemoveUObjectCreateListener(this); }
+
+		virtual void NotifyUObjectCreated(const UObjectBase* Object, int32 Index) override { Created++; }
+		virtual void OnUObjectArrayShutdown() override { GUObjectArray.RemoveUObjectCreateListener(this); }
+	};
+
+	enum class ERepeatMode
+	{
+		// RepeatQuest puts the finished quest back to UNLOCKED
+		Repeat,
+		// The finished quest gets released into the pool and taken out again
+		ReleasePooled,
+		// Without pool every repeat builds a new object graph, like before quests could be repeated
+		ReleaseUnpooled
+	};
+}
+
+/**
+ * Object churn and garbage collection time of repeating one quest 10,000 times.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQuestRepeatBenchmark, "QuestSystem.Benchmark.Repeat",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FQuestRepeatBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace QuestBenchmark;
+	constexpr int32 Repeats = 10000;
+
+	const TArray<TSubclassOf<UQuestObject>> QuestClasses = QuestTest::GetQuestClasses(1);
+	const TSubclassOf<UQuestObject> QuestClass = QuestClasses[0];
+	
+	//One progress event completes the quest
+	QuestTest::FClassSetup Setup;
+	Setup.RequiredProgress = 1;
+	QuestTest::SetupQuestClasses(QuestClasses, Setup);
+
+	FQuestProgressEvent Event;
+	Event.ObjectiveToProgress = UQuestTestObjective::StaticClass();
+
+	FScenario Scenario;
+	Scenario.Owners = 1;
+	Scenario.Quests = 1;
+	Scenario.Objectives = 1;
+
+	for (const ERepeatMode Mode : {ERepeatMode::Repeat, ERepeatMode::ReleasePooled, ERepeatMode::ReleaseUnpooled})
+	{
+		const FString Name = FString::Printf(TEXT("Repeat.%s"), Mode == ERepeatMode::Repeat ? TEXT("RepeatQuest") :
+			Mode == ERepeatMode::ReleasePooled ? TEXT("ReleasePooled") : TEXT("ReleaseUnpooled"));
+		
+		for (int32 Run = 0; Run < GetConfig().Repeats; Run++)
+		{
+			QuestTest::FQuestTestInstance Instance;
+			UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+			QuestSubsystem->MaxPooledQuestsPerClass = Mode == ERepeatMode::ReleaseUnpooled ? 0 : 1;
+			const FQuestOwnerHandle Owner = QuestSubsystem->FindOrAddOwnerHandle(QuestTest::GetOwnerName(0));
+
+			//The first quest object is created before counting, reusing it is what gets measured
+			UQuestObject* FirstQuest = QuestTest::AdvanceQuest(QuestSubsystem, QuestClass, Owner, EQuestStatus::IN_PROGRESS);
+			if (!TestNotNull(TEXT("Quest in progress"), FirstQuest)) return false;
+			
+			int32 Completed = 0;
+			int32 Reused = 0;
+			int64 Created = 0;
+			{
+				FObjectCreateCounter CreateCounter;
+				Measure(Scenario, Name, Repeats, [&]()
+				{
+					for (int32 i = 0; i < Repeats; i++)
+					{
+						QuestSubsystem->AddProgressEvent(Owner, Event, QuestClass);
+						const UQuestObject* Quest = QuestSubsystem->GetQuestObject(QuestClass, Owner);
+						Completed += Quest && Quest->GetStatus() == EQuestStatus::COMPLETED;
+
+						if (Mode == ERepeatMode::Repeat)
+						{
+							QuestSubsystem->RepeatQuest(QuestClass, Owner);
+						}
+						else
+						{
+							QuestSubsystem->ReleaseQuest(QuestClass, Owner);
+						}
+						Reused += QuestTest::AdvanceQuest(QuestSubsystem, QuestClass, Owner, EQuestStatus::IN_PROGRESS) == FirstQuest;
+					}
+				});
+				Created = CreateCounter.Created;
+			}
+
+			TestEqual(*FString::Printf(TEXT("%s completed quests"), *Name), Completed, Repeats);
+			if (Mode == ERepeatMode::ReleaseUnpooled)
+			{
+				TestTrue(*FString::Printf(TEXT("%s creates a quest and its objective per repeat"), *Name), Created >= 2 * Repeats);
+			}
+			else
+			{
+				TestEqual(*FString::Printf(TEXT("%s created objects"), *Name), Created, int64(0));
+				TestEqual(*FString::Printf(TEXT("%s reused the quest object"), *Name), Reused, Repeats);
+			}
+			AddInfo(FString::Printf(TEXT("%s: %lld objects created for %d repeats"), *Name, Created, Repeats));
+
+			Measure(Scenario, Name + TEXT(".CollectGarbage"), 1, [&]()
+			{
+				CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+			});
+		}
+	}
+
+	WriteResults(*this, Scenario);
+	return true;
+}
+
+#endif
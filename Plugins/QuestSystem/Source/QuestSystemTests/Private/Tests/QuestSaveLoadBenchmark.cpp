@@ -0,0 +1,137 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestBenchmark.h"
+#include "QuestSaveData.h"
+#include "QuestSubsystem.h"
+#include "QuestTestHelpers.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Save and load size and time at 1,000 owners with 500 quests each. Most quests are unlocked records,
+ * every tenth quest is in progress with an object and objective progress.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQuestSaveLoadBenchmark, "QuestSystem.Benchmark.SaveLoad",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FQuestSaveLoadBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace QuestBenchmark;
+	constexpr int32 NumOwners = 1000;
+	constexpr int32 QuestsPerOwner = 500;
+	constexpr int32 InProgressEvery = 10;
+
+	const TArray<TSubclassOf<UQuestObject>> QuestClasses = QuestTest::GetQuestClasses(QuestsPerOwner);
+	QuestTest::SetupQuestClasses(QuestClasses, QuestTest::FClassSetup());
+
+	FScenario Scenario;
+	Scenario.Owners = NumOwners;
+	Scenario.Quests = QuestsPerOwner;
+	Scenario.Objectives = 1;
+	const int64 NumQuests = int64(NumOwners) * QuestsPerOwner;
+
+	QuestTest::FQuestTestInstance Instance;
+	UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+	TArray<FQuestOwnerHandle> Owners;
+	QuestTest::AddOwners(QuestSubsystem, NumOwners, Owners);
+
+	FQuestProgressEvent Event;
+	Event.ObjectiveToProgress = UQuestTestObjective::StaticClass();
+	for (int32 OwnerIndex = 0; OwnerIndex < NumOwners; OwnerIndex++)
+	{
+		for (const TSubclassOf<UQuestObject>& QuestClass : QuestClasses)
+		{
+			QuestSubsystem->ApplyCommand(QuestClass, Owners[OwnerIndex], EQuestEnterCommand::UNLOCK);
+		}
+		
+		for (int32 QuestIndex = 0; QuestIndex < QuestsPerOwner; QuestIndex += InProgressEvery)
+		{
+			QuestTest::AdvanceQuest(QuestSubsystem, QuestClasses[QuestIndex], Owners[OwnerIndex], EQuestStatus::IN_PROGRESS);
+			Event.Amount = OwnerIndex + QuestIndex;
+			QuestSubsystem->AddProgressEvent(Owners[OwnerIndex], Event, QuestClasses[QuestIndex]);
+		}
+	}
+
+	//Statuses of every quest and the progress of the quests in progress, compared after every load
+	auto Check = [&](const TCHAR* What)
+	{
+		int64 WrongStatus = 0;
+		int64 WrongProgress = 0;
+		for (int32 OwnerIndex = 0; OwnerIndex < NumOwners; OwnerIndex++)
+		{
+			for (int32 QuestIndex = 0; QuestIndex < QuestsPerOwner; QuestIndex++)
+			{
+				const bool bInProgress = QuestIndex % InProgressEvery == 0;
+				const EQuestStatus Status = QuestSubsystem->GetQuestStatus(QuestClasses[QuestIndex], Owners[OwnerIndex]);
+				if (Status != (bInProgress ? EQuestStatus::IN_PROGRESS : EQuestStatus::UNLOCKED))
+				{
+					WrongStatus++;
+					continue;
+				}
+				if (!bInProgress) continue;
+
+				const UQuestObject* Quest = QuestSubsystem->GetQuestObject(QuestClasses[QuestIndex], Owners[OwnerIndex]);
+				if (!Quest || CastChecked<UQuestTestObjective>(Quest->QuestObjectives[0])->Progress != OwnerIndex + QuestIndex) WrongProgress++;
+			}
+		}
+		TestEqual(*FString::Printf(TEXT("Quests with the wrong status %s"), What), WrongStatus, int64(0));
+		TestEqual(*FString::Printf(TEXT("Quests with the wrong progress %s"), What), WrongProgress, int64(0));
+	};
+	Check(TEXT("before saving"));
+
+	const FString FilePath = UQuestSubsystem::GetQuestSaveFilePath(TEXT("QuestSaveLoadBenchmark"));
+	for (int32 Repeat = 0; Repeat < GetConfig().Repeats; Repeat++)
+	{
+		//The part of an asynchronous save that runs on the game thread
+		FQuestSaveSnapshot Snapshot;
+		Measure(Scenario, TEXT("SaveLoad.CreateSaveSnapshot"), NumQuests, [&]()
+		{
+			QuestSubsystem->CreateSaveSnapshot(Snapshot);
+		});
+
+		TArray<uint8> Data;
+		bool bSaved = false;
+		Measure(Scenario, TEXT("SaveLoad.SaveQuestsToMemory"), NumQuests, [&]()
+		{
+			bSaved = QuestSubsystem->SaveQuestsToMemory(Data);
+		});
+		TestTrue(TEXT("Quests saved to memory"), bSaved);
+		Scenario.FindOrAddResult(TEXT("SaveLoad.SaveQuestsToMemory"), NumQuests).Bytes = Data.Num();
+
+		bool bLoaded = false;
+		Measure(Scenario, TEXT("SaveLoad.LoadQuestsFromMemory"), NumQuests, [&]()
+		{
+			bLoaded = QuestSubsystem->LoadQuestsFromMemory(Data);
+		});
+		TestTrue(TEXT("Quests loaded from memory"), bLoaded);
+		Check(TEXT("after loading from memory"));
+
+		bSaved = false;
+		Measure(Scenario, TEXT("SaveLoad.SaveQuestsToFileAsync"), NumQuests, [&]()
+		{
+			bSaved = QuestSubsystem->SaveQuestsToFileAsync(FilePath).Get();
+		});
+		TestTrue(TEXT("Quests saved to file"), bSaved);
+		Scenario.FindOrAddResult(TEXT("SaveLoad.SaveQuestsToFileAsync"), NumQuests).Bytes = IFileManager::Get().FileSize(*FilePath);
+
+		bLoaded = false;
+		Measure(Scenario, TEXT("SaveLoad.LoadQuestsFromFile"), NumQuests, [&]()
+		{
+			bLoaded = QuestSubsystem->LoadQuestsFromFile(FilePath);
+		});
+		TestTrue(TEXT("Quests loaded from file"), bLoaded);
+		Check(TEXT("after loading from file"));
+
+		Instance.Tick();
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+	
+	IFileManager::Get().Delete(*FilePath);
+	WriteResults(*this, Scenario);
+	return true;
+}
+
+#endif
@@ -0,0 +1,660 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestBenchmark.h"
+#include "QuestDelta.h"
+#include "QuestMappedSnapshot.h"
+#include "QuestNativeDispatch.h"
+#include "QuestSubsystem.h"
+#include "QuestTestHelpers.h"
+#include "QuestTransitions.h"
+#include "Algo/Count.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/ArchiveCountMem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace QuestBenchmark
+{
+	const TCHAR* SnapshotSlot = TEXT("QuestBenchmark");
+
+	// Quests of every owner and class in the order the scenario visits them
+	struct FQuestSet
+	{
+		TConstArrayView<FQuestOwnerHandle> Owners;
+		TConstArrayView<TSubclassOf<UQuestObject>> QuestClasses;
+
+		int64 Num() const { return int64(Owners.Num()) * QuestClasses.Num(); }
+
+		template <typename FunctionType>
+		void ForEach(FunctionType&& Function) const
+		{
+			for (const FQuestOwnerHandle& Owner : Owners)
+			{
+				for (const TSubclassOf<UQuestObject>& QuestClass : QuestClasses)
+				{
+					Function(QuestClass, Owner);
+				}
+			}
+		}
+	};
+
+	void GetQuestStatuses(const UQuestSubsystem* QuestSubsystem, const FQuestSet& QuestSet, TArray<EQuestStatus>& OutStatuses)
+	{
+		OutStatuses.Reset(QuestSet.Num());
+		QuestSet.ForEach([&](TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner)
+		{
+			OutStatuses.Add(QuestSubsystem->GetQuestStatus(QuestClass, Owner));
+		});
+	}
+
+	int64 CountQuestsNotIn(const UQuestSubsystem* QuestSubsystem, const FQuestSet& QuestSet, EQuestStatus Status)
+	{
+		int64 Count = 0;
+		QuestSet.ForEach([&](TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner)
+		{
+			if (QuestSubsystem->GetQuestStatus(QuestClass, Owner) != Status) Count++;
+		});
+		return Count;
+	}
+
+	int64 SumObjectiveProgress(TConstArrayView<UQuestObject*> Quests)
+	{
+		int64 Progress = 0;
+		for (const UQuestObject* Quest : Quests)
+		{
+			for (const UQuestObjective* Objective : Quest->QuestObjectives)
+			{
+				if (const UQuestTestObjective* TestObjective = Cast<UQuestTestObjective>(Objective)) Progress += TestObjective->Progress;
+			}
+		}
+		return Progress;
+	}
+
+	int64 SumRewardClaims(TConstArrayView<TSubclassOf<UQuestObject>> QuestClasses)
+	{
+		int64 Claims = 0;
+		for (const TSubclassOf<UQuestObject>& QuestClass : QuestClasses)
+		{
+			if (const UQuestTestReward* Reward = QuestTest::GetQuestReward(QuestClass)) Claims += Reward->ClaimCount;
+		}
+		return Claims;
+	}
+
+	// Memory of the quests split by what holds it, shared rewards and definitions are counted once
+	struct FQuestMemory
+	{
+		int64 Quests = 0;
+		int64 Objectives = 0;
+		int64 Rewards = 0;
+		int64 Definitions = 0;
+
+		int64 Total() const { return Quests + Objectives + Rewards + Definitions; }
+	};
+	
+	FQuestMemory CountQuestMemory(TConstArrayView<UQuestObject*> Quests)
+	{
+		TSet<const UObject*> Counted;
+		auto Count = [&Counted](UObject* Object, int64& Bytes)
+		{
+			bool bAlreadyCounted = false;
+			if (!Object) return;
+			Counted.Add(Object, &bAlreadyCounted);
+			if (bAlreadyCounted) return;
+
+			FArchiveCountMem CountMem(Object);
+			Bytes += Object->GetClass()->GetStructureSize() + CountMem.GetMax();
+		};
+
+		FQuestMemory Memory;
+		TSet<const FQuestDefinition*> CountedDefinitions;
+		for (UQuestObject* Quest : Quests)
+		{
+			Count(Quest, Memory.Quests);
+			for (UQuestReward* Reward : Quest->GetQuestRewards())
+			{
+				Count(Reward, Memory.Rewards);
+			}
+			
+			for (UQuestObjective* Objective : Quest->QuestObjectives)
+			{
+				Count(Objective, Memory.Objectives);
+				if (!Objective) continue;
+				for (UQuestReward* Reward : Objective->GetObjectiveRewards())
+				{
+					Count(Reward, Memory.Rewards);
+				}
+			}
+
+			bool bAlreadyCounted = false;
+			const FQuestDefinition* Definition = Quest->GetDefinition();
+			if (!Definition) continue;
+			CountedDefinitions.Add(Definition, &bAlreadyCounted);
+			if (!bAlreadyCounted) Memory.Definitions += sizeof(FQuestDefinition) + Definition->GetAllocatedSize();
+		}
+
+		return Memory;
+	}
+
+	void MeasureQuestMemory(FAutomationTestBase& Test, FScenario& Scenario, TConstArrayView<TSubclassOf<UQuestObject>> QuestClasses)
+	{
+		FQuestMemory Memory[2];
+		for (const bool bShareRewards : {true, false})
+		{
+			//Objectives with a reward of their own, so they have design data to share as well
+			QuestTest::FClassSetup Setup;
+			Setup.Objectives = Scenario.Objectives;
+			Setup.bObjectiveRewards = true;
+			Setup.bShareRewards = bShareRewards;
+			QuestTest::SetupQuestClasses(QuestClasses, Setup);
+
+			QuestTest::FQuestTestInstance Instance;
+			UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+			TArray<FQuestOwnerHandle> Owners;
+			QuestTest::AddOwners(QuestSubsystem, Scenario.Owners, Owners);
+			
+			TArray<UQuestObject*> Quests;
+			FQuestSet{Owners, QuestClasses}.ForEach([&](TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner)
+			{
+				if (UQuestObject* Quest = QuestSubsystem->AdvanceQuestTo(QuestClass, Owner, EQuestStatus::ACCEPTED)) Quests.Add(Quest);
+			});
+			Test.TestEqual(TEXT("Accepted quests for the memory measurement"), Quests.Num(), Owners.Num() * QuestClasses.Num());
+
+			const FQuestMemory& QuestMemory = Memory[bShareRewards] = CountQuestMemory(Quests);
+			const FString Name = bShareRewards ? TEXT("QuestMemory.SharedRewards") : TEXT("QuestMemory.InstancedRewards");
+			Scenario.FindOrAddResult(Name, Quests.Num()).Bytes = QuestMemory.Total();
+			Scenario.FindOrAddResult(Name + TEXT(".Quests"), Quests.Num()).Bytes = QuestMemory.Quests;
+			Scenario.FindOrAddResult(Name + TEXT(".Objectives"), int64(Quests.Num()) * Scenario.Objectives).Bytes = QuestMemory.Objectives;
+			Scenario.FindOrAddResult(Name + TEXT(".Rewards"), Quests.Num()).Bytes = QuestMemory.Rewards;
+			Scenario.FindOrAddResult(Name + TEXT(".Definitions"), QuestClasses.Num()).Bytes = QuestMemory.Definitions;
+		}
+		
+		Test.TestTrue(TEXT("Shared rewards take less memory than instanced rewards"), Memory[true].Total() < Memory[false].Total());
+		Test.TestTrue(TEXT("Shared rewards are not instanced for every owner"), Memory[true].Rewards < Memory[false].Rewards);
+	}
+
+	// Unlocking the quest set for every owner by name, one call per quest against one call for all of them
+	void MeasureBulkUnlock(FAutomationTestBase& Test, FScenario& Scenario, TConstArrayView<TSubclassOf<UQuestObject>> QuestClasses)
+	{
+		TArray<FString> OwnerNames;
+		for (int32 i = 0; i < Scenario.Owners; i++)
+		{
+			OwnerNames.Add(QuestTest::GetOwnerName(i));
+		}
+		const int64 NumQuests = int64(OwnerNames.Num()) * QuestClasses.Num();
+
+		{
+			QuestTest::FQuestTestInstance Instance;
+			UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+			int64 Unlocked = 0;
+			Measure(Scenario, TEXT("ApplyCommand.Unlock"), NumQuests, [&]()
+			{
+				for (const FString& Owner : OwnerNames)
+				{
+					for (const TSubclassOf<UQuestObject>& QuestClass : QuestClasses)
+					{
+						Unlocked += QuestSubsystem->ApplyCommand(QuestClass, Owner, EQuestEnterCommand::UNLOCK);
+					}
+				}
+			});
+			Test.TestEqual(TEXT("Quests unlocked one by one"), Unlocked, NumQuests);
+		}
+
+		{
+			QuestTest::FQuestTestInstance Instance;
+			UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+			TArray<FQuestCommandResult> Results;
+			Measure(Scenario, TEXT("ApplyCommandToQuests.Unlock"), NumQuests, [&]()
+			{
+				Results = QuestSubsystem->ApplyCommandToQuests(TArray<TSubclassOf<UQuestObject>>(QuestClasses.GetData(), QuestClasses.Num()), OwnerNames, EQuestEnterCommand::UNLOCK);
+			});
+			
+			const int32 Unlocked = Algo::CountIf(Results, [](const FQuestCommandResult& Result) { return Result.bSuccess && Result.Status == EQuestStatus::UNLOCKED; });
+			Test.TestEqual(TEXT("Quests unlocked in bulk"), int64(Unlocked), NumQuests);
+		}
+	}
+
+	void RunScenario(FAutomationTestBase& Test, FScenario& Scenario, TConstArrayView<TSubclassOf<UQuestObject>> QuestClasses, bool bGeneratedClasses)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(QuestBenchmark::RunScenario)
+
+		QuestTest::FQuestTestInstance Instance;
+		UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+		TArray<FQuestOwnerHandle> Owners;
+		QuestTest::AddOwners(QuestSubsystem, Scenario.Owners, Owners);
+		
+		const FQuestSet QuestSet{Owners, QuestClasses};
+		const int64 NumQuests = QuestSet.Num();
+
+		//Quests of the game may refuse commands, their statuses are only compared against the subsystem
+		auto ExpectStatus = [&](const TCHAR* What, EQuestStatus Status)
+		{
+			if (bGeneratedClasses) Test.TestEqual(What, CountQuestsNotIn(QuestSubsystem, QuestSet, Status), int64(0));
+		};
+		
+		Measure(Scenario, TEXT("ApplyCommand.Unlock"), NumQuests, [&]()
+		{
+			QuestSet.ForEach([&](TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner)
+			{
+				QuestSubsystem->ApplyCommand(QuestClass, Owner, EQuestEnterCommand::UNLOCK);
+			});
+		});
+		ExpectStatus(TEXT("Quests not unlocked"), EQuestStatus::UNLOCKED);
+
+		const TPair<const TCHAR*, EQuestEnterCommand> Commands[] = {
+			{TEXT("ApplyCommandToQuest.Accept"), EQuestEnterCommand::ACCEPT},
+			{TEXT("ApplyCommandToQuest.Initialize"), EQuestEnterCommand::INITIALIZE},
+			{TEXT("ApplyCommandToQuest.Start"), EQuestEnterCommand::START}
+		};
+		EQuestStatus ExpectedStatus = EQuestStatus::UNLOCKED;
+		for (const TPair<const TCHAR*, EQuestEnterCommand>& Command : Commands)
+		{
+			Measure(Scenario, Command.Key, NumQuests, [&]()
+			{
+				QuestSet.ForEach([&](TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner)
+				{
+					QuestSubsystem->ApplyCommandToQuest(QuestClass, Owner, Command.Value);
+				});
+			});
+
+			ExpectedStatus = QuestTransitions::GetTarget(ExpectedStatus, Command.Value);
+			ExpectStatus(*FString::Printf(TEXT("Quests not in %s after %s"), *UEnum::GetValueAsString(ExpectedStatus), Command.Key), ExpectedStatus);
+		}
+
+		TArray<UQuestObject*> Quests;
+		Quests.Reserve(NumQuests);
+		Measure(Scenario, TEXT("GetQuestObject"), NumQuests, [&]()
+		{
+			QuestSet.ForEach([&](TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner)
+			{
+				if (UQuestObject* Quest = QuestSubsystem->GetQuestObject(QuestClass, Owner)) Quests.Add(Quest);
+			});
+		});
+		Test.TestEqual(TEXT("Quest objects found"), int64(Quests.Num()), NumQuests);
+
+		Measure(Scenario, TEXT("Tick"), 1, [&]()
+		{
+			Instance.Tick();
+		});
+
+		//Per call cost of the BlueprintNativeEvents through ProcessEvent, dispatched natively and with a blueprint override
+		{
+			TArray<TPair<UQuestObjective*, UQuestObject*>> Objectives;
+			for (UQuestObject* Quest : Quests)
+			{
+				for (UQuestObjective* Objective : Quest->QuestObjectives)
+				{
+					if (Objective) Objectives.Emplace(Objective, Quest);
+				}
+			}
+
+			Measure(Scenario, TEXT("NativeEvent.ProcessEvent"), Objectives.Num(), [&]()
+			{
+				for (const TPair<UQuestObjective*, UQuestObject*>& Objective : Objectives)
+				{
+					Objective.Key->TickObjective(Objective.Value, 0.f);
+				}
+			});
+
+			Measure(Scenario, TEXT("NativeEvent.Dispatched"), Objectives.Num(), [&]()
+			{
+				for (const TPair<UQuestObjective*, UQuestObject*>& Objective : Objectives)
+				{
+					QUEST_NATIVE_EVENT(Objective.Key, TickObjective, Objective.Value, 0.f);
+				}
+			});
+
+			//The progress events, every call runs the progress itself as well
+			FQuestProgressEvent Event;
+			Event.ObjectiveToProgress = UQuestTestObjective::StaticClass();
+			Measure(Scenario, TEXT("NativeEvent.ProgressQuestEvent.ProcessEvent"), Quests.Num(), [&]()
+			{
+				for (UQuestObject* Quest : Quests)
+				{
+					Quest->ProgressQuestEvent(Event);
+				}
+			});
+
+			Measure(Scenario, TEXT("NativeEvent.ProgressQuestEvent.Dispatched"), Quests.Num(), [&]()
+			{
+				for (UQuestObject* Quest : Quests)
+				{
+					QUEST_NATIVE_EVENT(Quest, ProgressQuestEvent, Event);
+				}
+			});
+
+			bool bConsumed = false;
+			Measure(Scenario, TEXT("NativeEvent.AddProgressEvent.ProcessEvent"), Objectives.Num(), [&]()
+			{
+				for (const TPair<UQuestObjective*, UQuestObject*>& Objective : Objectives)
+				{
+					bConsumed = false;
+					Objective.Key->AddProgressEvent(Event, bConsumed);
+				}
+			});
+
+			Measure(Scenario, TEXT("NativeEvent.AddProgressEvent.Dispatched"), Objectives.Num(), [&]()
+			{
+				for (const TPair<UQuestObjective*, UQuestObject*>& Objective : Objectives)
+				{
+					bConsumed = false;
+					QUEST_NATIVE_EVENT(Objective.Key, AddProgressEvent, Event, bConsumed);
+				}
+			});
+
+			//A blueprint override can't be skipped, the dispatch falls back to ProcessEvent running the script
+			UQuestObject* OverrideQuest = NewObject<UQuestObject>(QuestSubsystem, QuestTest::GetScriptOverrideQuestClass());
+			Test.TestFalse(TEXT("Script override dispatched natively"), QuestNativeDispatch::IsNative(OverrideQuest, EQuestNativeEvent::ProgressQuestEvent));
+			Measure(Scenario, TEXT("NativeEvent.ProgressQuestEvent.ScriptFallback"), Quests.Num(), [&]()
+			{
+				for (int32 i = 0; i < Quests.Num(); i++)
+				{
+					QUEST_NATIVE_EVENT(OverrideQuest, ProgressQuestEvent, Event);
+				}
+			});
+		}
+
+		Measure(Scenario, TEXT("GetQuestStatus"), NumQuests, [&]()
+		{
+			QuestSet.ForEach([&](TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner)
+			{
+				QuestSubsystem->GetQuestStatus(QuestClass, Owner);
+			});
+		});
+
+		int64 OwnersFound = 0;
+		Measure(Scenario, TEXT("GetQuestOwner"), NumQuests, [&]()
+		{
+			for (int64 i = 0; i < NumQuests; i++)
+			{
+				OwnersFound += !QuestSubsystem->GetQuestOwner(QuestClasses[i % QuestClasses.Num()]).IsEmpty();
+			}
+		});
+		Test.TestEqual(TEXT("Quest owners found"), OwnersFound, NumQuests);
+
+		//Quests consume the progression objects, every call needs its own
+		TArray<UQuestTestProgress*> Progressors;
+		const int64 ProgressBefore = SumObjectiveProgress(Quests);
+		for (const bool bWithQuestClass : {true, false})
+		{
+			Progressors.Reset(NumQuests);
+			for (int64 i = 0; i < NumQuests; i++)
+			{
+				UQuestTestProgress* Progress = NewObject<UQuestTestProgress>(QuestSubsystem);
+				Progress->ObjectiveToProgress = UQuestTestObjective::StaticClass();
+				Progressors.Add(Progress);
+			}
+			
+			int32 ProgressIndex = 0;
+			Measure(Scenario, bWithQuestClass ? TEXT("AddProgress.QuestClass") : TEXT("AddProgress.Routed"), NumQuests, [&]()
+			{
+				QuestSet.ForEach([&](TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner)
+				{
+					QuestSubsystem->AddProgress(Owner, Progressors[ProgressIndex++], bWithQuestClass ? QuestClass : nullptr);
+				});
+			});
+
+			FQuestProgressEvent Event;
+			Event.ObjectiveToProgress = UQuestTestObjective::StaticClass();
+			Measure(Scenario, bWithQuestClass ? TEXT("AddProgressEvent.QuestClass") : TEXT("AddProgressEvent.Routed"), NumQuests, [&]()
+			{
+				QuestSet.ForEach([&](TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner)
+				{
+					QuestSubsystem->AddProgressEvent(Owner, Event, bWithQuestClass ? QuestClass : nullptr);
+				});
+			});
+		}
+		
+		//Every call is consumed by exactly one objective
+		if (bGeneratedClasses)
+		{
+			Test.TestEqual(TEXT("Progress received by the objectives"), SumObjectiveProgress(Quests) - ProgressBefore, 4 * NumQuests);
+		}
+
+		//Objectives are still pending, this measures the check every progress runs
+		Measure(Scenario, TEXT("TryFinishQuest.Pending"), NumQuests, [&]()
+		{
+			for (UQuestObject* Quest : Quests)
+			{
+				Quest->TryFinishQuest();
+			}
+		});
+		ExpectStatus(TEXT("Quests finished with pending objectives"), EQuestStatus::IN_PROGRESS);
+
+		for (UQuestObject* Quest : Quests)
+		{
+			for (UQuestObjective* Objective : Quest->QuestObjectives)
+			{
+				if (Objective) Objective->ForceStatus(EQuestStatus::COMPLETED);
+			}
+		}
+		
+		Measure(Scenario, TEXT("TryFinishQuest.Completed"), NumQuests, [&]()
+		{
+			for (UQuestObject* Quest : Quests)
+			{
+				Quest->TryFinishQuest();
+			}
+		});
+		ExpectStatus(TEXT("Quests not completed"), EQuestStatus::COMPLETED);
+
+		const int64 ClaimsBefore = SumRewardClaims(QuestClasses);
+		Measure(Scenario, TEXT("ClaimRewards"), NumQuests, [&]()
+		{
+			for (UQuestObject* Quest : Quests)
+			{
+				Quest->ClaimRewards();
+			}
+		});
+		if (bGeneratedClasses)
+		{
+			Test.TestEqual(TEXT("Claimed shared rewards"), SumRewardClaims(QuestClasses) - ClaimsBefore, NumQuests);
+			Test.TestNull(TEXT("Shared reward still points to the last claiming quest"), QuestTest::GetQuestReward(QuestClasses[0])->OwningQuest);
+		}
+
+		TArray<EQuestStatus> Statuses;
+		GetQuestStatuses(QuestSubsystem, QuestSet, Statuses);
+
+		//Full state for every owner, serialized, read back and applied like a client would
+		{
+			QuestSubsystem->EnableQuestDeltaTracking();
+			FQuestDeltaMirror Mirror;
+			int64 DeltaBytes = 0;
+			int32 Applied = 0;
+			Measure(Scenario, TEXT("QuestDelta.RoundTrip"), Owners.Num(), [&]()
+			{
+				TArray<uint8> Data;
+				for (const FQuestOwnerHandle& Owner : Owners)
+				{
+					FQuestDelta Delta;
+					if (!QuestSubsystem->CreateQuestDelta(Owner, Mirror.GetVersion(QuestSubsystem->GetOwnerName(Owner)), Delta)) continue;
+
+					Data.Reset();
+					Delta.ToBytes(Data);
+					DeltaBytes += Data.Num();
+
+					FQuestDelta ReceivedDelta;
+					if (ReceivedDelta.FromBytes(Data) && Mirror.Apply(ReceivedDelta) == EQuestDeltaResult::Applied) Applied++;
+				}
+			});
+			Scenario.FindOrAddResult(TEXT("QuestDelta.RoundTrip"), Owners.Num()).Bytes = DeltaBytes;
+			Test.TestEqual(TEXT("Deltas applied by the mirror"), Applied, Owners.Num());
+
+			int64 Mismatches = 0;
+			int32 Index = 0;
+			QuestSet.ForEach([&](TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner)
+			{
+				if (Mirror.GetQuestStatus(QuestSubsystem->GetOwnerName(Owner), QuestClass) != Statuses[Index++]) Mismatches++;
+			});
+			Test.TestEqual(TEXT("Mirrored quest statuses that differ"), Mismatches, int64(0));
+			QuestSubsystem->DisableQuestDeltaTracking();
+		}
+
+		const int64 SavedProgress = SumObjectiveProgress(Quests);
+		TArray<uint8> SaveData;
+		bool bSaved = false;
+		Measure(Scenario, TEXT("SaveQuestsToMemory"), 1, [&]()
+		{
+			bSaved = QuestSubsystem->SaveQuestsToMemory(SaveData);
+		});
+		Scenario.FindOrAddResult(TEXT("SaveQuestsToMemory"), 1).Bytes = SaveData.Num();
+		Test.TestTrue(TEXT("Quests saved to memory"), bSaved);
+
+		bool bLoaded = false;
+		Measure(Scenario, TEXT("LoadQuestsFromMemory"), 1, [&]()
+		{
+			bLoaded = QuestSubsystem->LoadQuestsFromMemory(SaveData);
+		});
+		Test.TestTrue(TEXT("Quests loaded from memory"), bLoaded);
+
+		TArray<EQuestStatus> LoadedStatuses;
+		GetQuestStatuses(QuestSubsystem, QuestSet, LoadedStatuses);
+		Test.TestTrue(TEXT("Loaded quest statuses match the saved ones"), LoadedStatuses == Statuses);
+		if (bGeneratedClasses)
+		{
+			TArray<UQuestObject*> LoadedQuests;
+			QuestSet.ForEach([&](TSubclassOf<UQuestObject> QuestClass, FQuestOwnerHandle Owner)
+			{
+				if (UQuestObject* Quest = QuestSubsystem->GetQuestObject(QuestClass, Owner)) LoadedQuests.Add(Quest);
+			});
+			Test.TestEqual(TEXT("Loaded objective progress"), SumObjectiveProgress(LoadedQuests), SavedProgress);
+		}
+		Instance.Tick();
+
+		FQuestSaveSnapshot Snapshot;
+		QuestSubsystem->CreateSaveSnapshot(Snapshot);
+		TArray<uint8> SnapshotData;
+		FQuestMappedSnapshot::Write(Snapshot, SnapshotData);
+		const FString SnapshotPath = UQuestSubsystem::GetQuestSnapshotFilePath(SnapshotSlot);
+		if (Test.TestTrue(TEXT("Mapped snapshot written"), FFileHelper::SaveArrayToFile(SnapshotData, *SnapshotPath)))
+		{
+			bool bMounted = false;
+			Measure(Scenario, TEXT("MountQuestSnapshot"), 1, [&]()
+			{
+				bMounted = QuestSubsystem->MountQuestSnapshot(SnapshotSlot);
+			});
+			Scenario.FindOrAddResult(TEXT("MountQuestSnapshot"), 1).Bytes = SnapshotData.Num();
+			Test.TestTrue(TEXT("Mapped snapshot mounted"), bMounted);
+
+			TArray<EQuestStatus> MappedStatuses;
+			Measure(Scenario, TEXT("GetQuestStatus.Mapped"), NumQuests, [&]()
+			{
+				GetQuestStatuses(QuestSubsystem, QuestSet, MappedStatuses);
+			});
+			Test.TestTrue(TEXT("Mapped quest statuses match the saved ones"), MappedStatuses == Statuses);
+			Instance.Tick();
+		}
+		
+		QuestSubsystem->ClearQuests();
+		IFileManager::Get().Delete(*SnapshotPath);
+
+		//Baseline for loading and mounting, a cold game instance bringing every quest into progress through the commands
+		{
+			QuestTest::FQuestTestInstance ColdInstance;
+			UQuestSubsystem* ColdSubsystem = ColdInstance.GetSubsystem();
+			constexpr EQuestEnterCommand StartupCommands[] = {
+				EQuestEnterCommand::UNLOCK, EQuestEnterCommand::ACCEPT, EQuestEnterCommand::INITIALIZE, EQuestEnterCommand::START
+			};
+			
+			Measure(Scenario, TEXT("RebuildQuestsByCommands"), 1, [&]()
+			{
+				for (int32 OwnerIndex = 0; OwnerIndex < Owners.Num(); OwnerIndex++)
+				{
+					const FQuestOwnerHandle ColdOwner = ColdSubsystem->FindOrAddOwnerHandle(QuestTest::GetOwnerName(OwnerIndex));
+					for (const TSubclassOf<UQuestObject>& QuestClass : QuestClasses)
+					{
+						for (const EQuestEnterCommand Command : StartupCommands)
+						{
+							ColdSubsystem->ApplyCommand(QuestClass, ColdOwner, Command);
+						}
+					}
+				}
+			});
+
+			if (bGeneratedClasses)
+			{
+				TArray<FQuestOwnerHandle> ColdOwners;
+				for (int32 OwnerIndex = 0; OwnerIndex < Owners.Num(); OwnerIndex++)
+				{
+					ColdOwners.Add(ColdSubsystem->FindOwnerHandle(QuestTest::GetOwnerName(OwnerIndex)));
+				}
+				Test.TestEqual(TEXT("Rebuilt quests not in progress"), CountQuestsNotIn(ColdSubsystem, FQuestSet{ColdOwners, QuestClasses}, EQuestStatus::IN_PROGRESS), int64(0));
+			}
+		}
+	}
+}
+
+/**
+ * Every scenario of the quest subsystem benchmark, see QuestBenchmark.h for the options.
+ */
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FQuestSubsystemBenchmark, "QuestSystem.Benchmark",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+void FQuestSubsystemBenchmark::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	const QuestBenchmark::FConfig& Config = QuestBenchmark::GetConfig();
+	for (const int32 Owners : Config.OwnerCounts)
+	{
+		for (const int32 Quests : Config.QuestsPerOwner)
+		{
+			for (const int32 Objectives : Config.ObjectivesPerQuest)
+			{
+				OutBeautifiedNames.Add(FString::Printf(TEXT("%d Owners %d Quests %d Objectives"), Owners, Quests, Objectives));
+				OutTestCommands.Add(FString::Printf(TEXT("Owners=%d Quests=%d Objectives=%d"), Owners, Quests, Objectives));
+			}
+		}
+	}
+}
+
+bool FQuestSubsystemBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace QuestBenchmark;
+	const FConfig& Config = GetConfig();
+
+	FScenario Scenario;
+	FParse::Value(*Parameters, TEXT("Owners="), Scenario.Owners);
+	FParse::Value(*Parameters, TEXT("Quests="), Scenario.Quests);
+	FParse::Value(*Parameters, TEXT("Objectives="), Scenario.Objectives);
+	Scenario.Owners = FMath::Max(Scenario.Owners, 1);
+	Scenario.Quests = FMath::Max(Scenario.Quests, 1);
+
+	const bool bGeneratedClasses = Config.QuestClasses.Num() == 0;
+	TArray<TSubclassOf<UQuestObject>> QuestClasses;
+	if (bGeneratedClasses)
+	{
+		//Quests need an objective to take progress and stay in progress
+		Scenario.Objectives = FMath::Max(Scenario.Objectives, 1);
+		QuestClasses = QuestTest::GetQuestClasses(Scenario.Quests);
+	}
+	else
+	{
+		QuestClasses.Append(Config.QuestClasses.GetData(), FMath::Min(Scenario.Quests, Config.QuestClasses.Num()));
+	}
+
+	for (int32 Repeat = 0; Repeat < Config.Repeats; Repeat++)
+	{
+		if (bGeneratedClasses)
+		{
+			QuestTest::FClassSetup Setup;
+			Setup.Objectives = Scenario.Objectives;
+			QuestTest::SetupQuestClasses(QuestClasses, Setup);
+		}
+		
+		RunScenario(*this, Scenario, QuestClasses, bGeneratedClasses);
+		MeasureBulkUnlock(*this, Scenario, QuestClasses);
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	if (bGeneratedClasses)
+	{
+		MeasureQuestMemory(*this, Scenario, QuestClasses);
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	WriteResults(*this, Scenario);
+	return true;
+}
+
+#endif
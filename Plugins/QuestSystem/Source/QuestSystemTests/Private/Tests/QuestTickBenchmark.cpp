@@ -0,0 +1,131 @@
+﻿// Protected under GPL-3.0 License
+
+
+#include "QuestBenchmark.h"
+#include "QuestSubsystem.h"
+#include "QuestTestHelpers.h"
+#include "Algo/Count.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Ticking 10,000 quests in progress with one ticking objective each. The tick manager of the subsystem calls the
+ * objectives directly, against the dynamic OnQuestTickDelegate broadcast every quest did on its own before,
+ * with the objective bound to it.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQuestTickBenchmark, "QuestSystem.Benchmark.Tick",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FQuestTickBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace QuestBenchmark;
+	constexpr int32 NumOwners = 100;
+	constexpr int32 QuestsPerOwner = 100;
+	constexpr int32 Frames = 60;
+	constexpr float DeltaTime = 1.f / 60.f;
+
+	const TArray<TSubclassOf<UQuestObject>> QuestClasses = QuestTest::GetQuestClasses(QuestsPerOwner);
+	QuestTest::FClassSetup Setup;
+	Setup.ObjectiveClass = UQuestTestTickingObjective::StaticClass();
+	QuestTest::SetupQuestClasses(QuestClasses, Setup);
+
+	FScenario Scenario;
+	Scenario.Owners = NumOwners;
+	Scenario.Quests = QuestsPerOwner;
+	Scenario.Objectives = 1;
+
+	QuestTest::FQuestTestInstance Instance;
+	UQuestSubsystem* QuestSubsystem = Instance.GetSubsystem();
+	TArray<FQuestOwnerHandle> Owners;
+	QuestTest::AddOwners(QuestSubsystem, NumOwners, Owners);
+
+	TArray<UQuestObject*> Quests;
+	TArray<UQuestTestObjective*> Objectives;
+	for (const FQuestOwnerHandle& Owner : Owners)
+	{
+		for (const TSubclassOf<UQuestObject>& QuestClass : QuestClasses)
+		{
+			UQuestObject* Quest = QuestTest::AdvanceQuest(QuestSubsystem, QuestClass, Owner, EQuestStatus::IN_PROGRESS);
+			if (!TestNotNull(TEXT("Quest in progress"), Quest)) return false;
+			
+			Quests.Add(Quest);
+			Objectives.Add(CastChecked<UQuestTestObjective>(Quest->QuestObjectives[0]));
+		}
+	}
+
+	auto ExpectTicks = [&](const TCHAR* What, int32 ExpectedTicks)
+	{
+		const int32 Mismatches = Algo::CountIf(Objectives, [ExpectedTicks](const UQuestTestObjective* Objective) { return Objective->NumTicks != ExpectedTicks; });
+		TestEqual(*FString::Printf(TEXT("Objectives with the wrong tick count after %s"), What), Mismatches, 0);
+		for (UQuestTestObjective* Objective : Objectives)
+		{
+			Objective->NumTicks = 0;
+		}
+	};
+
+	for (int32 Repeat = 0; Repeat < GetConfig().Repeats; Repeat++)
+	{
+		Measure(Scenario, TEXT("Tick.TickManager"), int64(Frames) * Objectives.Num(), [&]()
+		{
+			for (int32 Frame = 0; Frame < Frames; Frame++)
+			{
+				Instance.Tick(DeltaTime);
+			}
+		});
+		ExpectTicks(TEXT("the tick manager"), Frames);
+
+		for (int32 i = 0; i < Quests.Num(); i++)
+		{
+			Quests[i]->OnQuestTickDelegate.AddDynamic(Objectives[i], &UQuestObjective::TickObjective);
+		}
+		
+		Measure(Scenario, TEXT("Tick.DynamicBroadcast"), int64(Frames) * Objectives.Num(), [&]()
+		{
+			for (int32 Frame = 0; Frame < Frames; Frame++)
+			{
+				for (UQuestObject* Quest : Quests)
+				{
+					Quest->OnQuestTickDelegate.Broadcast(Quest, DeltaTime);
+				}
+			}
+		});
+		ExpectTicks(TEXT("the dynamic broadcast"), Frames);
+
+		for (int32 i = 0; i < Quests.Num(); i++)
+		{
+			Quests[i]->OnQuestTickDelegate.RemoveDynamic(Objectives[i], &UQuestObjective::TickObjective);
+		}
+	}
+
+	//Finished objectives leave the tick manager
+	for (UQuestTestObjective* Objective : Objectives)
+	{
+		Objective->ForceStatus(EQuestStatus::COMPLETED);
+	}
+	Measure(Scenario, TEXT("Tick.TickManager.Finished"), Frames, [&]()
+	{
+		for (int32 Frame = 0; Frame < Frames; Frame++)
+		{
+			Instance.Tick(DeltaTime);
+		}
+	});
+	ExpectTicks(TEXT("the objectives finished"), 0);
+
+	//Bound before starting, QuestTick keeps running for quests with a ticking objective like before the tick manager
+	const FQuestOwnerHandle ListeningOwner = QuestSubsystem->FindOrAddOwnerHandle(QuestTest::GetOwnerName(NumOwners));
+	UQuestObject* ListenedQuest = QuestTest::AdvanceQuest(QuestSubsystem, QuestClasses[0], ListeningOwner, EQuestStatus::STARTING);
+	if (TestNotNull(TEXT("Quest starting"), ListenedQuest))
+	{
+		UQuestTestListener* Listener = NewObject<UQuestTestListener>(QuestSubsystem);
+		ListenedQuest->OnQuestTickDelegate.AddDynamic(Listener, &UQuestTestListener::OnQuestTick);
+		QuestSubsystem->ApplyCommand(QuestClasses[0], ListeningOwner, EQuestEnterCommand::START);
+		Instance.Tick(DeltaTime);
+		TestEqual(TEXT("QuestTick calls with a bound OnQuestTickDelegate"), Listener->Calls, 1);
+	}
+
+	WriteResults(*this, Scenario);
+	return true;
+}
+
+#endif